@@ -1,13 +1,12 @@
 #include <Dwin2.h>
+#include <DwinKernels.h>
+#include <DwinTrace.h>
+#include <DwinLatency.h>
+#include <DwinTimeline.h>
 
 // Define static variables
-HardwareSerial* DWIN2::_uart = nullptr;
-SemaphoreHandle_t DWIN2::_uartMutex;
-SemaphoreHandle_t DWIN2::_bufferMutex;
+dwinbus_t* DWIN2::_buses[DWIN_MAX_BUSES] = {};
 bool DWIN2::_isBlink = false;
-std::vector<uint8_t> DWIN2::_uartCmdBuffer;
-std::vector<uint8_t> DWIN2::_uartRxBuf;
-String DWIN2::_dwinEcho;
 
 //***********************************************************************************************************************
 //************* DWIN2 main class ****************************************************************************************
@@ -16,50 +15,47 @@ DWIN2::DWIN2()
 {
     _isBlink = false;
     _blinkPeriod = 500000;
-    _dwinEcho.reserve(BUFSIZE);
-    _uartCmdBuffer.reserve(BUFSIZE); 
-    _uartRxBuf.reserve(BUFSIZE);
 }
 
 DWIN2::~DWIN2()
 {
-    if (_taskHandleUart)
+    // The bus and its task stay for the other objects
+    if (_bus && (dwinLock(_bus->bufferMutex)))
     {
-        vTaskDelete(_taskHandleUart);
+        DWIN2 **end = _bus->clients + _bus->clientCount;
+        DWIN2 **it = std::find(_bus->clients, end, this);
+        if (it != end)
+        {
+            std::copy(it + 1, end, it);
+            _bus->clientCount--;
+        }
+        dwinUnlock(_bus->bufferMutex);
     }
 }
 
-void DWIN2::begin(const uint16_t &spHexAddr, const uint16_t &vpHexAddr, const uint8_t &rxPin, const uint8_t &txPin)
+void DWIN2::begin(const uint16_t &spHexAddr, const uint16_t &vpHexAddr, const uint8_t &rxPin, const uint8_t &txPin, const uint8_t &serialNum)
 {
     _spHexAddr = spHexAddr;
     _vpHexAddr = vpHexAddr;
 
-    // UART initialization
-    _uart = new HardwareSerial(HW_SERIAL_NUM);
-    if (_uart) _uart->begin(115200, SERIAL_8N1, rxPin, txPin);
-
-    // Task for listening to uart
-    // Create semaphore for the message about sending command via UART
-    _uartWriteSem = xSemaphoreCreateCounting(4, 0);
-
-    // Creating mutexes
-    _uartMutex = xSemaphoreCreateMutex();
-    _bufferMutex = xSemaphoreCreateMutex();
-
-    // Semaphore for control of receiving data into the _uartBuf array
-    _uartUiReadSem = xSemaphoreCreateCounting(1, 0);
-
-    // Create task for UART
-    xTaskCreatePinnedToCore(
-        this->uartTask,          
-        "DwinUartTask",          
-        2048,                      
-        this,                     
-        1,                  
-        &_taskHandleUart,      
-        0                 
-    );
+    // UART and the task are started by the first object on the port
+    dwinbus_t *bus = getBus(serialNum);
+    if ((bus == nullptr) || !startBus(bus, rxPin, txPin))
+    {
+        Serial.printf("ID%d ERR begin() serial port %d not started\n", _id, serialNum);
+        return;
+    }
+    _bus = bus;
+    if (dwinLock(_bus->bufferMutex))
+    {
+        if (_bus->clientCount < DWIN_MAX_CLIENTS) _bus->clients[_bus->clientCount++] = this;
+        else Serial.printf("ID%d ERR begin() more than %d objects on the port, no echo\n", _id, DWIN_MAX_CLIENTS);
+        dwinUnlock(_bus->bufferMutex);
+    }
+    // Upload handler set before begin()
+    if (upload_cb != NULL) setUploadHandler(upload_cb);
 
+#ifndef DWIN_NO_RTOS
     // Timer configuration for blinking
     esp_timer_create_args_t timerConfig;
     timerConfig.arg = this;
@@ -67,6 +63,190 @@ void DWIN2::begin(const uint16_t &spHexAddr, const uint16_t &vpHexAddr, const ui
     timerConfig.dispatch_method = ESP_TIMER_TASK;
     timerConfig.name = "encTimer";
     esp_timer_create(&timerConfig, &_blinkTimerHandle);
+#endif
+}
+
+void DWIN2::begin(const dwinelem_t &elem, const uint8_t &rxPin, const uint8_t &txPin, const uint8_t &serialNum)
+{
+    begin(elem.sp, elem.vp, rxPin, txPin, serialNum);
+    _uitype = elem.type;
+}
+
+dwinbus_t *DWIN2::getBus(const uint8_t &serialNum)
+{
+    if (serialNum >= DWIN_MAX_BUSES) return nullptr;
+    if (_buses[serialNum] == nullptr)
+    {
+        dwinbus_t *bus = new dwinbus_t();
+        bus->serialNum = serialNum;
+        bus->transport = nullptr;
+        bus->started = false;
+        bus->txPos = 0;
+        bus->groupStart = 0;
+        bus->pendingFrames = 0;
+        bus->receivedFrames = 0;
+        bus->frameStart = 0;
+        bus->rxTimeMs = 0;
+        for (size_t i = 0; i < DWIN_RTT_CLASSES; i++)
+        {
+            bus->rtt[i].srttUs = 0;
+            bus->rtt[i].rttvarUs = 0;
+            bus->rtt[i].timeoutMs = DWIN_RX_TIMEOUT_MS;
+            bus->rtt[i].samples = 0;
+            bus->rtt[i].timeouts = 0;
+        }
+        bus->pipelineDepth = DWIN_PIPELINE_DEPTH;
+        bus->groupClass = DWIN_RTT_WRITE;
+        bus->groupFull = false;
+        bus->groupTimeoutMs = DWIN_RX_TIMEOUT_MS;
+        bus->answerUs = 0;
+        bus->maxGapUs = 0;
+        bus->groupTxUs = 0;
+        bus->answerTxPos = 0;
+        bus->lateAnswers = false;
+        bus->core = 0;
+        bus->priority = 1;
+        bus->queuedFrames = 0;
+        bus->doneFrames = 0;
+        bus->lostFrames = 0;
+        bus->clientCount = 0;
+        bus->mirrorCount = 0;
+        bus->trace = nullptr;
+        bus->asyncReads = nullptr;
+        bus->uploadOn = false;
+        bus->lostUploads = 0;
+        bus->latency = nullptr;
+        bus->timeline = nullptr;
+        bus->queueUs = 0;
+        bus->txDoneUs = 0;
+#ifndef DWIN_NO_HEAP
+        bus->shadowOn = false;
+        bus->shadowPage = -1;
+        bus->shadowRangeQty = 0;
+#endif
+#ifndef DWIN_NO_RTOS
+        bus->taskHandle = nullptr;
+        bus->rxIdle = false;
+        // Creating mutexes
+        bus->uartMutex = xSemaphoreCreateMutex();
+        bus->bufferMutex = xSemaphoreCreateMutex();
+        // Create semaphore for the message about sending command via UART
+        bus->writeSem = xSemaphoreCreateCounting(4, 0);
+        // Semaphore for the message about the free buffer
+        bus->freeSem = xSemaphoreCreateBinary();
+        // Semaphore for control of receiving data into the rxBuf array
+        bus->readSem = xSemaphoreCreateCounting(1, 0);
+#else
+        bus->readReady = false;
+#endif
+        _buses[serialNum] = bus;
+    }
+    return _buses[serialNum];
+}
+
+bool DWIN2::startBus(dwinbus_t *bus, const uint8_t &rxPin, const uint8_t &txPin)
+{
+    if (bus->started) return true;
+
+#ifndef DWIN_LINUX
+    // ESP32 UART of the same number, unless another transport is set
+    if (bus->transport == nullptr) bus->transport = new DwinEspUart(bus->serialNum);
+#endif
+    if ((bus->transport == nullptr) || !bus->transport->begin(rxPin, txPin)) return false;
+    bus->started = true;
+
+#ifndef DWIN_NO_RTOS
+    // Create task for UART
+    char taskName[16];
+    snprintf(taskName, sizeof(taskName), "DwinUartTask%d", bus->serialNum);
+    xTaskCreatePinnedToCore(
+        uartTask,
+        taskName,
+        2048,
+        bus,
+        bus->priority,
+        &bus->taskHandle,
+        bus->core
+    );
+    return bus->taskHandle != nullptr;
+#else
+    return true;
+#endif
+}
+
+void DWIN2::setBusTask(const uint8_t &serialNum, const uint8_t &core, const uint8_t &priority)
+{
+    dwinbus_t *bus = getBus(serialNum);
+    if (bus == nullptr) return;
+    if (bus->started)
+    {
+        Serial.printf("ERR setBusTask() serial port %d already started\n", serialNum);
+        return;
+    }
+    bus->core = core;
+    bus->priority = priority;
+}
+
+bool DWIN2::setTransport(const uint8_t &serialNum, DwinTransport *transport)
+{
+    dwinbus_t *bus = getBus(serialNum);
+    if (bus == nullptr) return false;
+    if (bus->started)
+    {
+        Serial.printf("ERR setTransport() serial port %d already started\n", serialNum);
+        return false;
+    }
+    bus->transport = transport;
+    return true;
+}
+
+bool DWIN2::addMirror(const uint8_t &serialNum, const uint8_t &rxPin, const uint8_t &txPin)
+{
+    dwinbus_t *mirror = getBus(serialNum);
+    if ((_bus == nullptr) || (mirror == nullptr) || (mirror == _bus) || !startBus(mirror, rxPin, txPin))
+    {
+        Serial.printf("ID%d ERR addMirror() serial port %d not started\n", _id, serialNum);
+        return false;
+    }
+    if (dwinLock(_bus->bufferMutex))
+    {
+        if (std::find(_bus->mirrors, _bus->mirrors + _bus->mirrorCount, mirror) == _bus->mirrors + _bus->mirrorCount)
+        {
+            _bus->mirrors[_bus->mirrorCount++] = mirror;
+        }
+        dwinUnlock(_bus->bufferMutex);
+    }
+    return true;
+}
+
+uint8_t DWIN2::getSerialNum()
+{
+    return _bus ? _bus->serialNum : HW_SERIAL_NUM;
+}
+
+void DWIN2::setElement(const dwinelem_t &elem)
+{
+    _spHexAddr = elem.sp;
+    _vpHexAddr = elem.vp;
+    _uitype = elem.type;
+}
+
+void DWIN2::setDecimals(const uint8_t &decimals)
+{
+    // int32 holds 9 decimal digits
+    _decimals = std::min<uint8_t>(decimals, 9);
+}
+
+int32_t DWIN2::toFixed(const double &val)
+{
+    double fixed = val;
+    for (uint8_t i = 0; i < _decimals; i++) fixed *= 10.0;
+    // Saturate to the range of the VP
+    const double maxVal = (_uitype == INT) ? 32767.0 : 2147483647.0;
+    const double minVal = (_uitype == INT) ? -32768.0 : -2147483648.0;
+    if (fixed > maxVal) fixed = maxVal;
+    if (fixed < minVal) fixed = minVal;
+    return static_cast<int32_t>(lround(fixed));
 }
 
 void DWIN2::setId(const uint8_t &id)
@@ -94,10 +274,10 @@ void DWIN2::setLimits(const uint32_t &minVal, const uint32_t &maxVal, const bool
 
 void DWIN2::setLimits(const bool &loopRotation)
 {
-    if (_listStrVal.size() > 0)
+    if (listSize() > 0)
     {
         _minVal = 0;
-        _maxVal = _listStrVal.size()-1;
+        _maxVal = listSize()-1;
         _loopRotation = loopRotation;
     }
     else{
@@ -113,15 +293,18 @@ void DWIN2::setStartVal(const double &currentVal)
     switch (_uitype)
     {
     case INT:
-        sendData(currIntVal);
+    case LONG:
+        if (_decimals > 0) sendData(_currentVal);
+        else sendData(currIntVal);
         break;
     case DOUBLE:
+    case FLOAT:
         sendData(_currentVal);
         break;
     case ASCII:
-        if (_listStrVal.size() > currIntVal)
+        if ((currIntVal >= 0) && (listSize() > static_cast<size_t>(currIntVal)))
         {
-            sendData(_listStrVal.at(currIntVal).c_str());
+            sendData(listItem(currIntVal));
         }
         else
         {
@@ -129,9 +312,9 @@ void DWIN2::setStartVal(const double &currentVal)
         }
         break;
     case UTF:
-        if (_listStrVal.size() > currIntVal)
+        if ((currIntVal >= 0) && (listSize() > static_cast<size_t>(currIntVal)))
         {
-            sendData(_listStrVal.at(currIntVal).c_str());
+            sendData(listItem(currIntVal));
         }
         else
         {
@@ -146,15 +329,54 @@ void DWIN2::setStartVal(const double &currentVal)
     
 }
 
+#ifndef DWIN_NO_HEAP
 void DWIN2::setStrListVal(const std::vector<String> listStrVal)
 {
     _listStrVal.assign(listStrVal.begin(), listStrVal.end());
+    _listStr = nullptr;
+    _listStrCount = 0;
+}
+#endif
+
+void DWIN2::setStrListVal(const char *const *listStr, const size_t &count)
+{
+#ifndef DWIN_NO_HEAP
+    _listStrVal.clear();
+#endif
+    _listStr = listStr;
+    _listStrCount = count;
+}
+
+size_t DWIN2::listSize()
+{
+    if (_listStr != nullptr) return _listStrCount;
+#ifndef DWIN_NO_HEAP
+    return _listStrVal.size();
+#else
+    return 0;
+#endif
+}
+
+const char *DWIN2::listItem(const size_t &index)
+{
+    if (_listStr != nullptr) return _listStr[index];
+#ifndef DWIN_NO_HEAP
+    return _listStrVal.at(index).c_str();
+#else
+    return "";
+#endif
 }
 
 void DWIN2::setBlinkPeriod(const uint64_t &blinkPeriodMs)
 {
     _blinkPeriod = blinkPeriodMs*1000;
     // Restart timer
+    startBlinkTimer();
+}
+
+void DWIN2::startBlinkTimer()
+{
+#ifndef DWIN_NO_RTOS
     // Check if timer already running
     if (esp_timer_is_active(_blinkTimerHandle))
     {
@@ -162,6 +384,28 @@ void DWIN2::setBlinkPeriod(const uint64_t &blinkPeriodMs)
     }
     // Start timer
     esp_timer_start_periodic(_blinkTimerHandle, _blinkPeriod);
+#else
+    _blinkTimerOn = true;
+    _blinkTimeMs = millis();
+#endif
+}
+
+void DWIN2::stopBlinkTimer()
+{
+#ifndef DWIN_NO_RTOS
+    if (esp_timer_is_active(_blinkTimerHandle))
+    {
+        esp_timer_stop(_blinkTimerHandle);
+        // Enable display, in case the UI element was hidden
+        if (!_isBlink) showUi();
+    }
+#else
+    if (_blinkTimerOn)
+    {
+        _blinkTimerOn = false;
+        if (!_isBlink) showUi();
+    }
+#endif
 }
 
 void DWIN2::setUartCbHandler(CallbackFunction f)
@@ -185,12 +429,17 @@ void DWIN2::setColor(uint16_t colorHex)
     command[7] = lowByte(colorHex);
     
     // Send data to uartTask
-    sendUart(command, commandLen);
+    sendElementCmd(command, commandLen);
 }
 
 void DWIN2::setColor(uicolor_t color)
 {
-    uint16_t colorHex;
+    setColor(colorHex(color));
+}
+
+uint16_t DWIN2::colorHex(const uicolor_t &color)
+{
+    uint16_t colorHex = 0xFFFF;
     switch (color)
     {
     case 0:
@@ -248,22 +497,12 @@ void DWIN2::setColor(uicolor_t color)
     default:
         break;
     }
-
-    const uint8_t commandLen = 8;
-    uint8_t command[commandLen] = {0x5A, 0xA5, 0x05, 0x82, 0x00, 0x00, 0x00, 0x00};
-    uint16_t spColorAddr = _spHexAddr + 0x03;   // SP is offset by 3 bits
-    command[4] = highByte(spColorAddr);
-    command[5] = lowByte(spColorAddr);
-    command[6] = highByte(colorHex);
-    command[7] = lowByte(colorHex);
-    
-    // Send data to uartTask
-    sendUart(command, commandLen);
+    return colorHex;
 }
 
 String DWIN2::getDwinEcho()
 {
-    return _dwinEcho;
+    return _bus ? _bus->echo : String();
 }
 
 void DWIN2::blink(const bool &isBlink)
@@ -271,164 +510,432 @@ void DWIN2::blink(const bool &isBlink)
     _isBlink = isBlink;
     if (_isBlink)
     {
-        if (esp_timer_is_active(_blinkTimerHandle))
-        {
-            esp_timer_stop(_blinkTimerHandle);
-        }
-        esp_timer_start_periodic(_blinkTimerHandle, _blinkPeriod);
+        startBlinkTimer();
     }
     else
     {
         // clear rx buffer
         clearRxBuf();
-        if (esp_timer_is_active(_blinkTimerHandle))
+        stopBlinkTimer();
+    }
+}
+
+void DWIN2::sendUart(const uint8_t * command, const size_t &cmdLength)
+{
+    // Batch larger than the buffer, queue it in parts split on the frame boundaries
+    if (cmdLength > DWIN_TXBUFSIZE)
+    {
+        size_t start = 0;
+        size_t pos = 0;
+        while ((pos + 3 <= cmdLength) && (pos + command[pos+2] + 3 <= cmdLength))
+        {
+            const size_t frameLen = command[pos+2] + 3;
+            if ((pos + frameLen - start > DWIN_TXBUFSIZE) && (pos > start))
+            {
+                sendUart(&command[start], pos - start);
+                start = pos;
+            }
+            pos += frameLen;
+        }
+        if (pos > start) sendUart(&command[start], pos - start);
+        return;
+    }
+
+    if (_bus == nullptr)
+    {
+        Serial.printf("ID%d ERR sendUart() begin() was not called\n", _id);
+        return;
+    }
+    queueBus(_bus, command, cmdLength);
+    // The same frames go to the mirrored displays
+    for (uint8_t i = 0; i < _bus->mirrorCount; i++) queueBus(_bus->mirrors[i], command, cmdLength);
+}
+
+void DWIN2::queueBus(dwinbus_t *bus, const uint8_t *command, const size_t &cmdLength)
+{
+    const uint32_t startUs = micros();
+    while (true)
+    {
+        // Block access to the buffer during copying
+        if (dwinLock(bus->bufferMutex))
+        {
+            // Wait for uartTask to free the buffer, if the command does not fit
+            if ((bus->cmdBuffer.size() + cmdLength > DWIN_TXBUFSIZE) && (bus->cmdBuffer.size() > 0))
+            {
+#ifndef DWIN_NO_RTOS
+                xSemaphoreTake(bus->freeSem, 0);
+                dwinUnlock(bus->bufferMutex);
+                xSemaphoreTake(bus->freeSem, portMAX_DELAY);
+#else
+                pollBus(bus);
+#endif
+                continue;
+            }
+            // Copy data from command to buffer
+            bus->cmdBuffer.append(command, cmdLength);
+            // The queue wait starts with the first command
+            if (bus->cmdBuffer.size() == cmdLength) bus->queueUs = micros();
+            // Count the queued frames for flush()
+            uint32_t frames = 0;
+            for (size_t pos = 0; pos + 3 <= cmdLength; pos += command[pos+2] + 3) frames++;
+            bus->queuedFrames = bus->queuedFrames + frames;
+#ifndef DWIN_NO_HEAP
+            if (bus->shadowOn) updateShadow(bus, command, cmdLength);
+#endif
+            // Before the bus task can send it
+            if (bus->latency) bus->latency->queued(command, cmdLength, uint32_t(bus->queuedFrames));
+#ifndef DWIN_NO_RTOS
+            // Send the command to uartTask
+            xSemaphoreGive(bus->writeSem);
+            if (bus->rxIdle) bus->transport->wakeRx();
+#endif
+            // Giving access
+            dwinUnlock(bus->bufferMutex);
+        }
+        if (bus->timeline) bus->timeline->span(TL_ENQUEUE, bus->serialNum, startUs, cmdLength);
+        return;
+    }
+}
+
+#ifndef DWIN_NO_HEAP
+void DWIN2::updateShadow(dwinbus_t *bus, const uint8_t *command, const size_t &cmdLength)
+{
+    size_t pos = 0;
+    while ((pos + 6 <= cmdLength) && (pos + command[pos+2] + 3 <= cmdLength))
+    {
+        const size_t frameLen = command[pos+2] + 3;
+        const uint16_t vp = (command[pos+4] << 8) | command[pos+5];
+        if (command[pos+3] == 0x82)
+        {
+            const uint8_t *data = &command[pos+6];
+            const size_t dataLen = frameLen - 6;
+            if (vp >= DWIN_SHADOW_MIN_VP)
+            {
+                for (size_t i = 0; i < dataLen/2; i++)
+                {
+                    if (isShadowed(bus, vp + i)) bus->shadow[vp + i] = (data[i*2] << 8) | data[i*2 + 1];
+                }
+                // Odd length (ASCII text): only the high byte of the last word is written
+                if ((dataLen % 2 != 0) && isShadowed(bus, vp + dataLen/2))
+                {
+                    uint16_t &word = bus->shadow[vp + dataLen/2];
+                    word = (data[dataLen-1] << 8) | (word & 0x00FF);
+                }
+            }
+            // Page switch: 0x5A 0x01 page
+            else if ((vp == DWIN_PAGE_VP) && (dataLen == 4) && (data[0] == 0x5A) && (data[1] == 0x01))
+            {
+                bus->shadowPage = (data[2] << 8) | data[3];
+            }
+        }
+        pos += frameLen;
+    }
+}
+
+bool DWIN2::isShadowed(const dwinbus_t *bus, const uint16_t &vp)
+{
+    bool kept = false;
+    bool anyKept = false;
+    for (uint8_t i = 0; i < bus->shadowRangeQty; i++)
+    {
+        const dwinshadowrange_t &range = bus->shadowRanges[i];
+        const bool inRange = (vp >= range.vp) && (uint32_t(vp) < uint32_t(range.vp) + range.count);
+        if (inRange && range.exclude) return false;
+        if (!range.exclude)
         {
-            esp_timer_stop(_blinkTimerHandle);
-            // Enable display, in case the UI element was hidden
-            if (!_isBlink) showUi();
+            anyKept = true;
+            kept = kept || inRange;
         }
     }
+    if (!anyKept) kept = (vp >= DWIN_SHADOW_MIN_VP) && (vp <= DWIN_SHADOW_MAX_VP);
+    return kept;
 }
 
-void DWIN2::sendUart(const uint8_t * command, const uint8_t &cmdLength)
+bool DWIN2::setShadowRange(const uint16_t &vp, const uint16_t &count, const bool &exclude)
 {
-    // Block access to the buffer during copying
-    if (xSemaphoreTake(_bufferMutex, portMAX_DELAY) == pdTRUE)
+    if (_bus == nullptr)
+    {
+        Serial.printf("ID%d ERR shadow range: begin() was not called\n", _id);
+        return false;
+    }
+    bool ok = true;
+    if (dwinLock(_bus->bufferMutex))
     {
-        // Copy data from command to buffer
-        for (int i = 0; i < cmdLength; i++)
+        bool found = false;
+        for (uint8_t i = 0; i < _bus->shadowRangeQty; i++)
         {
-            _uartCmdBuffer.push_back(command[i]);
+            const dwinshadowrange_t &range = _bus->shadowRanges[i];
+            found = found || ((range.vp == vp) && (range.count == count) && (range.exclude == exclude));
         }
-        // Send the command to uartTask
-        xSemaphoreGive(_uartWriteSem);
-        // Giving access
-        xSemaphoreGive(_bufferMutex);
+        if (!found && (_bus->shadowRangeQty >= DWIN_SHADOW_RANGES))
+        {
+            Serial.printf("ID%d ERR shadow range table is full, %d ranges\n", _id, DWIN_SHADOW_RANGES);
+            ok = false;
+        }
+        else if (!found)
+        {
+            _bus->shadowRanges[_bus->shadowRangeQty++] = {vp, count, exclude};
+            // Words recorded before, which are not kept now
+            for (auto it = _bus->shadow.begin(); it != _bus->shadow.end();)
+            {
+                if (isShadowed(_bus, it->first)) ++it;
+                else it = _bus->shadow.erase(it);
+            }
+        }
+        dwinUnlock(_bus->bufferMutex);
     }
+    return ok;
+}
+
+bool DWIN2::addShadowRange(const uint16_t &vp, const uint16_t &count)
+{
+    return setShadowRange(vp, count, false);
+}
+
+bool DWIN2::excludeShadowRange(const uint16_t &vp, const uint16_t &count)
+{
+    return setShadowRange(vp, count, true);
+}
+
+void DWIN2::setShadow(const bool &enable)
+{
+    if (_bus == nullptr) return;
+    if (dwinLock(_bus->bufferMutex))
+    {
+        _bus->shadowOn = enable;
+        if (!enable)
+        {
+            _bus->shadow.clear();
+            _bus->shadowPage = -1;
+        }
+        dwinUnlock(_bus->bufferMutex);
+    }
+}
+
+size_t DWIN2::resync()
+{
+    if (_bus == nullptr) return 0;
+    // Copy the state, the writes below update the shadow with the same values
+    std::vector<std::pair<uint16_t, uint16_t>> words;
+    int16_t page = -1;
+    if (dwinLock(_bus->bufferMutex))
+    {
+        words.assign(_bus->shadow.begin(), _bus->shadow.end());
+        page = _bus->shadowPage;
+        dwinUnlock(_bus->bufferMutex);
+    }
+    if (page >= 0) setPage(page);
+
+    // Adjacent VPs go in one frame
+    uint16_t block[DWIN_MAX_BLOCK_WORDS];
+    size_t i = 0;
+    while (i < words.size())
+    {
+        const uint16_t vp = words[i].first;
+        size_t count = 0;
+        while ((i < words.size()) && (count < DWIN_MAX_BLOCK_WORDS) && (words[i].first == vp + count))
+        {
+            block[count++] = words[i++].second;
+        }
+        writeBlock(vp, block, count);
+    }
+    return words.size();
+}
+#endif
+
+bool DWIN2::readWord(const uint16_t &vpHexAddr, uint16_t &data, const uint32_t &timeoutMs)
+{
+    const uint8_t commandLen = 7;
+    if (_bus == nullptr) return false;
+    uint8_t command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, highByte(vpHexAddr), lowByte(vpHexAddr), 0x01};
+    // Reset the signal left from previous commands
+    waitRead(_bus, 0);
+    sendUart(command, commandLen);
+
+    const uint32_t startMs = millis();
+    while (millis() - startMs < timeoutMs)
+    {
+        if (!waitRead(_bus, timeoutMs - (millis() - startMs))) break;
+        size_t received = 0;
+        if (dwinLock(_bus->uartMutex))
+        {
+            received = hexBufBlockProcessing(_bus->rxBuf, vpHexAddr, &data, 1);
+            dwinUnlock(_bus->uartMutex);
+        }
+        if (received > 0) return true;
+    }
+    return false;
+}
+
+bool DWIN2::waitReady(const uint32_t &timeoutMs)
+{
+    const uint32_t startMs = millis();
+    uint16_t page;
+    // The display answers when its firmware is running, no fixed delays
+    while (millis() - startMs < timeoutMs)
+    {
+        if (readWord(0x0014, page, 50)) return true;
+    }
+    return false;
 }
 
 void DWIN2::sendData(const int &data)
 {
+    if (_uitype == LONG)
+    {
+        sendVpLong(_vpHexAddr, data);
+        return;
+    }
     if (_uitype != INT) 
     {
-        Serial.printf("ID%d ERR sendData() wrong ui type, should be INT\n", _id);
+        Serial.printf("ID%d ERR sendData() wrong ui type, should be INT or LONG\n", _id);
         return;
     }
-    const uint8_t commandLen = 8;
-    uint8_t command[commandLen] = {0x5A, 0xA5, 0x05, 0x82, 0x00, 0x00, 0x00, 0x00};
-    command[4] = highByte(_vpHexAddr);
-    command[5] = lowByte(_vpHexAddr);
-    command[6] = highByte(data);
-    command[7] = lowByte(data);
-    sendUart(command, commandLen);
+    sendVpWord(_vpHexAddr, data);
 }
 
 void DWIN2::sendData(const double &data)
 {
-    if (_uitype != DOUBLE) 
+    switch (_uitype)
     {
-        Serial.printf("ID%d ERR sendData() wrong ui type, should be DOUBLE\n", _id);
+    case DOUBLE:
+        sendVpDouble(_vpHexAddr, data);
+        break;
+    case FLOAT:
+        sendVpFloat(_vpHexAddr, data);
+        break;
+    // Fixed point, the display shows the decimals
+    case INT:
+        sendVpWord(_vpHexAddr, toFixed(data));
+        break;
+    case LONG:
+        sendVpLong(_vpHexAddr, toFixed(data));
+        break;
+    default:
+        Serial.printf("ID%d ERR sendData() wrong ui type, should be numeric\n", _id);
+        break;
+    }
+}
+
+void DWIN2::sendData(const String &data)
+{
+    if ((_uitype != ASCII) && (_uitype != UTF))
+    {
+        Serial.printf("ID%d ERR sendData() wrong ui type, should be text\n", _id);
         return;
     }
+    sendVpText(_uitype, _vpHexAddr, data.c_str());
+}
+
+void DWIN2::sendData(const char *data)
+{
+    if ((_uitype != ASCII) && (_uitype != UTF))
+    {
+        Serial.printf("ID%d ERR sendData() wrong ui type, should be text\n", _id);
+        return;
+    }
+    sendVpText(_uitype, _vpHexAddr, data);
+}
+
+void DWIN2::sendVpWord(const uint16_t &vpHexAddr, const uint16_t &data)
+{
+    const uint8_t commandLen = 8;
+    uint8_t command[commandLen] = {0x5A, 0xA5, 0x05, 0x82, 0x00, 0x00, 0x00, 0x00};
+    command[4] = highByte(vpHexAddr);
+    command[5] = lowByte(vpHexAddr);
+    command[6] = highByte(data);
+    command[7] = lowByte(data);
+    sendElementCmd(command, commandLen);
+}
+
+void DWIN2::sendVpLong(const uint16_t &vpHexAddr, const int32_t &data)
+{
+    const uint8_t commandLen = 10;
+    uint8_t command[commandLen] = {0x5A, 0xA5, 0x07, 0x82, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    command[4] = highByte(vpHexAddr);
+    command[5] = lowByte(vpHexAddr);
+    // int32 in big endian, two VP words
+    const uint32_t word = static_cast<uint32_t>(data);
+    dwinHostToBe32(&command[6], &word, 1);
+    sendElementCmd(command, commandLen);
+}
+
+void DWIN2::sendVpFloat(const uint16_t &vpHexAddr, const float &data)
+{
+    uint32_t bits;
+    memcpy(&bits, &data, sizeof(bits));
+    // Same frame as int32, IEEE single float bits
+    sendVpLong(vpHexAddr, static_cast<int32_t>(bits));
+}
+
+void DWIN2::sendVpDouble(const uint16_t &vpHexAddr, const double &data)
+{
     const uint8_t headerLen = 6;
     const uint8_t commandLen = 14;
 
     uint8_t command[commandLen] = {0x5A, 0xA5, 0x0B, 0x82, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    command[4] = highByte(_vpHexAddr);
-    command[5] = lowByte(_vpHexAddr);
-
-    double dbl = data;
-    uint8_t* byteArrDbl = reinterpret_cast<uint8_t*>(&dbl);
-    // Swap bytes (big endian to little endian)
-    swapBytes(byteArrDbl, sizeof(double));
+    command[4] = highByte(vpHexAddr);
+    command[5] = lowByte(vpHexAddr);
 
     // Pointer to the 6th element of the array (end of the array command)
     uint8_t *pntr{&command[headerLen]};
-    // Adding double after the command header
-    memcpy(pntr, byteArrDbl, sizeof(double));
+    // Adding double after the command header in big endian
+    dwinHostToBe64(pntr, data);
     
-    sendUart(command, commandLen);
+    sendElementCmd(command, commandLen);
 }
 
-void DWIN2::sendData(const String &data)
+void DWIN2::sendVpText(const uitype_t &uitype, const uint16_t &vpHexAddr, const char *data)
+{
+    uint8_t command[DWIN_MAX_BLOCK_WORDS*2 + 6];
+    const size_t commandLen = encodeText(uitype, vpHexAddr, data, command);
+    if (commandLen == 0) return;
+    // Send data to uartTask
+    sendElementCmd(command, commandLen);
+}
+
+bool DWIN2::encodeText(const uitype_t &uitype, const uint16_t &vpHexAddr, const String &data, std::vector<uint8_t> &command)
+{
+    command.resize(DWIN_MAX_BLOCK_WORDS*2 + 6);
+    command.resize(encodeText(uitype, vpHexAddr, data.c_str(), command.data()));
+    return command.size() > 0;
+}
+
+size_t DWIN2::encodeText(const uitype_t &uitype, const uint16_t &vpHexAddr, const char *data, uint8_t *command)
 {
-    if (_uitype == ASCII)
+    const uint8_t headerLen = 6;
+    // Text must fit into one frame with 2 bytes end of line
+    const size_t maxTextLen = DWIN_MAX_BLOCK_WORDS*2 - 2;
+    size_t textLen = 0;
+
+    if (uitype == ASCII)
     {
-        const char* text = data.c_str();
-        const unsigned char textLen = data.length();
-        const unsigned char headerLen = 6;
-        // Total array size is equal to header + text length + 2 bytes end of line
-        const unsigned char commandLen = headerLen + textLen + 2;
-        // The command length is counted without the first three bytes
-        // Text length + 1 byte command (0x82) + 2 bytes _vpHexAddr + 2 bytes end of line
-        const unsigned char cmdLen = data.length() + 5;
-        // Define the hader
-        unsigned char command[commandLen] = {0x5A, 0xA5, cmdLen, 0x82, 0x00, 0x00};
-        command[4] = highByte(_vpHexAddr);
-        command[5] = lowByte(_vpHexAddr);
-
-        // Pointer to the 6th element of the array (end of the array command)
-        unsigned char *pntr{&command[headerLen]};
-        // Add text to the end of the array
-        memcpy(pntr, text, textLen);
-        // End-of-line character
-        unsigned char eofl[2] = {0xFF, 0xFF};
-        // Pointer to the penultimate element of the array
-        unsigned char *pntr2{&command[commandLen-2]};
-        // Add the end of the string to the end of the array
-        memcpy(pntr2, eofl, sizeof(eofl));
-        printHex(command, commandLen);
-
-        // Send data to uartTask
-        sendUart(command, commandLen);
+        textLen = std::min<size_t>(strlen(data), maxTextLen);
+        // Add text after the header
+        memcpy(&command[headerLen], data, textLen);
     }
-    else if (_uitype == UTF)
+    else if (uitype == UTF)
     {
-        const char* text = data.c_str();
-        // Convert ASCII text to UTF16
-        // Create codecvt-object for conversion
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-        // Convert ASCII string to UTF-16
-        std::wstring utf16String = converter.from_bytes(text);
-        // Convert std::wstring to unsigned char*
-        const unsigned char* utf16text = reinterpret_cast<const unsigned char*>(utf16String.data());
-        const unsigned char headerLen = 6;
-        const unsigned char textLen = utf16String.length()*2;
-        // Total array size is equal to header + text length + 2 bytes end of line
-        const unsigned char commandLen = headerLen + textLen + 2;
-        // The command length is counted without the first three bytes
-        // Text length + 1 byte command (0x82) + 2 bytes _vpHexAddr + 2 bytes end of line
-        const unsigned char cmdLen = textLen + 5;
-        // Define the header
-        unsigned char command[commandLen] = {0x5A, 0xA5, cmdLen, 0x82, 0x00, 0x00};
-        command[4] = highByte(_vpHexAddr);
-        command[5] = lowByte(_vpHexAddr);
-
-        // Pointer to the 6th element of the array (end of the array command)
-        unsigned char *pntr{&command[headerLen]};
-        // Add text to the end of the buffer array
-        memcpy(pntr, utf16text, textLen);
-        // Change high and low bytes of text only
-        for (int i = headerLen; i < commandLen; i += 2) 
-        {
-            std::swap(command[i], command[i+1]);
-        }
-
-        // End-of-line character
-        unsigned char eofl[2] = {0xFF, 0xFF};
-        // Pointer to the penultimate element of the array
-        unsigned char *pntr2{&command[commandLen-2]};
-        // Add the end of the string to the end of the array
-        memcpy(pntr2, eofl, sizeof(eofl));
-
-        // Send data to uartTask
-        sendUart(command, commandLen);
+        // Convert UTF-8 text to big endian UTF16 after the header
+        textLen = dwinUtf8ToUtf16Be(&command[headerLen], data, maxTextLen/2);
     }
     else
     {
-        Serial.printf("ID%d ERR sendData() wrong ui type, should be text\n", _id);
-        return;
+        return 0;
     }
+    // Define the header
+    // The command length is counted without the first three bytes
+    // Text length + 1 byte command (0x82) + 2 bytes VP + 2 bytes end of line
+    command[0] = 0x5A;
+    command[1] = 0xA5;
+    command[2] = static_cast<uint8_t>(textLen + 5);
+    command[3] = 0x82;
+    command[4] = highByte(vpHexAddr);
+    command[5] = lowByte(vpHexAddr);
+    // End-of-line character
+    command[headerLen + textLen] = 0xFF;
+    command[headerLen + textLen + 1] = 0xFF;
+    return headerLen + textLen + 2;
 }
 
 void DWIN2::setVarIcon(const int &icoNum)
@@ -438,15 +945,83 @@ void DWIN2::setVarIcon(const int &icoNum)
         Serial.printf("ID%d ERR sendData() wrong ui type, should be ICON\n", _id);
         return;
     }
-    const uint8_t commandLen = 8;
-    uint8_t command[commandLen] = {0x5A, 0xA5, 0x05, 0x82, 0x00, 0x00, 0x00, 0x00};
-    command[4] = highByte(_vpHexAddr);
-    command[5] = lowByte(_vpHexAddr);
-    command[6] = highByte(icoNum);
-    command[7] = lowByte(icoNum);
-    sendUart(command, commandLen);
+    sendVpWord(_vpHexAddr, icoNum);
+}
+
+void DWIN2::writeBlock(const uint16_t &vpHexAddr, const uint16_t *data, const size_t &count)
+{
+    const uint8_t headerLen = 6;
+    // One frame on the stack, the frames are collected back to back in the command buffer of the port
+    uint8_t command[headerLen + DWIN_MAX_BLOCK_WORDS*2];
+
+    size_t sent = 0;
+    while (sent < count)
+    {
+        const size_t words = std::min<size_t>(count - sent, DWIN_MAX_BLOCK_WORDS);
+        const uint16_t vp = vpHexAddr + sent;
+        command[0] = 0x5A;
+        command[1] = 0xA5;
+        // The command length is counted without the first three bytes
+        command[2] = static_cast<uint8_t>(words*2 + 3);
+        command[3] = 0x82;
+        command[4] = highByte(vp);
+        command[5] = lowByte(vp);
+        // Host to big endian for the whole chunk
+        dwinHostToBe16(&command[headerLen], &data[sent], words);
+        sendUart(command, headerLen + words*2);
+        sent += words;
+    }
+}
+
+void DWIN2::writeBlock(const uint16_t &vpHexAddr, const std::vector<uint16_t> &data)
+{
+    writeBlock(vpHexAddr, data.data(), data.size());
+}
+
+size_t DWIN2::readBlock(const uint16_t &vpHexAddr, uint16_t *data, const size_t &count)
+{
+    const uint8_t commandLen = 7;
+    if (_bus == nullptr) return 0;
+    size_t received = 0;
+    while (received < count)
+    {
+        const uint8_t words = std::min<size_t>(count - received, DWIN_MAX_BLOCK_WORDS);
+        const uint16_t vp = vpHexAddr + received;
+        uint8_t command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, 0x00, 0x00, words};
+        command[4] = highByte(vp);
+        command[5] = lowByte(vp);
+
+        // Reset the signal left from previous commands
+        waitRead(_bus, 0);
+        sendUart(command, commandLen);
+
+        // Skip responses to the commands queued before, until the answer for this chunk
+        size_t chunk = 0;
+        while (waitRead(_bus, groupWaitMs(_bus)))
+        {
+            if (dwinLock(_bus->uartMutex))
+            {
+                chunk = hexBufBlockProcessing(_bus->rxBuf, vp, &data[received], words);
+                dwinUnlock(_bus->uartMutex);
+            }
+            if (chunk > 0) break;
+        }
+        if (chunk < words)
+        {
+            Serial.printf("ID%d ERR readBlock() no answer for VP 0x%04X\n", _id, vp);
+            return received + chunk;
+        }
+        received += chunk;
+    }
+    return received;
 }
 
+std::vector<uint16_t> DWIN2::readBlock(const uint16_t &vpHexAddr, const size_t &count)
+{
+    std::vector<uint16_t> data(count);
+    data.resize(readBlock(vpHexAddr, data.data(), count));
+    return data;
+}
 
 void DWIN2::setPos(const int &x, const int &y)
 {
@@ -459,7 +1034,7 @@ void DWIN2::setPos(const int &x, const int &y)
     command[7] = lowByte(x);
     command[8] = highByte(y);
     command[9] = lowByte(y);
-    sendUart(command, commandLen);
+    sendElementCmd(command, commandLen);
 }
 
 void DWIN2::sendRawCommand(const uint8_t *cmd, const size_t &cmdLength)
@@ -468,46 +1043,273 @@ void DWIN2::sendRawCommand(const uint8_t *cmd, const size_t &cmdLength)
     sendUart(cmd, cmdLength);
 }
 
-void DWIN2::update(const double &delta, const bool &rightDir)
+void DWIN2::sendElementCmd(const uint8_t *command, const size_t &cmdLength)
 {
-    _rightDir = rightDir;
-    // Send incremental value to the display
-    if ((_uitype == INT) || (_uitype == UTF) || ((_uitype == ASCII)) || (_uitype == DOUBLE))
+    if (!_deferred)
     {
-        increment(delta);
+        sendUart(command, cmdLength);
+        return;
     }
-    else
+    // Element is not visible: keep only the last command for each address
+    const uint16_t addr = (command[4] << 8) | command[5];
+    size_t pos = 0;
+    while (pos + 6 <= _pendingCmd.size())
     {
-        Serial.printf("ID%d, ERR update(), unknown UI type\n", _id);
+        const size_t frameLen = _pendingCmd[pos+2] + 3;
+        if (((_pendingCmd[pos+4] << 8) | _pendingCmd[pos+5]) == addr)
+        {
+            _pendingCmd.erase(_pendingCmd.begin() + pos, _pendingCmd.begin() + pos + frameLen);
+            continue;
+        }
+        pos += frameLen;
     }
+    _pendingCmd.insert(_pendingCmd.end(), command, command + cmdLength);
 }
 
-void DWIN2::clearText(uint8_t textLen)
+void DWIN2::setDeferred(const bool &deferred)
 {
-    uint8_t commandLen = textLen*2 + 6;
-    uint8_t cmdLen = commandLen-3;
-    uint8_t command[commandLen] = {0x5A, 0xA5, cmdLen, 0x82, 0x00, 0x00};
-    command[4] = highByte(_vpHexAddr);
-    command[5] = lowByte(_vpHexAddr);
+    _deferred = deferred;
+}
+
+bool DWIN2::getDeferred()
+{
+    return _deferred;
+}
 
-    if (_uitype == ASCII)
+void DWIN2::takePending(std::vector<uint8_t> &commands)
+{
+    commands.insert(commands.end(), _pendingCmd.begin(), _pendingCmd.end());
+    _pendingCmd.clear();
+}
+
+// VP write collected by coalesce(): data at pos in the commands, len bytes
+typedef struct {
+    uint16_t vp;
+    size_t pos;
+    size_t len;
+} vpwrite_t;
+
+// Join the writes to the adjacent addresses into the max-size frames. The writes do not overlap
+static void joinWrites(const std::vector<uint8_t> &commands, std::vector<vpwrite_t> &writes, std::vector<uint8_t> &frames)
+{
+    std::sort(writes.begin(), writes.end(), [](const vpwrite_t &a, const vpwrite_t &b) { return a.vp < b.vp; });
+    size_t i = 0;
+    while (i < writes.size())
+    {
+        const size_t start = frames.size();
+        frames.insert(frames.end(), {0x5A, 0xA5, 0x00, 0x82, highByte(writes[i].vp), lowByte(writes[i].vp)});
+        size_t dataLen = 0;
+        uint16_t nextVp = writes[i].vp;
+        do
+        {
+            frames.insert(frames.end(), commands.begin() + writes[i].pos, commands.begin() + writes[i].pos + writes[i].len);
+            dataLen += writes[i].len;
+            nextVp = writes[i].vp + writes[i].len/2;
+            const bool oddLen = (writes[i].len % 2 != 0);
+            i++;
+            // Odd length (ASCII text) ends the frame
+            if (oddLen) break;
+        } while ((i < writes.size()) && (writes[i].vp == nextVp) && (dataLen + writes[i].len <= DWIN_MAX_BLOCK_WORDS*2));
+        frames[start + 2] = static_cast<uint8_t>(dataLen + 3);
+    }
+    writes.clear();
+}
+
+void DWIN2::coalesce(const std::vector<uint8_t> &commands, std::vector<uint8_t> &frames)
+{
+    // Writes since the last command kept in place, none of them overlap
+    std::vector<vpwrite_t> writes;
+    size_t pos = 0;
+    while ((pos + 3 <= commands.size()) && (pos + commands[pos+2] + 3 <= commands.size()))
     {
-        for (int i = 6; i < commandLen; i++)
+        const size_t frameLen = commands[pos+2] + 3;
+        const uint16_t vp = (frameLen > 6) ? (commands[pos+4] << 8) | commands[pos+5] : 0;
+        // Reads, system variables (page switch...) and other commands stay in program order
+        if ((frameLen <= 6) || (commands[pos+3] != 0x82) || (vp < DWIN_SHADOW_MIN_VP))
         {
-            command[i] = 0x20;
+            joinWrites(commands, writes, frames);
+            frames.insert(frames.end(), commands.begin() + pos, commands.begin() + pos + frameLen);
+            pos += frameLen;
+            continue;
         }
-        // Send data to uartTask
-        sendUart(command, commandLen);
+
+        const vpwrite_t write = {vp, pos + 6, frameLen - 6};
+        const uint32_t end = uint32_t(vp) + (write.len + 1)/2;
+        bool replaced = false;
+        bool overlap = false;
+        for (size_t i = 0; i < writes.size(); i++)
+        {
+            const uint32_t writeEnd = uint32_t(writes[i].vp) + (writes[i].len + 1)/2;
+            if ((vp >= writeEnd) || (writes[i].vp >= end)) continue;
+            // The same VPs written again, the later data is sent
+            if ((writes[i].vp == vp) && (writes[i].len == write.len))
+            {
+                writes[i] = write;
+                replaced = true;
+                break;
+            }
+            overlap = true;
+        }
+        if (replaced)
+        {
+            pos += frameLen;
+            continue;
+        }
+        // Partly overwritten: the earlier writes go first
+        if (overlap) joinWrites(commands, writes, frames);
+        writes.push_back(write);
+        pos += frameLen;
+    }
+    joinWrites(commands, writes, frames);
+}
+
+bool DWIN2::flush(const uint32_t &timeoutMs)
+{
+    if (_bus == nullptr) return false;
+    dwinflush_t mark;
+    markFlush(mark);
+    // Wait until uartTask has sent all frames queued before and received the answers
+    uint32_t waitMs = 0;
+    bool ok = true;
+    while (!checkFlush(mark, ok))
+    {
+        if (waitMs++ >= timeoutMs) return false;
+        wait(1);
+    }
+    return ok;
+}
+
+void DWIN2::markFlush(dwinflush_t &mark)
+{
+    mark.busCount = 0;
+    if (_bus == nullptr) return;
+    // The bus and its mirrors
+    mark.busCount = _bus->mirrorCount + 1;
+    for (uint8_t i = 0; i < mark.busCount; i++)
+    {
+        const dwinbus_t *bus = (i == 0) ? _bus : _bus->mirrors[i - 1];
+        mark.target[i] = bus->queuedFrames;
+        mark.lost[i] = bus->lostFrames;
+    }
+}
+
+bool DWIN2::checkFlush(const dwinflush_t &mark, bool &ok)
+{
+    ok = true;
+    for (uint8_t i = 0; i < mark.busCount; i++)
+    {
+        const dwinbus_t *bus = (i == 0) ? _bus : _bus->mirrors[i - 1];
+        if (static_cast<int32_t>(bus->doneFrames - mark.target[i]) < 0) return false;
+        if (bus->lostFrames != mark.lost[i]) ok = false;
+    }
+    return true;
+}
+
+bool DWIN2::readAsync(dwinread_t &read)
+{
+    const uint8_t commandLen = 7;
+    if ((_bus == nullptr) || (read.data == nullptr) || (read.count == 0) || (read.count > DWIN_MAX_BLOCK_WORDS)) return false;
+    // The read waits before its command is queued, the answer may come at once
+    read.state = DWIN_READ_PENDING;
+    read.next = nullptr;
+    if (!dwinLock(_bus->uartMutex)) return false;
+    dwinread_t **tail = &_bus->asyncReads;
+    while (*tail != nullptr) tail = &(*tail)->next;
+    *tail = &read;
+    dwinUnlock(_bus->uartMutex);
+
+    uint8_t command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, highByte(read.vp), lowByte(read.vp), read.count};
+    sendUart(command, commandLen);
+    return true;
+}
+
+dwinreadstate_t DWIN2::endRead(dwinread_t &read)
+{
+    if ((_bus != nullptr) && dwinLock(_bus->uartMutex))
+    {
+        if (read.state == DWIN_READ_PENDING)
+        {
+            unlinkRead(_bus, &read);
+            read.state = DWIN_READ_LOST;
+        }
+        dwinUnlock(_bus->uartMutex);
+    }
+    return read.state;
+}
+
+void DWIN2::unlinkRead(dwinbus_t *bus, dwinread_t *read)
+{
+    for (dwinread_t **it = &bus->asyncReads; *it != nullptr; it = &(*it)->next)
+    {
+        if (*it != read) continue;
+        *it = read->next;
+        read->next = nullptr;
+        return;
+    }
+}
+
+void DWIN2::completeReads(dwinbus_t *bus)
+{
+    if (bus->asyncReads == nullptr) return;
+    // Read commands of the group and their answers are in the same order
+    const dwintxbuf_t &tx = bus->txBuf;
+    const dwinanswer_t &rx = bus->rxBuf;
+    size_t rxPos = 0;
+    for (size_t pos = bus->groupStart; (pos + 7 <= bus->txPos) && (tx[pos] == 0x5A); pos += tx[pos+2] + 3)
+    {
+        if (tx[pos+3] != 0x83) continue;
+        const uint16_t vp = (tx[pos+4] << 8) | tx[pos+5];
+        const uint8_t count = tx[pos+6];
+        // The first waiting read of the same VP and size, the reads are kept in the order queued
+        dwinread_t *read = bus->asyncReads;
+        while ((read != nullptr) && ((read->vp != vp) || (read->count != count))) read = read->next;
+        if (read == nullptr) continue;
+
+        // Next answer to this command
+        const uint8_t *answer = nullptr;
+        while (rxPos + 3 <= rx.size())
+        {
+            if ((rx[rxPos] != 0x5A) || (rx[rxPos+1] != 0xA5))
+            {
+                rxPos++;
+                continue;
+            }
+            const size_t frameLen = rx[rxPos+2] + 3;
+            if (rxPos + frameLen > rx.size()) break;
+            const bool match = (rx[rxPos+3] == 0x83) && (frameLen >= 7u + count*2) &&
+                               (rx[rxPos+4] == tx[pos+4]) && (rx[rxPos+5] == tx[pos+5]) && (rx[rxPos+6] == count);
+            if (match) answer = &rx[rxPos+7];
+            rxPos += frameLen;
+            if (match) break;
+        }
+        unlinkRead(bus, read);
+        if (answer != nullptr) dwinBeToHost16(read->data, answer, count);
+        read->state = (answer != nullptr) ? DWIN_READ_DONE : DWIN_READ_LOST;
+    }
+}
+
+void DWIN2::update(const double &delta, const bool &rightDir)
+{
+    _rightDir = rightDir;
+    // Send incremental value to the display
+    if ((_uitype == INT) || (_uitype == UTF) || ((_uitype == ASCII)) || (_uitype == DOUBLE) || (_uitype == LONG) || (_uitype == FLOAT))
+    {
+        increment(delta);
+    }
+    else
+    {
+        Serial.printf("ID%d, ERR update(), unknown UI type\n", _id);
     }
-    else if (_uitype == UTF)
+}
+
+void DWIN2::clearText(uint8_t textLen)
+{
+    // The display ends the text at the 0xFFFF terminator, one word clears any length.
+    // textLen is kept for compatibility
+    (void)textLen;
+    if ((_uitype == ASCII) || (_uitype == UTF))
     {
-        for (int i = 6; i < commandLen; i++)
-        {
-            if (i%2==0) command[i] = 0x00;
-            else command[i] = 0x20;
-        }
-        // Send data to uartTask
-        sendUart(command, commandLen);
+        sendVpWord(_vpHexAddr, 0xFFFF);
     }
     else
     {
@@ -529,27 +1331,40 @@ double DWIN2::getCurrentVal()
 String DWIN2::getUiData(const uint8_t &textSize)
 {
     String data;
+    if (_bus == nullptr) return data;
     switch (_uitype)
     {
     case INT:
         sendReadUiNumCmd();
-        while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-        data = (String)hexBufIntProcessing(_uartRxBuf);
+        waitAnswer(_vpHexAddr);
+        if (_decimals > 0) data = String(static_cast<int16_t>(hexBufIntProcessing(_bus->rxBuf))/pow(10.0, _decimals), _decimals);
+        else data = (String)hexBufIntProcessing(_bus->rxBuf);
+        break;
+    case LONG:
+        sendReadUiNumCmd();
+        waitAnswer(_vpHexAddr);
+        if (_decimals > 0) data = String(hexBufLongProcessing(_bus->rxBuf)/pow(10.0, _decimals), _decimals);
+        else data = (String)hexBufLongProcessing(_bus->rxBuf);
+        break;
+    case FLOAT:
+        sendReadUiNumCmd();
+        waitAnswer(_vpHexAddr);
+        data = (String)hexBufFloatProcessing(_bus->rxBuf);
         break;
     case DOUBLE:
         sendReadUiNumCmd();
-        while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-        data = (String)hexBufDblProcessing(_uartRxBuf);
+        waitAnswer(_vpHexAddr);
+        data = (String)hexBufDblProcessing(_bus->rxBuf);
         break;
     case UTF:
         sendReadUiTextCmd(textSize);
-        while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-        data = (String)hexBufUtfProcessing(_uartRxBuf);
+        waitAnswer(_vpHexAddr);
+        data = (String)hexBufUtfProcessing(_bus->rxBuf);
         break;
     case ASCII:
         sendReadUiTextCmd(textSize);
-        while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-        data = (String)hexBufAsciiProcessing(_uartRxBuf);
+        waitAnswer(_vpHexAddr);
+        data = (String)hexBufAsciiProcessing(_bus->rxBuf);
         break;
     default:
         data = "Unknown Data";
@@ -569,6 +1384,33 @@ void DWIN2::_handleEchoUart()
 }
 
 void DWIN2::increment(const double &delta)
+{
+    stepValue(delta);
+    sendCurrentVal();
+}
+
+void DWIN2::updateSteps(const int32_t &steps, const double &delta)
+{
+    if (steps == 0) return;
+    if (_uitype == ICON)
+    {
+        Serial.printf("ID%d, ERR updateSteps(), unknown UI type\n", _id);
+        return;
+    }
+    _rightDir = (steps > 0);
+    const double prevVal = _currentVal;
+    const uint32_t count = (steps > 0) ? steps : -steps;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        stepValue(delta);
+        // The value stopped at the limit, the next steps change nothing
+        if (!_loopRotation && ((_currentVal == _minVal) || (_currentVal == _maxVal))) break;
+    }
+    // One frame with the final value
+    if (_currentVal != prevVal) sendCurrentVal();
+}
+
+void DWIN2::stepValue(const double &delta)
 {
     if (_rightDir)
     {
@@ -600,17 +1442,21 @@ void DWIN2::increment(const double &delta)
             _currentVal = _maxVal;
         }
     }
+}
+
+void DWIN2::sendCurrentVal()
+{
     // Convert double to int
     int currIntVal = static_cast<int>(_currentVal);
-    if (_uitype == INT)
+    if (((_uitype == INT) || (_uitype == LONG)) && (_decimals == 0))
     {
         sendData(currIntVal);
     }
     else if (_uitype == UTF)
     {
-        if (_listStrVal.size() > currIntVal)
+        if ((currIntVal >= 0) && (listSize() > static_cast<size_t>(currIntVal)))
         {
-            sendData(_listStrVal.at(currIntVal).c_str());
+            sendData(listItem(currIntVal));
         }
         else
         {
@@ -620,9 +1466,9 @@ void DWIN2::increment(const double &delta)
     }
     else if (_uitype == ASCII)
     {
-        if (_listStrVal.size() > currIntVal)
+        if ((currIntVal >= 0) && (listSize() > static_cast<size_t>(currIntVal)))
         {
-            sendData(_listStrVal.at(currIntVal).c_str());
+            sendData(listItem(currIntVal));
         }
         else
         {
@@ -630,8 +1476,9 @@ void DWIN2::increment(const double &delta)
             return;
         }
     }
-    else if (_uitype == DOUBLE)
+    else if ((_uitype == DOUBLE) || (_uitype == FLOAT) || (_uitype == INT) || (_uitype == LONG))
     {
+        // Float and fixed point values
         sendData(_currentVal);
     }
 }
@@ -639,25 +1486,24 @@ void DWIN2::increment(const double &delta)
 
 void DWIN2::clearRxBuf()
 {
-    if (_uart->available() <= 0) return;
-    if (xSemaphoreTake(_uartMutex, portMAX_DELAY) == pdTRUE)
+    if (_bus == nullptr) return;
+    if (_echo) Serial.println("Clear rxBuf");
+    clearRxBuf(_bus);
+}
+
+void DWIN2::clearRxBuf(dwinbus_t *bus)
+{
+    if ((bus->transport == nullptr) || (bus->transport->available() == 0)) return;
+    if (dwinLock(bus->uartMutex))
     {
-        _uart->flush();
-        if (_echo) Serial.print("Clear rxBuf");
-        while (_uart->available())
-        {
-            uint8_t buf = _uart->read();
-            //if (_echo) Serial.print(buf, HEX);
-        }
-        if (_echo) Serial.println();
-        xSemaphoreGive(_uartMutex);
+        bus->transport->flushInput();
+        dwinUnlock(bus->uartMutex);
     }
 }
 
 void DWIN2::sendReadUiNumCmd()
 {
     const uint8_t commandLen = 7;
-    std::vector<uint8_t> buffer;
     int num = 0;
 
     // Clear the receiving buffer of the display
@@ -665,6 +1511,7 @@ void DWIN2::sendReadUiNumCmd()
 
     uint8_t command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, 0x00, 0x00, 0x00};
     if (_uitype == INT) command[6] = 0x01;
+    else if ((_uitype == LONG) || (_uitype == FLOAT)) command[6] = 0x02;
     else if (_uitype == DOUBLE) command[6] = 0x04;
     else Serial.printf("ID %d unknown _uitype\n");
     command[4] = highByte(_vpHexAddr);
@@ -689,7 +1536,7 @@ void DWIN2::sendReadUiTextCmd(const uint8_t &maxTextSize)
     sendUart(command, commandLen);
 }
 
-int DWIN2::hexBufIntProcessing(const std::vector<uint8_t> &buffer)
+int DWIN2::hexBufIntProcessing(const dwinanswer_t &buffer)
 {
     int num = 0;
     if ((buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
@@ -699,21 +1546,37 @@ int DWIN2::hexBufIntProcessing(const std::vector<uint8_t> &buffer)
     return num;
 }
 
-double DWIN2::hexBufDblProcessing(const std::vector<uint8_t> &buffer)
+int32_t DWIN2::hexBufLongProcessing(const dwinanswer_t &buffer)
+{
+    uint32_t word = 0;
+    if ((buffer.size() >= 7 + sizeof(word)) && (buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
+    {
+        // Big endian int32 after the 7-byte header
+        dwinBeToHost32(&word, &buffer[7], 1);
+    }
+    return static_cast<int32_t>(word);
+}
+
+float DWIN2::hexBufFloatProcessing(const dwinanswer_t &buffer)
+{
+    const uint32_t bits = static_cast<uint32_t>(hexBufLongProcessing(buffer));
+    float fnum;
+    memcpy(&fnum, &bits, sizeof(fnum));
+    return fnum;
+}
+
+double DWIN2::hexBufDblProcessing(const dwinanswer_t &buffer)
 {
     double dnum = 0.0;
-    std::vector<uint8_t> tmpBuf = buffer;
-    if ((tmpBuf[3] == 0x83) && (tmpBuf[4] == highByte(_vpHexAddr)) && (tmpBuf[5] == lowByte(_vpHexAddr)))
+    if ((buffer.size() >= 7 + sizeof(double)) && (buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
     {
-        // Reverse the array
-        std::reverse(tmpBuf.begin(), tmpBuf.end());
-        // Save the array to the variable double
-        memcpy(&dnum, &tmpBuf[0], sizeof(double));                  
+        // Big endian double after the 7-byte header
+        dnum = dwinBeToHost64(&buffer[7]);
     }
     return dnum;
 }
 
-String DWIN2::hexBufUtfProcessing(const std::vector<uint8_t> &buffer)
+String DWIN2::hexBufUtfProcessing(const dwinanswer_t &buffer)
 {
     if ((buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
     {
@@ -741,16 +1604,13 @@ String DWIN2::hexBufUtfProcessing(const std::vector<uint8_t> &buffer)
         // Collect the text part into words (2 bytes)
         uint8_t textU16Size = textBytesCounter/2;
         uint16_t utf16text[textU16Size];
-        for (int i = 0; i < textU16Size; ++i)
-        {
-            utf16text[i] = static_cast<uint16_t>((charText[2*i] << 8) | charText[2*i+1]);
-        }
+        dwinBeToHost16(utf16text, charText, textU16Size);
         return utf16_to_utf8(utf16text, textU16Size);
     }
     return "";
 }
 
-String DWIN2::hexBufAsciiProcessing(const std::vector<uint8_t> &buffer)
+String DWIN2::hexBufAsciiProcessing(const dwinanswer_t &buffer)
 {
     if ((buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
     {
@@ -758,7 +1618,7 @@ String DWIN2::hexBufAsciiProcessing(const std::vector<uint8_t> &buffer)
         asciiStr.reserve(buffer.size() - 6);
 
         // Select only the text part in ASCII format
-        for  (int i = 7; i < buffer.size()-1; i++)
+        for  (size_t i = 7; i + 1 < buffer.size(); i++)
         {   
             if ((buffer[i] == 0xFF) && (buffer[i+1] == 0xFF))
             {
@@ -813,16 +1673,11 @@ void DWIN2::blinkUI(bool state)
         command[6] = 0xFF;
         command[7] = 0xFF;
     }
-    if (xSemaphoreTake(_uartMutex, portMAX_DELAY) == pdTRUE)
-    {
-        while (_uart->available())
-        {
-            // clear display answers
-            _uart->read();
-        }
-        _uart->write(command, 8);
-        xSemaphoreGive(_uartMutex);
-    }
+    if (_bus == nullptr) return;
+    const uint32_t blinkUs = micros();
+    // The bus may be waiting for the answers of a group, queue the command
+    queueBus(_bus, command, 8);
+    if (_bus->timeline) _bus->timeline->span(TL_BLINK, _bus->serialNum, blinkUs, 8);
 }
 
 void DWIN2::blinkTmr(void *arg)
@@ -837,120 +1692,681 @@ void DWIN2::blinkTmr(void *arg)
     }
 }
 
+#ifndef DWIN_NO_RTOS
 void DWIN2::uartTask(void *parameter)
 {
-    DWIN2* p_dwin = static_cast<DWIN2*>(parameter);
-    if (p_dwin->_uartWriteSem == nullptr) 
+    dwinbus_t* bus = static_cast<dwinbus_t*>(parameter);
+    if (bus->writeSem == nullptr) 
     {
         Serial.printf("xSemaphoreCreateBinary ERR\n");
         return;
     }
-    if (_uartMutex == nullptr) return;
-
-    std::vector<uint8_t> cmd;
-    std::vector<uint8_t> buf;
-    buf.reserve(BUFSIZE);
+    if (bus->uartMutex == nullptr) return;
 
     while (true) {
-        if (xSemaphoreTake(p_dwin->_uartWriteSem, portMAX_DELAY) == pdTRUE)
+        bool wake;
+        if (bus->uploadOn)
         {
-            if (p_dwin->_uartCmdBuffer.size() > BUFSIZE-1)
+            // Auto-upload frames are taken while waiting for the commands: one wait for both,
+            // queueBus() wakes the receive wait after the writeSem check below
+            bus->rxIdle = true;
+            wake = (xSemaphoreTake(bus->writeSem, 0) == pdTRUE);
+            if (!wake) bus->transport->waitRx(bus->transport->idleWaitMs());
+            bus->rxIdle = false;
+            if (!wake)
             {
-                Serial.printf("_uartCmdBuffer Overhead!!!\n");
-                p_dwin->_uartCmdBuffer.clear();
-                continue;
-            } 
+                receiveUploads(bus);
+                wake = (xSemaphoreTake(bus->writeSem, 0) == pdTRUE);
+            }
+        }
+        else
+        {
+            wake = (xSemaphoreTake(bus->writeSem, portMAX_DELAY) == pdTRUE);
+        }
+        if (wake)
+        {
             // Block access to the buffer when reading it
-            if (xSemaphoreTake(_bufferMutex, portMAX_DELAY) == pdTRUE)
+            if (dwinLock(bus->bufferMutex))
             {
-                // Copy buffer from uart commands to local buffer
-                buf = p_dwin->_uartCmdBuffer;
-                // _uartCmdBuffer is no longer needed, reset to zero
-                p_dwin->_uartCmdBuffer.clear();
-                xSemaphoreGive(_bufferMutex);
+                // Take the commands, cmdBuffer is free for the next ones
+                bus->txBuf.take(bus->cmdBuffer);
+                bus->txPos = 0;
+                dwinUnlock(bus->bufferMutex);
+                if (bus->timeline && (bus->txBuf.size() > 0)) bus->timeline->span(TL_QUEUE, bus->serialNum, bus->queueUs, bus->txBuf.size());
+                // Wake up sendUart() waiting for the free buffer
+                xSemaphoreGive(bus->freeSem);
             }
 
-            // Buffer must be full
-            if (buf.size() < 4) continue;
-
-            // Split the buffer into separate commands
-            for (int i = 0; i < buf.size(); i++)
+            // Send the groups of frames and wait for the answers to each group
+            while (sendGroup(bus))
             {
-                // If we found header 0xA55A
-                if (((buf[i] == 0x5A) && (buf[i+1] == 0xA5)) || (i == buf.size()-1))
-                {
-                    // Add the last byte
-                    if (i == buf.size()-1) cmd.push_back(buf[i]);
-                    // Skip the first two bytes
-                    if (cmd.size() > 2)
-                    {
-                        // If the command header starts with 0xA55A, the command is assembled
-                        if ((cmd[0] == 0x5A) && (cmd[1] == 0xA5))
-                        {
-                            // Block access to uart, send command via uart
-                            if (xSemaphoreTake(_uartMutex, portMAX_DELAY) == pdTRUE)
-                            {
-                                for (int i = 0; i < cmd.size(); i++)
-                                {
-                                    _uart->write(cmd[i]);
-                                }
-                                xSemaphoreGive(_uartMutex);
-                            }
-                            // Wait for a response from the display
-                            int indx = 0;
-                            while (!_uart->available())
-                            {
-                                indx++;
-                                vTaskDelay(pdMS_TO_TICKS(1));
-                                // If no response is received, exit the loop
-                                if (indx > 30) break;
-                            }
-                            // Clear the receive buffer
-                            _uartRxBuf.clear();
-                            // Block access to uart, read the response from the display
-                            if (xSemaphoreTake(_uartMutex, portMAX_DELAY) == pdTRUE)
-                            {
-                                while (_uart->available())
-                                {
-                                    uint8_t d = static_cast<uint8_t>(_uart->read());
-                                    _uartRxBuf.push_back(d);
-                                }
-                                xSemaphoreGive(_uartMutex);
-                            }
-
-                            // Give semaphore to read data from ui element
-                            xSemaphoreGive(p_dwin->_uartUiReadSem);
-
-                            // If echo mode is enabled
-                            if (p_dwin->_echo)
-                            {
-                                String uartCmdStr = printHex(cmd, cmd.size());
-                                String hexStr = printHex(_uartRxBuf, _uartRxBuf.size());
-                                String idStr = (String)p_dwin->_id;
-                                p_dwin->_dwinEcho = "ID" + idStr + " TX " + uartCmdStr + "\t RX " + hexStr;
-                                // Send to callback
-                                p_dwin->_handleEchoUart();
-                            }
-                            else
-                            {
-                                // Just clean the buffer
-                                p_dwin->clearRxBuf();
-                            }
-                        }
-                    }
-                    // Command sent, clear cmd, start building a new command, if any
-                    cmd.clear();
-                }
-                // Add a byte to the command
-                cmd.push_back(buf[i]);
+                receiveUart(bus);
+                finishGroup(bus);
             }
-            buf.clear();
+            bus->txBuf.clear();
         }
-        vTaskDelay(pdMS_TO_TICKS(1));
     }
     
 }
 
+void DWIN2::receiveUart(dwinbus_t *bus)
+{
+    while (bus->receivedFrames < bus->pendingFrames)
+    {
+        // If no response is received or the answers are lost, exit the loop
+        if (!bus->transport->waitRx(bus->groupTimeoutMs)) break;
+
+        // Block access to uart, read the response from the display
+        const uint32_t rxUs = micros();
+        size_t len = 0;
+        if (dwinLock(bus->uartMutex))
+        {
+            const size_t available = bus->transport->available();
+            const size_t start = bus->rxBuf.size();
+            const size_t rxLen = std::min<size_t>(available, bus->rxBuf.capacity() - start);
+            bus->rxBuf.resize(start + rxLen);
+            len = bus->transport->read(&bus->rxBuf[start], rxLen);
+            bus->rxBuf.resize(start + len);
+            // No room for the answers, drop the rest
+            if (rxLen < available) bus->transport->flushInput();
+            dwinUnlock(bus->uartMutex);
+            if (bus->trace && (len > 0)) bus->trace->record(bus->serialNum, true, &bus->rxBuf[start], len);
+        }
+        countAnswers(bus);
+        if (bus->timeline) bus->timeline->span(TL_RX, bus->serialNum, rxUs, len);
+    }
+}
+#else
+void DWIN2::receiveUart(dwinbus_t *bus)
+{
+    // Read what is received, without waiting
+    const size_t rxLen = bus->transport->available();
+    if (rxLen == 0) return;
+    const uint32_t rxUs = micros();
+    const size_t start = bus->rxBuf.size();
+    const size_t readLen = std::min<size_t>(rxLen, bus->rxBuf.capacity() - start);
+    bus->rxBuf.resize(start + readLen);
+    const size_t len = bus->transport->read(&bus->rxBuf[start], readLen);
+    bus->rxBuf.resize(start + len);
+    // No room for the answers, drop the rest
+    if (readLen < rxLen) bus->transport->flushInput();
+    if (len > 0) bus->rxTimeMs = millis();
+    if (bus->trace && (len > 0)) bus->trace->record(bus->serialNum, true, &bus->rxBuf[start], len);
+    countAnswers(bus);
+    if (bus->timeline) bus->timeline->span(TL_RX, bus->serialNum, rxUs, len);
+}
+#endif
+
+bool DWIN2::sendGroup(dwinbus_t *bus)
+{
+    dwintxbuf_t &buf = bus->txBuf;
+    // Split the buffer into separate commands by the frame length byte,
+    // so the data may contain the 0x5AA5 sequence
+    size_t pos = bus->txPos;
+    while (pos + 3 <= buf.size())
+    {
+        // Look for the header 0xA55A
+        if ((buf[pos] != 0x5A) || (buf[pos+1] != 0xA5))
+        {
+            pos++;
+            continue;
+        }
+        // Write commands are pipelined: up to pipelineDepth frames are sent
+        // without waiting for the acks, any other command ends the group
+        const size_t start = pos;
+        uint8_t frames = 0;
+        bool isWrite = true;
+        // Answers expected: acks, or the VP data of the reads
+        size_t answerBytes = 0;
+        // The slowest class of the frames times the group
+        dwinrttclass_t groupClass = DWIN_RTT_WRITE;
+        while (isWrite && (frames < bus->pipelineDepth) && (pos + 4 <= buf.size()) &&
+               (buf[pos] == 0x5A) && (buf[pos+1] == 0xA5))
+        {
+            const size_t frameLen = buf[pos+2] + 3;
+            if (pos + frameLen > buf.size()) break;
+            isWrite = (buf[pos+3] == 0x82);
+            const uint16_t vp = (frameLen >= 6) ? (buf[pos+4] << 8) | buf[pos+5] : 0;
+            dwinrttclass_t frameClass = DWIN_RTT_SYSTEM;
+            if (buf[pos+3] == 0x83) frameClass = DWIN_RTT_READ;
+            else if (isWrite && (vp >= DWIN_SHADOW_MIN_VP)) frameClass = DWIN_RTT_WRITE;
+            if (frameClass > groupClass) groupClass = frameClass;
+            answerBytes += ((buf[pos+3] == 0x83) && (frameLen >= 7)) ? 7 + 2*buf[pos+6] : 6;
+            pos += frameLen;
+            frames++;
+        }
+        if (frames == 0)
+        {
+            Serial.printf("uartTask: incomplete command dropped\n");
+            break;
+        }
+
+        // The whole group goes to the transport at once
+        const uint32_t txUs = micros();
+        if (dwinLock(bus->uartMutex))
+        {
+            bus->transport->write(&buf[start], pos - start);
+            dwinUnlock(bus->uartMutex);
+        }
+        if (bus->timeline) bus->timeline->span(TL_TX, bus->serialNum, txUs, pos - start);
+        bus->txDoneUs = micros();
+        if (bus->trace) bus->trace->record(bus->serialNum, false, &buf[start], pos - start);
+        bus->txPos = pos;
+        bus->groupStart = start;
+        bus->pendingFrames = frames;
+        bus->receivedFrames = 0;
+        bus->frameStart = 0;
+        bus->rxTimeMs = millis();
+        bus->groupClass = groupClass;
+        bus->groupFull = isWrite && (frames == bus->pipelineDepth);
+        // The round-trip time is measured without the bytes on the wire, a block takes ~22 ms at 115200
+        bus->groupTimeoutMs = bus->rtt[groupClass].timeoutMs + (wireUs(bus, pos - start + answerBytes) + 999)/1000;
+        bus->answerUs = txUs;
+        bus->maxGapUs = 0;
+        bus->groupTxUs = txUs;
+        bus->answerTxPos = start;
+        // Clear the receive buffer
+        bus->rxBuf.clear();
+        // The rest of an auto-upload frame may come with the answers
+        if (bus->uploadRx.size() > 0)
+        {
+            bus->rxBuf.append(bus->uploadRx.data(), bus->uploadRx.size());
+            bus->uploadRx.clear();
+        }
+        return true;
+    }
+    bus->txPos = buf.size();
+    return false;
+}
+
+void DWIN2::countAnswers(dwinbus_t *bus)
+{
+    // Count the complete frames
+    while (bus->frameStart + 3 <= bus->rxBuf.size())
+    {
+        if ((bus->rxBuf[bus->frameStart] != 0x5A) || (bus->rxBuf[bus->frameStart+1] != 0xA5))
+        {
+            bus->frameStart++;
+            continue;
+        }
+        const size_t frameLen = bus->rxBuf[bus->frameStart+2] + 3;
+        if (bus->frameStart + frameLen > bus->rxBuf.size()) break;
+        // Not an answer, the display uploaded it between the answers
+        if ((frameLen >= 7) && isUpload(bus, &bus->rxBuf[bus->frameStart]))
+        {
+            storeUpload(bus, &bus->rxBuf[bus->frameStart], micros());
+            bus->rxBuf.remove(bus->frameStart, frameLen);
+            continue;
+        }
+        bus->frameStart += frameLen;
+        bus->receivedFrames++;
+        // Wait for this answer since its frame was sent or the answer before,
+        // less the time of the answer bytes on the wire
+        const uint32_t nowUs = micros();
+        if (bus->answerTxPos + 3 <= bus->txPos) bus->answerTxPos += bus->txBuf[bus->answerTxPos+2] + 3;
+        const uint32_t sentUs = bus->groupTxUs + wireUs(bus, bus->answerTxPos - bus->groupStart);
+        const uint32_t fromUs = (int32_t(sentUs - bus->answerUs) > 0) ? sentUs : bus->answerUs;
+        const int32_t gapUs = int32_t(nowUs - fromUs) - int32_t(wireUs(bus, frameLen));
+        if ((gapUs > 0) && (uint32_t(gapUs) > bus->maxGapUs)) bus->maxGapUs = gapUs;
+        bus->answerUs = nowUs;
+    }
+}
+
+bool DWIN2::isUpload(dwinbus_t *bus, const uint8_t *frame)
+{
+    if (frame[3] != 0x83) return false;
+    // Answer to a read command of the group: the same VP and size
+    const dwintxbuf_t &tx = bus->txBuf;
+    for (size_t pos = bus->groupStart; (pos + 7 <= bus->txPos) && (tx[pos] == 0x5A); pos += tx[pos+2] + 3)
+    {
+        if ((tx[pos+3] == 0x83) && (tx[pos+4] == frame[4]) && (tx[pos+5] == frame[5]) && (tx[pos+6] == frame[6])) return false;
+    }
+    return true;
+}
+
+void DWIN2::storeUpload(dwinbus_t *bus, const uint8_t *frame, const uint32_t &rxUs)
+{
+    // No handlers, the frame is dropped
+    if (!bus->uploadOn) return;
+    const size_t frameLen = frame[2] + 3;
+    const uint8_t rxTime[4] = {uint8_t(rxUs), uint8_t(rxUs >> 8), uint8_t(rxUs >> 16), uint8_t(rxUs >> 24)};
+    if (dwinLock(bus->uartMutex))
+    {
+        if (bus->uploads.size() + sizeof(rxTime) + frameLen <= bus->uploads.capacity())
+        {
+            bus->uploads.append(rxTime, sizeof(rxTime));
+            bus->uploads.append(frame, frameLen);
+        }
+        else
+        {
+            bus->lostUploads = bus->lostUploads + 1;
+        }
+        dwinUnlock(bus->uartMutex);
+    }
+}
+
+void DWIN2::receiveUploads(dwinbus_t *bus)
+{
+    const size_t available = bus->transport->available();
+    if (available == 0) return;
+    if (dwinLock(bus->uartMutex))
+    {
+        const size_t start = bus->uploadRx.size();
+        const size_t rxLen = std::min<size_t>(available, bus->uploadRx.capacity() - start);
+        bus->uploadRx.resize(start + rxLen);
+        const size_t len = bus->transport->read(&bus->uploadRx[start], rxLen);
+        bus->uploadRx.resize(start + len);
+        dwinUnlock(bus->uartMutex);
+        if (bus->trace && (len > 0)) bus->trace->record(bus->serialNum, true, &bus->uploadRx[start], len);
+    }
+    const uint32_t rxUs = micros();
+
+    // Complete frames from the front, the other frames and bytes are dropped
+    dwinanswer_t &rx = bus->uploadRx;
+    size_t pos = 0;
+    while (pos + 3 <= rx.size())
+    {
+        if ((rx[pos] != 0x5A) || (rx[pos+1] != 0xA5))
+        {
+            pos++;
+            continue;
+        }
+        const size_t frameLen = rx[pos+2] + 3;
+        if (pos + frameLen > rx.size()) break;
+        if ((frameLen >= 7) && (rx[pos+3] == 0x83)) storeUpload(bus, &rx[pos], rxUs);
+        pos += frameLen;
+    }
+    rx.erase(pos);
+    // Full without a complete frame
+    if (rx.size() == rx.capacity()) rx.clear();
+}
+
+void DWIN2::finishGroup(dwinbus_t *bus)
+{
+    // From the group sent to its answers
+    const uint32_t finishUs = micros();
+    if (bus->timeline) bus->timeline->span(TL_PANEL, bus->serialNum, bus->txDoneUs, bus->pendingFrames);
+    const uint8_t lost = (bus->receivedFrames < bus->pendingFrames) ? bus->pendingFrames - bus->receivedFrames : 0;
+    updateRtt(bus, lost);
+    bus->lostFrames = bus->lostFrames + lost;
+    bus->doneFrames = bus->doneFrames + bus->pendingFrames;
+    bus->pendingFrames = 0;
+    if (bus->latency) bus->latency->acked(uint32_t(bus->doneFrames), lost);
+
+    // Objects waiting for the echo
+    DWIN2 *clients[DWIN_MAX_CLIENTS];
+    uint8_t clientCount = 0;
+    if (dwinLock(bus->bufferMutex))
+    {
+        clientCount = bus->clientCount;
+        std::copy(bus->clients, bus->clients + clientCount, clients);
+        dwinUnlock(bus->bufferMutex);
+    }
+    bool echo = false;
+    for (uint8_t i = 0; i < clientCount; i++) echo |= clients[i]->_echo;
+    String hexStr;
+    if (echo) hexStr = printHex(bus->rxBuf, bus->rxBuf.size());
+
+    // Keep only the answer to the last command for the readers of rxBuf
+    if (dwinLock(bus->uartMutex))
+    {
+        completeReads(bus);
+        // Bytes after the last answer are the start of an auto-upload frame, the next reads complete it
+        if (bus->frameStart < bus->rxBuf.size())
+        {
+            const size_t restLen = bus->rxBuf.size() - bus->frameStart;
+            if (!bus->uploadRx.append(&bus->rxBuf[bus->frameStart], restLen)) bus->uploadRx.clear();
+            bus->rxBuf.resize(bus->frameStart);
+        }
+        size_t last = 0;
+        size_t next = 0;
+        while ((next + 3 <= bus->rxBuf.size()) && (next + bus->rxBuf[next+2] + 3 < bus->rxBuf.size()))
+        {
+            if ((bus->rxBuf[next] != 0x5A) || (bus->rxBuf[next+1] != 0xA5)) break;
+            next += bus->rxBuf[next+2] + 3;
+            last = next;
+        }
+        if (last > 0) bus->rxBuf.erase(last);
+        dwinUnlock(bus->uartMutex);
+    }
+
+    // Give semaphore to read data from ui element
+#ifndef DWIN_NO_RTOS
+    xSemaphoreGive(bus->readSem);
+#else
+    bus->readReady = true;
+#endif
+
+    // If echo mode is enabled
+    if (echo)
+    {
+        String uartCmdStr = printHex(&bus->txBuf[bus->groupStart], bus->txPos - bus->groupStart);
+        for (uint8_t i = 0; i < clientCount; i++)
+        {
+            if (!clients[i]->_echo) continue;
+            String idStr = (String)clients[i]->_id;
+            bus->echo = "ID" + idStr + " TX " + uartCmdStr + "\t RX " + hexStr;
+            // Send to callback
+            const uint32_t callbackUs = micros();
+            clients[i]->_handleEchoUart();
+            if (bus->timeline) bus->timeline->span(TL_CALLBACK, bus->serialNum, callbackUs, clients[i]->_id);
+        }
+    }
+    // The input is not flushed: an auto-upload may follow the last answer
+    if (bus->timeline) bus->timeline->span(TL_FINISH, bus->serialNum, finishUs);
+}
+
+void DWIN2::updateRtt(dwinbus_t *bus, const uint8_t &lost)
+{
+    dwinrtt_t &rtt = bus->rtt[bus->groupClass];
+    const bool lateAnswers = bus->lateAnswers;
+    bus->lateAnswers = (lost > 0);
+    if (lost > 0)
+    {
+        // No sample, the late answers may come with the next group: back off the timeout
+        rtt.timeouts++;
+        rtt.timeoutMs = std::min<uint32_t>(rtt.timeoutMs*2, DWIN_RX_TIMEOUT_MAX_MS);
+        // The display may have dropped the frames, halve the pipeline
+        bus->pipelineDepth = std::max<uint8_t>(bus->pipelineDepth/2, 1);
+        return;
+    }
+    if ((bus->receivedFrames == 0) || lateAnswers) return;
+    const uint32_t sampleUs = bus->maxGapUs;
+
+    // Full group of writes: the acks later than usual mean the display falls behind,
+    // shorten the pipeline before it drops the frames, otherwise deepen it
+    if (bus->groupFull)
+    {
+        if ((rtt.samples > 0) && (sampleUs > rtt.srttUs + 2*rtt.rttvarUs))
+        {
+            if (bus->pipelineDepth > 1) bus->pipelineDepth--;
+        }
+        else if (bus->pipelineDepth < DWIN_PIPELINE_MAX)
+        {
+            bus->pipelineDepth++;
+        }
+    }
+
+    if (rtt.samples == 0)
+    {
+        rtt.srttUs = sampleUs;
+        rtt.rttvarUs = sampleUs/2;
+    }
+    else
+    {
+        const uint32_t err = (sampleUs > rtt.srttUs) ? sampleUs - rtt.srttUs : rtt.srttUs - sampleUs;
+        rtt.rttvarUs = (3*rtt.rttvarUs + err)/4;
+        rtt.srttUs = (7*rtt.srttUs + sampleUs)/8;
+    }
+    rtt.samples++;
+    // srtt + 4 rttvar, at least one tick more than srtt
+    const uint32_t timeoutUs = rtt.srttUs + std::max<uint32_t>(4*rtt.rttvarUs, 1000);
+    rtt.timeoutMs = std::min<uint32_t>(std::max<uint32_t>((timeoutUs + 999)/1000, DWIN_RX_TIMEOUT_MIN_MS), DWIN_RX_TIMEOUT_MAX_MS);
+}
+
+uint32_t DWIN2::groupWaitMs(dwinbus_t *bus)
+{
+    // Every frame of the group may take the longest timeout
+    uint32_t timeoutMs = 0;
+    for (size_t i = 0; i < DWIN_RTT_CLASSES; i++) timeoutMs = std::max<uint32_t>(timeoutMs, bus->rtt[i].timeoutMs);
+    // and the longest frame with its answer on the wire
+    const uint32_t frameWireMs = (wireUs(bus, 2*(0xFF + 3)) + 999)/1000;
+    return (timeoutMs + frameWireMs)*bus->pipelineDepth;
+}
+
+uint32_t DWIN2::wireUs(dwinbus_t *bus, const size_t &bytes)
+{
+    // Start, 8 data bits and stop per byte
+    const uint32_t baud = (bus->transport != nullptr) ? bus->transport->getBaud() : DWIN_BAUDRATE;
+    if (baud == 0) return 0;
+    return uint32_t(uint64_t(bytes)*10*1000000/baud);
+}
+
+bool DWIN2::waitAnswer(const uint16_t &vpHexAddr)
+{
+    if (_bus == nullptr) return false;
+    // Done as soon as the answer is in, the groups queued before it are waited for
+    while (waitRead(_bus, groupWaitMs(_bus)))
+    {
+        bool found = false;
+        if (dwinLock(_bus->uartMutex))
+        {
+            const dwinanswer_t &buffer = _bus->rxBuf;
+            found = (buffer.size() >= 7) && (buffer[3] == 0x83) &&
+                    (buffer[4] == highByte(vpHexAddr)) && (buffer[5] == lowByte(vpHexAddr));
+            dwinUnlock(_bus->uartMutex);
+        }
+        if (found) return true;
+    }
+    return false;
+}
+
+void DWIN2::pollBus(dwinbus_t *bus)
+{
+#ifdef DWIN_NO_RTOS
+    // Answers of the group sent before
+    if (bus->pendingFrames > 0)
+    {
+        receiveUart(bus);
+        if ((bus->receivedFrames < bus->pendingFrames) && (millis() - bus->rxTimeMs <= bus->groupTimeoutMs)) return;
+        finishGroup(bus);
+    }
+    // Take the next commands
+    if (bus->txPos >= bus->txBuf.size())
+    {
+        // Idle, the display may upload the values by itself
+        if (bus->uploadOn) receiveUploads(bus);
+        if (bus->cmdBuffer.size() == 0) return;
+        bus->txBuf.take(bus->cmdBuffer);
+        bus->txPos = 0;
+        if (bus->timeline) bus->timeline->span(TL_QUEUE, bus->serialNum, bus->queueUs, bus->txBuf.size());
+    }
+    sendGroup(bus);
+#else
+    // The bus task does the work
+    (void)bus;
+#endif
+}
+
+bool DWIN2::waitRead(dwinbus_t *bus, const uint32_t &timeoutMs)
+{
+#ifndef DWIN_NO_RTOS
+    return xSemaphoreTake(bus->readSem, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+#else
+    const uint32_t startMs = millis();
+    while (true)
+    {
+        if (bus->readReady)
+        {
+            bus->readReady = false;
+            return true;
+        }
+        if (millis() - startMs >= timeoutMs) return false;
+        pollBus(bus);
+        // Sleep until the answer bytes instead of spinning (epoll on the gateway)
+        if (bus->pendingFrames > 0) bus->transport->waitRx(1);
+    }
+#endif
+}
+
+void DWIN2::poll()
+{
+    if (_bus == nullptr) return;
+    pollBus(_bus);
+    for (uint8_t i = 0; i < _bus->mirrorCount; i++) pollBus(_bus->mirrors[i]);
+#ifdef DWIN_NO_RTOS
+    // Blink timers of the objects on the bus
+    for (uint8_t i = 0; i < _bus->clientCount; i++)
+    {
+        DWIN2 *dwp = _bus->clients[i];
+        if (dwp->_blinkTimerOn && (millis() - dwp->_blinkTimeMs >= dwp->_blinkPeriod/1000))
+        {
+            dwp->_blinkTimeMs = millis();
+            blinkTmr(dwp);
+        }
+    }
+#endif
+}
+
+size_t DWIN2::pendingTxBytes()
+{
+    if (_bus == nullptr) return 0;
+    size_t bytes = 0;
+    if (dwinLock(_bus->bufferMutex))
+    {
+        bytes = _bus->cmdBuffer.size();
+        dwinUnlock(_bus->bufferMutex);
+    }
+    // Taken by the bus and not sent yet
+    if (_bus->txPos < _bus->txBuf.size()) bytes += _bus->txBuf.size() - _bus->txPos;
+    return bytes;
+}
+
+uint32_t DWIN2::nextDeadline()
+{
+    if (_bus == nullptr) return DWIN_NO_DEADLINE;
+    uint32_t deadline = DWIN_NO_DEADLINE;
+    if (_bus->pendingFrames > 0)
+    {
+        // Answers are received in the background, the timeout ends the group
+        const uint32_t elapsed = millis() - _bus->rxTimeMs;
+        deadline = elapsed < _bus->groupTimeoutMs ? _bus->groupTimeoutMs - elapsed : 0;
+        if (_bus->transport->available() > 0) deadline = 0;
+    }
+    else if (pendingTxBytes() > 0)
+    {
+        deadline = 0;
+    }
+    else if (_bus->uploadOn && (_bus->transport->available() > 0))
+    {
+        deadline = 0;
+    }
+#ifdef DWIN_NO_RTOS
+    for (uint8_t i = 0; i < _bus->clientCount; i++)
+    {
+        const DWIN2 *dwp = _bus->clients[i];
+        if (!dwp->_blinkTimerOn) continue;
+        const uint32_t period = dwp->_blinkPeriod/1000;
+        const uint32_t elapsed = millis() - dwp->_blinkTimeMs;
+        deadline = std::min<uint32_t>(deadline, elapsed < period ? period - elapsed : 0);
+    }
+#endif
+    return deadline;
+}
+
+void DWIN2::setTrace(DwinTrace *trace)
+{
+    if (_bus == nullptr) return;
+    _bus->trace = trace;
+}
+
+void DWIN2::setUploadHandler(UploadFunction f)
+{
+    upload_cb = f;
+    if ((_bus == nullptr) || (f == NULL) || _bus->uploadOn) return;
+    _bus->uploadOn = true;
+#ifndef DWIN_NO_RTOS
+    // Wake the bus task waiting for the commands
+    xSemaphoreGive(_bus->writeSem);
+#endif
+}
+
+size_t DWIN2::serviceUploads()
+{
+    if ((_bus == nullptr) || !_bus->uploadOn) return 0;
+    size_t count = 0;
+    // Max frame: the length byte and the header
+    uint8_t frame[0xFF + 3];
+    uint16_t data[DWIN_MAX_BLOCK_WORDS];
+    while (true)
+    {
+        // Take one frame, the bus task may add the next ones meanwhile
+        uint32_t rxUs = 0;
+        size_t frameLen = 0;
+        if (!dwinLock(_bus->uartMutex)) break;
+        if (_bus->uploads.size() >= 7)
+        {
+            const uint8_t *p = _bus->uploads.data();
+            rxUs = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+            frameLen = p[6] + 3;
+            memcpy(frame, &p[4], std::min<size_t>(frameLen, sizeof(frame)));
+            _bus->uploads.erase(4 + frameLen);
+        }
+        dwinUnlock(_bus->uartMutex);
+        if (frameLen == 0) break;
+        count++;
+
+        const uint16_t vp = (frame[4] << 8) | frame[5];
+        const uint8_t words = std::min<size_t>(std::min<size_t>(frame[6], (frameLen - 7)/2), DWIN_MAX_BLOCK_WORDS);
+        dwinBeToHost16(data, &frame[7], words);
+        if (_bus->latency) _bus->latency->uploaded(vp, rxUs, micros());
+
+        // Handlers of the objects of this VP
+        DWIN2 *clients[DWIN_MAX_CLIENTS];
+        uint8_t clientCount = 0;
+        if (dwinLock(_bus->bufferMutex))
+        {
+            clientCount = _bus->clientCount;
+            std::copy(_bus->clients, _bus->clients + clientCount, clients);
+            dwinUnlock(_bus->bufferMutex);
+        }
+        for (uint8_t i = 0; i < clientCount; i++)
+        {
+            if ((clients[i]->upload_cb == NULL) || (clients[i]->_vpHexAddr != vp)) continue;
+            const uint32_t callbackUs = micros();
+            clients[i]->upload_cb(*clients[i], data, words);
+            if (_bus->timeline) _bus->timeline->span(TL_CALLBACK, _bus->serialNum, callbackUs, vp);
+        }
+    }
+    return count;
+}
+
+void DWIN2::setLatency(DwinLatency *latency)
+{
+    if (_bus == nullptr) return;
+    _bus->latency = latency;
+}
+
+void DWIN2::setTimeline(DwinTimeline *timeline)
+{
+    if (_bus == nullptr) return;
+    _bus->timeline = timeline;
+}
+
+dwinstat_t DWIN2::getStat()
+{
+    dwinstat_t stat;
+    memset(&stat, 0, sizeof(stat));
+    if (_bus == nullptr) return stat;
+    std::copy(_bus->rtt, _bus->rtt + DWIN_RTT_CLASSES, stat.rtt);
+    stat.pipelineDepth = _bus->pipelineDepth;
+    stat.queuedFrames = _bus->queuedFrames;
+    stat.doneFrames = _bus->doneFrames;
+    stat.lostFrames = _bus->lostFrames;
+    return stat;
+}
+
+void DWIN2::wait(const uint32_t &ms)
+{
+#ifndef DWIN_NO_RTOS
+    vTaskDelay(pdMS_TO_TICKS(ms));
+#else
+    const uint32_t startMs = millis();
+    do
+    {
+        poll();
+        // Nothing to do until the deadline: sleep in the transport until the answer bytes.
+        // Mirrors have their own deadlines, then the bus is polled
+        const uint32_t elapsedMs = millis() - startMs;
+        if ((_bus != nullptr) && (_bus->mirrorCount == 0) && (elapsedMs < ms))
+        {
+            const uint32_t idleMs = std::min<uint32_t>(nextDeadline(), ms - elapsedMs);
+            if (idleMs > 0) _bus->transport->waitRx(idleMs);
+        }
+    } while (millis() - startMs < ms);
+#endif
+}
+
 String DWIN2::utf16_to_utf8(const uint16_t *utf16, size_t utf16_len)
 {
     String utf8_str;
@@ -984,10 +2400,16 @@ uint8_t DWIN2::getPage()
     unsigned char command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, 0x00, 0x14, 0x01};
     // Send data to uartTask
     sendUart(command, commandLen);
-    while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-    std::vector<uint8_t> buf = _uartRxBuf;
-    if (buf.size() >= 8) return buf.at(8);
-    return 0;
+    if (_bus == nullptr) return 0;
+    waitAnswer(0x0014);
+    uint8_t val = 0;
+    // Read the answer in place, without a copy
+    if (dwinLock(_bus->uartMutex))
+    {
+        if (_bus->rxBuf.size() > 8) val = _bus->rxBuf[8];
+        dwinUnlock(_bus->uartMutex);
+    }
+    return val;
 }
 
 void DWIN2::setBrightness(const uint8_t &brightness)
@@ -1006,10 +2428,16 @@ uint8_t DWIN2::getBrightness()
     unsigned char command[commandLen] = {0x5A, 0xA5, 0x04, 0x83, 0x00, 0x31, 0x01};
     // Send data to uartTask
     sendUart(command, commandLen);
-    while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-    std::vector<uint8_t> buf = _uartRxBuf;
-    if (buf.size() >= 8) return buf.at(8);
-    return 0;
+    if (_bus == nullptr) return 0;
+    waitAnswer(0x0031);
+    uint8_t val = 0;
+    // Read the answer in place, without a copy
+    if (dwinLock(_bus->uartMutex))
+    {
+        if (_bus->rxBuf.size() > 8) val = _bus->rxBuf[8];
+        dwinUnlock(_bus->uartMutex);
+    }
+    return val;
 }
 
 void DWIN2::restartHMI()
@@ -1018,10 +2446,37 @@ void DWIN2::restartHMI()
     unsigned char command[commandLen] = {0x5A, 0xA5, 0x07, 0x82, 0x00, 0x04, 0x55, 0xAA, 0x5A, 0xA5};
     // Send data to uartTask
     sendUart(command, commandLen);
-    delay(100);
+    // The display restarts instead of the answer, then boots
+    flush(100);
+    if (!waitReady()) Serial.printf("ID%d ERR restartHMI() no answer after restart\n", _id);
 }
 
 
+size_t DWIN2::hexBufBlockProcessing(const dwinanswer_t &buffer, const uint16_t &vpHexAddr, uint16_t *data, const size_t &count)
+{
+    size_t pos = 0;
+    // Walk through the frames: 0x5A 0xA5 len 0x83 VP VP words data...
+    while (pos + 7 <= buffer.size())
+    {
+        if ((buffer[pos] != 0x5A) || (buffer[pos+1] != 0xA5))
+        {
+            pos++;
+            continue;
+        }
+        const size_t frameLen = buffer[pos+2] + 3;
+        if ((buffer[pos+3] == 0x83) && (buffer[pos+4] == highByte(vpHexAddr)) && (buffer[pos+5] == lowByte(vpHexAddr)))
+        {
+            size_t words = std::min<size_t>(buffer[pos+6], count);
+            // Do not read beyond the received bytes
+            if (pos + 7 + words*2 > buffer.size()) words = (buffer.size() - pos - 7)/2;
+            dwinBeToHost16(data, &buffer[pos+7], words);
+            return words;
+        }
+        pos += frameLen;
+    }
+    return 0;
+}
+
 uint8_t DWIN2::getVarIconIndex()
 {
     if (_uitype != ICON) return 0;
@@ -1039,11 +2494,16 @@ uint8_t DWIN2::getVarIconIndex()
 
     // Send data to uartTask
     sendUart(command, commandLen);
-    while (xSemaphoreTake(_uartUiReadSem, pdMS_TO_TICKS(100)) == pdTRUE){};
-    std::vector<uint8_t> buffer = _uartRxBuf; // Копируем полученные данные в буфер
-    if ((buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
+    if (_bus == nullptr) return 0;
+    waitAnswer(_vpHexAddr);
+    if (dwinLock(_bus->uartMutex))
     {
-        num = static_cast<uint16_t>(buffer[7] << 8) | static_cast<uint16_t>(buffer[8]);
+        const dwinanswer_t &buffer = _bus->rxBuf;
+        if ((buffer.size() > 8) && (buffer[3] == 0x83) && (buffer[4] == highByte(_vpHexAddr)) && (buffer[5] == lowByte(_vpHexAddr)))
+        {
+            num = static_cast<uint16_t>(buffer[7] << 8) | static_cast<uint16_t>(buffer[8]);
+        }
+        dwinUnlock(_bus->uartMutex);
     }
     return num;
 }
\ No newline at end of file
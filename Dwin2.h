@@ -1,6 +1,7 @@
 //***************************************************
 //* Library to simplify working with DWIN Displays  *
 //* Lib use FreeRTOS, so for ESP32 only             *
+//* (or DWIN_NO_RTOS with the poll() calls)         *
 //* Copyright (C) 2024 Pavel Pervushkin.  Ver.1.0.2 *
 //* Released under the MIT license.                 *
 //***************************************************
@@ -9,25 +10,79 @@
 #ifndef Dwin2_h
 #define Dwin2_h
 
+// Define DWIN_NO_RTOS to build without tasks and semaphores:
+// the bus is advanced by the poll() calls from the main loop
+// Define DWIN_LINUX to build for a Linux gateway (DwinLinuxSerial transport, poll() mode),
+// Arduino.h is then the Arduino API layer of the gateway (String, Serial, millis())
+#if defined(DWIN_LINUX) && !defined(DWIN_NO_RTOS)
+#define DWIN_NO_RTOS
+#endif
 #include <Arduino.h>
+#ifndef DWIN_NO_RTOS
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
+#endif
 #include "vector"
-#include <codecvt>
-#include <locale>
-#include <HardwareSerial.h>
+#ifndef DWIN_NO_HEAP
+#include <map>
+#endif
+#include <DwinTransport.h>
 
 
 #define BUFSIZE 256
+// Default HardwareSerial number connected to the display
+#ifndef HW_SERIAL_NUM
 #define HW_SERIAL_NUM 2
+#endif
+// Number of UART ports, one display per port
+#define DWIN_MAX_BUSES 3
+// Capacity of the queue of commands waiting to be sent to the display
+#define DWIN_TXBUFSIZE 2048
+// UART driver RX ring size and event queue length
+#define DWIN_RXBUFSIZE 1024
+#define DWIN_UART_EVENTS 16
+// Max time between the bytes of the display answers until the round-trip time is measured,
+// then the timeout of each command class follows its round-trip time within the bounds.
+// The time of the group and its answers on the wire is added to the timeout
+#define DWIN_RX_TIMEOUT_MS 30
+#define DWIN_RX_TIMEOUT_MIN_MS 10
+#define DWIN_RX_TIMEOUT_MAX_MS 500
+// Max number of VP words in one read/write frame (frame length byte is limited to 0xFF)
+#define DWIN_MAX_BLOCK_WORDS 124
+// Number of write frames sent one after another before waiting for the display acks:
+// the start value, then adapted between 1 and DWIN_PIPELINE_MAX by the acks
+#define DWIN_PIPELINE_DEPTH 4
+#define DWIN_PIPELINE_MAX 8
+// Capacity of the answers to one group of frames
+#define DWIN_ANSWER_BUFSIZE 512
+// Max number of DWIN2 objects begun on one port
+#define DWIN_MAX_CLIENTS 64
+// User VP area kept by the shadow state for resync(), the system variables below are not replayed
+#define DWIN_SHADOW_MIN_VP 0x1000
+// Area kept when no shadow ranges are added, the uploader (0x8000) and store (0xC000) buffers are above
+#define DWIN_SHADOW_MAX_VP 0x7FFF
+// Entries of the shadow range table: kept and excluded VP ranges
+#define DWIN_SHADOW_RANGES 8
+// Page switch system variable
+#define DWIN_PAGE_VP 0x0084
+// Capacity of the auto-upload frames received and not yet passed to the handlers, see serviceUploads()
+#define DWIN_UPLOAD_BUFSIZE 512
+// Define DWIN_NO_HEAP to build without the heap containers in the DWIN2 API:
+// callbacks are plain functions, option lists are arrays of C strings.
+// Bus buffers have fixed capacities in both builds, sending and reading
+// make no heap allocations after begin()
 
 typedef enum {
     INT,
     DOUBLE,
     UTF,
     ASCII,
-    ICON
+    ICON,
+    // IEEE single float, 2 VP words
+    FLOAT,
+    // int32, 2 VP words
+    LONG
 } uitype_t;
 
 typedef struct {
@@ -35,6 +90,271 @@ typedef struct {
     uint8_t *cmd;
 } cmdtype_t;
 
+class DWIN2;
+class DwinTrace;
+class DwinLatency;
+class DwinTimeline;
+
+// Byte buffer of fixed capacity N, no heap allocations
+template<size_t N>
+class DwinBuffer
+{
+private:
+    uint8_t _data[N];
+    size_t _size = 0;
+
+public:
+    static constexpr size_t capacity() { return N; }
+    size_t size() const { return _size; }
+    uint8_t *data() { return _data; }
+    const uint8_t *begin() const { return _data; }
+    const uint8_t *end() const { return _data + _size; }
+    uint8_t &operator[](const size_t &i) { return _data[i]; }
+    const uint8_t &operator[](const size_t &i) const { return _data[i]; }
+    void clear() { _size = 0; }
+    // Append len bytes, false if they do not fit
+    bool append(const uint8_t *src, const size_t &len)
+    {
+        if (_size + len > N) return false;
+        memcpy(&_data[_size], src, len);
+        _size += len;
+        return true;
+    }
+    // Change the size up to the capacity, new bytes are not initialized
+    void resize(const size_t &len) { _size = len < N ? len : N; }
+    // Remove len bytes from the front
+    void erase(const size_t &len)
+    {
+        const size_t n = len < _size ? len : _size;
+        memmove(_data, &_data[n], _size - n);
+        _size -= n;
+    }
+    // Remove len bytes at pos
+    void remove(const size_t &pos, const size_t &len)
+    {
+        if (pos >= _size) return;
+        const size_t n = len < _size - pos ? len : _size - pos;
+        memmove(&_data[pos], &_data[pos + n], _size - pos - n);
+        _size -= n;
+    }
+    // Take the content of other, other is cleared
+    template<size_t M> void take(DwinBuffer<M> &other)
+    {
+        clear();
+        append(other.data(), other.size());
+        other.clear();
+    }
+};
+
+// State of a read queued by DWIN2::readAsync()
+typedef enum {
+    DWIN_READ_IDLE,
+    DWIN_READ_PENDING,
+    DWIN_READ_DONE,
+    // Sent, the group ended without its answer, or not waited for any more
+    DWIN_READ_LOST
+} dwinreadstate_t;
+
+// Read completed by the bus when its answer frame is parsed, the caller does not wait
+typedef struct dwinread_t {
+    uint16_t vp;
+    // Words to read, 1..DWIN_MAX_BLOCK_WORDS
+    uint8_t count;
+    uint16_t *data;
+    volatile dwinreadstate_t state;
+    dwinread_t *next;
+} dwinread_t;
+
+// Command classes with their own round-trip time: the display takes longer for the system
+// variables (page switch, flash, touch simulation) than for the user VPs
+typedef enum {
+    DWIN_RTT_WRITE,
+    DWIN_RTT_READ,
+    DWIN_RTT_SYSTEM,
+    DWIN_RTT_CLASSES
+} dwinrttclass_t;
+
+// Round-trip time of a command class, TCP-style (RFC 6298): smoothed time and variance of the
+// longest wait for an answer frame in a group less its bytes on the wire, the answer timeout
+// derived from them
+typedef struct {
+    uint32_t srttUs;
+    uint32_t rttvarUs;
+    uint32_t timeoutMs;
+    uint32_t samples;
+    // Groups ended by the timeout, the timeout is doubled for the next group
+    uint32_t timeouts;
+} dwinrtt_t;
+
+// Statistics of the port, see DWIN2::getStat()
+typedef struct {
+    dwinrtt_t rtt[DWIN_RTT_CLASSES];
+    uint8_t pipelineDepth;
+    uint32_t queuedFrames;
+    uint32_t doneFrames;
+    uint32_t lostFrames;
+} dwinstat_t;
+
+// Frames queued on the bus and its mirrors up to a moment, see DWIN2::markFlush()
+typedef struct {
+    uint8_t busCount;
+    uint32_t target[DWIN_MAX_BUSES + 1];
+    uint32_t lost[DWIN_MAX_BUSES + 1];
+} dwinflush_t;
+
+// VP range of the shadow state, see DWIN2::addShadowRange()
+typedef struct {
+    uint16_t vp;
+    uint16_t count;
+    bool exclude;
+} dwinshadowrange_t;
+
+typedef DwinBuffer<DWIN_TXBUFSIZE> dwintxbuf_t;
+typedef DwinBuffer<DWIN_ANSWER_BUFSIZE> dwinanswer_t;
+
+#ifndef DWIN_NO_RTOS
+typedef SemaphoreHandle_t dwinlock_t;
+#else
+// Nothing to lock in the poll() mode
+typedef uint8_t dwinlock_t;
+#endif
+
+// Mutexes of the bus, the trace and the timeline, nothing to lock in the poll() mode
+static inline bool dwinLock(dwinlock_t &lock)
+{
+#ifndef DWIN_NO_RTOS
+    return xSemaphoreTake(lock, portMAX_DELAY) == pdTRUE;
+#else
+    (void)lock;
+    return true;
+#endif
+}
+
+static inline void dwinUnlock(dwinlock_t &lock)
+{
+#ifndef DWIN_NO_RTOS
+    xSemaphoreGive(lock);
+#else
+    (void)lock;
+#endif
+}
+// No deadline of the bus, see nextDeadline()
+#define DWIN_NO_DEADLINE 0xFFFFFFFF
+
+// UART port of one display, shared by all DWIN2 objects begun on it.
+// Each bus has its own buffers, mutexes and task (or is polled)
+typedef struct dwinbus_t {
+    uint8_t serialNum;
+    // Bytes of the port: ESP-IDF UART driver by default, see DwinTransport
+    DwinTransport *transport;
+    bool started;
+    // Commands waiting for the bus task
+    dwintxbuf_t cmdBuffer;
+    // Commands taken by the bus task, the next group of frames starts at txPos
+    dwintxbuf_t txBuf;
+    size_t txPos;
+    // Group of frames sent and waiting for the answers
+    size_t groupStart;
+    uint8_t pendingFrames;
+    uint8_t receivedFrames;
+    size_t frameStart;
+    uint32_t rxTimeMs;
+    // Round-trip time of the command classes and the pipeline depth, adapted after each group
+    dwinrtt_t rtt[DWIN_RTT_CLASSES];
+    uint8_t pipelineDepth;
+    // Group in flight: its class and answer timeout, the last answer frame and the longest wait for one
+    dwinrttclass_t groupClass;
+    bool groupFull;
+    uint32_t groupTimeoutMs;
+    uint32_t answerUs;
+    uint32_t maxGapUs;
+    // Start of the group tx and the end of the frame answered next in txBuf, for the wire time of the waits
+    uint32_t groupTxUs;
+    size_t answerTxPos;
+    // The group before lost answers, they may be counted in this one: no sample (Karn)
+    bool lateAnswers;
+    // Display responses
+    dwinanswer_t rxBuf;
+    // Storing the response from the display
+    String echo;
+    // Mutex for UART
+    dwinlock_t uartMutex;
+    // Mutex for buffer
+    dwinlock_t bufferMutex;
+#ifndef DWIN_NO_RTOS
+    // Commands are queued, the buffer is free, responses are received
+    SemaphoreHandle_t writeSem;
+    SemaphoreHandle_t freeSem;
+    SemaphoreHandle_t readSem;
+    TaskHandle_t taskHandle;
+    // The bus task waits for the auto-upload frames, queueBus() wakes the wait
+    volatile bool rxIdle;
+#else
+    // Responses are received
+    bool readReady;
+#endif
+    // Core and priority of the bus task
+    uint8_t core;
+    uint8_t priority;
+    // Frames queued, processed by the bus task and left without answer
+    volatile uint32_t queuedFrames;
+    volatile uint32_t doneFrames;
+    volatile uint32_t lostFrames;
+    // Objects using the bus, for the echo callbacks
+    DWIN2 *clients[DWIN_MAX_CLIENTS];
+    uint8_t clientCount;
+    // Buses getting a copy of every command sent to this bus
+    dwinbus_t *mirrors[DWIN_MAX_BUSES];
+    uint8_t mirrorCount;
+    // Capture of the bytes sent and received, see DwinTrace
+    DwinTrace *trace;
+    // Async reads waiting for their answers in the order queued, guarded by uartMutex
+    dwinread_t *asyncReads;
+    // Auto-upload frames are received while the bus is idle (an object has the upload handler)
+    bool uploadOn;
+    // Bytes received while idle and the bytes after the last answer of a group, the next complete frames
+    dwinanswer_t uploadRx;
+    // Auto-upload frames for serviceUploads(), each after its receive time in us, guarded by uartMutex
+    DwinBuffer<DWIN_UPLOAD_BUFSIZE> uploads;
+    volatile uint32_t lostUploads;
+    // Touch-to-feedback latency measurement, see DwinLatency
+    DwinLatency *latency;
+    // Operations of the bus in time, see DwinTimeline: the queue got its first command, the group was sent
+    DwinTimeline *timeline;
+    uint32_t queueUs;
+    uint32_t txDoneUs;
+#ifndef DWIN_NO_HEAP
+    // Shadow state: the last word written to each user VP and the last page, replayed by resync()
+    bool shadowOn;
+    std::map<uint16_t, uint16_t> shadow;
+    int16_t shadowPage;
+    // VP ranges kept and excluded by the shadow state
+    dwinshadowrange_t shadowRanges[DWIN_SHADOW_RANGES];
+    uint8_t shadowRangeQty;
+#endif
+} dwinbus_t;
+
+// Element of the DGUS project: addresses, type, text length in bytes and page
+typedef struct {
+    uint16_t vp;
+    uint16_t sp;
+    uitype_t type;
+    uint16_t textLen;
+    uint8_t page;
+} dwinelem_t;
+
+// Element known at compile time, generated from the DGUS project by tools/dwin_map_gen.py
+template<uitype_t TYPE, uint16_t VP, uint16_t SP, uint16_t TEXTLEN = 0, uint8_t PAGE = 0>
+struct DwinVar
+{
+    static constexpr uitype_t type = TYPE;
+    static constexpr uint16_t vp = VP;
+    static constexpr uint16_t sp = SP;
+    static constexpr uint16_t textLen = TEXTLEN;
+    static constexpr uint8_t page = PAGE;
+    static constexpr dwinelem_t elem() { return {VP, SP, TYPE, TEXTLEN, PAGE}; }
+};
+
 typedef enum {
     RED,
     BLUE,
@@ -64,6 +384,10 @@ class DWIN2
 private:
     // Increment/decrement text or numeric integer data by delta
     void increment(const double &delta);
+    // Change _currentVal by delta in the _rightDir direction, within the limits
+    void stepValue(const double &delta);
+    // Send _currentVal as the number or the text list item
+    void sendCurrentVal();
 
     // Send a command to read the numeric value of the UI element
     void sendReadUiNumCmd();
@@ -73,48 +397,104 @@ private:
     void sendReadUiTextCmd(const uint8_t &maxTextSize);
 
     // Response processing after sending sendReadUiNumCmd() or sendReadUiTextCmd() commands
-    int hexBufIntProcessing(const std::vector<uint8_t> &buffer);
-    double hexBufDblProcessing(const std::vector<uint8_t> &buffer);
-    String hexBufUtfProcessing(const std::vector<uint8_t> &buffer);
-    String hexBufAsciiProcessing(const std::vector<uint8_t> &buffer);
+    int hexBufIntProcessing(const dwinanswer_t &buffer);
+    int32_t hexBufLongProcessing(const dwinanswer_t &buffer);
+    float hexBufFloatProcessing(const dwinanswer_t &buffer);
+    double hexBufDblProcessing(const dwinanswer_t &buffer);
+    String hexBufUtfProcessing(const dwinanswer_t &buffer);
+    String hexBufAsciiProcessing(const dwinanswer_t &buffer);
+
+    // Write commands for the given VP, without ui type checks
+    void sendVpWord(const uint16_t &vpHexAddr, const uint16_t &data);
+    void sendVpLong(const uint16_t &vpHexAddr, const int32_t &data);
+    void sendVpFloat(const uint16_t &vpHexAddr, const float &data);
+    void sendVpDouble(const uint16_t &vpHexAddr, const double &data);
+    void sendVpText(const uitype_t &uitype, const uint16_t &vpHexAddr, const char *data);
 
     // Send command to send over UART, with mutex
-    void sendUart(const uint8_t *command, const uint8_t &cmdLength);
-
-    static String _dwinEcho;   // Storing the response from the display
+    void sendUart(const uint8_t *command, const size_t &cmdLength);
+    // Copy the command into the buffer of the bus, waits while the buffer is full
+    static void queueBus(dwinbus_t *bus, const uint8_t *command, const size_t &cmdLength);
+#ifndef DWIN_NO_HEAP
+    // Keep the VP writes of the commands in the shadow state of the bus
+    static void updateShadow(dwinbus_t *bus, const uint8_t *command, const size_t &cmdLength);
+    // The VP is kept by the shadow state: in a kept range and not in an excluded one
+    static bool isShadowed(const dwinbus_t *bus, const uint16_t &vp);
+    // Add the range to the shadow range table and drop the words no longer kept
+    bool setShadowRange(const uint16_t &vp, const uint16_t &count, const bool &exclude);
+#endif
+    // Read display responses into rxBuf of the bus until the frames of the group are received
+    static void receiveUart(dwinbus_t *bus);
+    // Send the next group of frames from txBuf. Returns false if there are no frames left
+    static bool sendGroup(dwinbus_t *bus);
+    // Count the complete answer frames in rxBuf, the auto-upload frames are moved to the uploads
+    static void countAnswers(dwinbus_t *bus);
+    // The frame is a VP read not sent by the group: the display uploaded it by itself
+    static bool isUpload(dwinbus_t *bus, const uint8_t *frame);
+    // Keep the auto-upload frame with its receive time for serviceUploads()
+    static void storeUpload(dwinbus_t *bus, const uint8_t *frame, const uint32_t &rxUs);
+    // Read the auto-upload frames received while the bus is idle
+    static void receiveUploads(dwinbus_t *bus);
+    // Answers of the group are received or timed out: counters, readers and echo
+    static void finishGroup(dwinbus_t *bus);
+    // Take the round-trip time of the finished group, adapt the timeouts and the pipeline depth
+    static void updateRtt(dwinbus_t *bus, const uint8_t &lost);
+    // Longest time one group of frames may take
+    static uint32_t groupWaitMs(dwinbus_t *bus);
+    // Time of the bytes on the wire at the line speed of the bus
+    static uint32_t wireUs(dwinbus_t *bus, const size_t &bytes);
+    // Wait for the groups until the last answer is the read of vpHexAddr, false on timeout
+    bool waitAnswer(const uint16_t &vpHexAddr);
+    // Copy the answers of the group to the async reads, the reads sent without answer are lost
+    static void completeReads(dwinbus_t *bus);
+    // Remove the read from the async reads of the bus
+    static void unlinkRead(dwinbus_t *bus, dwinread_t *read);
+    // Advance the bus: send, receive, timeouts (poll() mode)
+    static void pollBus(dwinbus_t *bus);
+    // Wait for the answer to the read command, true if it is received
+    static bool waitRead(dwinbus_t *bus, const uint32_t &timeoutMs);
+    // Bus of the serial port, created on the first call
+    static dwinbus_t *getBus(const uint8_t &serialNum);
+    // Start UART and the task of the bus, if not started yet
+    static bool startBus(dwinbus_t *bus, const uint8_t &rxPin, const uint8_t &txPin);
+    // Send the command changing the element, or keep it until the page is prepared if deferred
+    void sendElementCmd(const uint8_t *command, const size_t &cmdLength);
+    // Find the response to the read command of vpHexAddr in the buffer and copy its words to data
+    static size_t hexBufBlockProcessing(const dwinanswer_t &buffer, const uint16_t &vpHexAddr, uint16_t *data, const size_t &count);
 
     // Data from the response of the sent command
     String _uiData = "";
     bool _echo; // Listen to the response from the display
 
     // Handle blinking of UI elements
+#ifndef DWIN_NO_RTOS
     esp_timer_handle_t _blinkTimerHandle;
+#else
+    // Blink timer is advanced by poll()
+    bool _blinkTimerOn = false;
+    uint32_t _blinkTimeMs = 0;
+#endif
     static void blinkTmr(void *arg);
     uint64_t _blinkPeriod;
+    void startBlinkTimer();
+    void stopBlinkTimer();
 
     // Blink status
     static bool _isBlink;
     void blinkUI(bool state);
 
     // Communication with the display via uart
-    static HardwareSerial *_uart;
+    static dwinbus_t *_buses[DWIN_MAX_BUSES];
+    dwinbus_t *_bus = nullptr;
 
     uint16_t _spHexAddr;
     uint16_t _vpHexAddr;
     uitype_t _uitype;
     uint8_t _id;
 
-    // Buffer for storing the command
-    static std::vector<uint8_t> _uartCmdBuffer;  
- 
-    // Read UART
-    static std::vector<uint8_t> _uartRxBuf;
-    SemaphoreHandle_t _uartUiReadSem; // Binary semaphore
-
-    // Mutex for UART
-    static SemaphoreHandle_t _uartMutex;
-    // Mutex for buffer
-    static SemaphoreHandle_t _bufferMutex;
+    // Element commands kept while the element page is not shown
+    bool _deferred = false;
+    std::vector<uint8_t> _pendingCmd;
 
     // Limits and delta
     int _minVal;
@@ -122,20 +502,24 @@ private:
     double _delta;
     // Current value for UI element
     double _currentVal;
+    // Decimal places of the fixed point INT and LONG values
+    uint8_t _decimals = 0;
+    // Fixed point value of the INT/LONG element: round(val*10^decimals)
+    int32_t toFixed(const double &val);
     // Storing a text array for the UI element
+#ifndef DWIN_NO_HEAP
     std::vector<String> _listStrVal;
+#endif
+    // Or the array of C strings given by setStrListVal(list, count)
+    const char *const *_listStr = nullptr;
+    size_t _listStrCount = 0;
+    // Size and items of the text list
+    size_t listSize();
+    const char *listItem(const size_t &index);
     // Rotation direction (for Encoder knob)
     bool _rightDir;
     bool _loopRotation;
 
-    void swapBytes(uint8_t* bytes, size_t size) {
-        for (size_t i = 0; i < size / 2; ++i) {
-            uint8_t temp = bytes[i];
-            bytes[i] = bytes[size - i - 1];
-            bytes[size - i - 1] = temp;
-        }
-    }
-
     String utf16_to_utf8(const uint16_t* utf16, size_t utf16_len);
 
     // Output array in HEX format
@@ -156,23 +540,71 @@ private:
     };
 
 protected:
+#ifndef DWIN_NO_HEAP
     typedef std::function<void(DWIN2 &uartcb)> CallbackFunction;
+#else
+    typedef void (*CallbackFunction)(DWIN2 &uartcb);
+#endif
     CallbackFunction uartEcho_cb = NULL;
     void _handleEchoUart();
+#ifndef DWIN_NO_HEAP
+    typedef std::function<void(DWIN2 &dwin, const uint16_t *data, const uint8_t &words)> UploadFunction;
+#else
+    typedef void (*UploadFunction)(DWIN2 &dwin, const uint16_t *data, const uint8_t &words);
+#endif
+    UploadFunction upload_cb = NULL;
 
     // Clearing the display buffer DWIN
     void clearRxBuf();
+    static void clearRxBuf(dwinbus_t *bus);
 
+#ifndef DWIN_NO_RTOS
     // Processing the response from sent commands to DWIN Display
-    static void uartTask(void* parameter); // Static method to be run in the thread
-    TaskHandle_t _taskHandleUart = nullptr; // FreeRTOS task descriptor
-    SemaphoreHandle_t _uartWriteSem; // Bynary counting semaphore
+    static void uartTask(void* parameter); // Static method to be run in the thread, one per bus
+#endif
 
 public:
     DWIN2();
     ~DWIN2();
 
-    void begin(const uint16_t &spHexAddr = 0, const uint16_t &vpHexAddr = 0, const uint8_t &rxPin = 16, const uint8_t &txPin = 17);
+    // Objects begun with the same serialNum share the UART port and its task
+    void begin(const uint16_t &spHexAddr = 0, const uint16_t &vpHexAddr = 0, const uint8_t &rxPin = 16, const uint8_t &txPin = 17, const uint8_t &serialNum = HW_SERIAL_NUM);
+    // Begin with the element from the generated DwinMap
+    void begin(const dwinelem_t &elem, const uint8_t &rxPin = 16, const uint8_t &txPin = 17, const uint8_t &serialNum = HW_SERIAL_NUM);
+    // Core and priority of the bus task, call before the first begin() on the port
+    static void setBusTask(const uint8_t &serialNum, const uint8_t &core, const uint8_t &priority = 1);
+    // Transport of the port instead of the ESP32 UART (DwinLinuxSerial, custom), call before the first begin() on the port.
+    // The transport must live while the port is used
+    static bool setTransport(const uint8_t &serialNum, DwinTransport *transport);
+    // Mirror mode: send a copy of every command of this object's bus to the display on serialNum.
+    // The frames are encoded once, answers are read from the main bus only
+    bool addMirror(const uint8_t &serialNum, const uint8_t &rxPin, const uint8_t &txPin);
+    // HardwareSerial number of the bus
+    uint8_t getSerialNum();
+    // Advance the bus and its mirrors: sending, answers, timeouts and blinking.
+    // Needed in the DWIN_NO_RTOS mode only, call it from the main loop
+    void poll();
+    // Bytes queued and not yet passed to the UART
+    size_t pendingTxBytes();
+    // Milliseconds until poll() has work to do: 0 - now, DWIN_NO_DEADLINE - nothing queued
+    uint32_t nextDeadline();
+    // Delay, the bus keeps working (polled in the DWIN_NO_RTOS mode)
+    void wait(const uint32_t &ms);
+    // Record the UART bytes of the port into the trace, nullptr stops the recording
+    void setTrace(DwinTrace *trace);
+    // Called with the words of the auto-upload frames of the object's VP (touch controls,
+    // keyboard input with the data auto-upload option). Enables the reception while the bus is idle
+    void setUploadHandler(UploadFunction f);
+    // Pass the received auto-upload frames of the port to the handlers, call from the loop.
+    // Returns the number of frames
+    size_t serviceUploads();
+    // Timestamp the stages of the touch-to-feedback path of the port, nullptr stops it
+    void setLatency(DwinLatency *latency);
+    // Record the operations of the port (enqueue, queue wait, tx, panel, rx, callbacks) into the timeline,
+    // nullptr stops the recording
+    void setTimeline(DwinTimeline *timeline);
+    // Round-trip times, answer timeouts and pipeline depth of the port, frames counters
+    dwinstat_t getStat();
 
     // Common methods
     // Set page number
@@ -183,8 +615,38 @@ public:
     void setBrightness(const uint8_t &brightness);
     // Get diaplay brightness
     uint8_t getBrightness();
-    // Restart display
+    // Restart display and wait until it answers again
     void restartHMI();
+    // Wait until the display answers the page register read, returns false on timeout
+    bool waitReady(const uint32_t &timeoutMs = 2000);
+    // Read one VP word without error messages, returns false if there is no answer in timeoutMs
+    bool readWord(const uint16_t &vpHexAddr, uint16_t &data, const uint32_t &timeoutMs = 100);
+#ifndef DWIN_NO_HEAP
+    // Keep the shadow state of the port: the last value of every user VP written and the page
+    void setShadow(const bool &enable);
+    // VPs kept by the shadow state. Until a range is added, DWIN_SHADOW_MIN_VP..DWIN_SHADOW_MAX_VP is kept
+    bool addShadowRange(const uint16_t &vp, const uint16_t &count);
+    // VPs never kept: VP buffers of DwinUploader and DwinStore (excluded by them), scratch areas
+    bool excludeShadowRange(const uint16_t &vp, const uint16_t &count);
+    // Write the shadow state to the display again (after a display reset):
+    // the page, then the VP values joined into the max-size frames. Returns the number of words
+    size_t resync();
+#endif
+    // Join VP writes of the commands to the adjacent addresses into the max-size frames.
+    // Other commands and system VP writes stay in program order, a write overlapping an earlier one comes after it
+    static void coalesce(const std::vector<uint8_t> &commands, std::vector<uint8_t> &frames);
+    // Wait until all queued commands are sent and answered.
+    // Returns false on timeout or if some commands were not answered
+    bool flush(const uint32_t &timeoutMs = 1000);
+    // Non-blocking flush: mark the frames queued so far, then check them from the loop.
+    // checkFlush() returns true when they are sent and answered or timed out, ok is false if some were not answered
+    void markFlush(dwinflush_t &mark);
+    bool checkFlush(const dwinflush_t &mark, bool &ok);
+    // Queue a read of read.count words from read.vp without waiting. The bus copies the answer
+    // into read.data and sets read.state, read must live while it is pending. Returns false if not queued
+    bool readAsync(dwinread_t &read);
+    // Stop waiting for the read (timeout), returns its final state
+    dwinreadstate_t endRead(dwinread_t &read);
 
     // Methods for ui elements
     // Set the id of the object to be created
@@ -193,6 +655,11 @@ public:
     void setAddress(const uint16_t &spHexAddr, const uint16_t &vpHexAddr);
     // Select the UI type of the display element
     void setUiType(const uitype_t &uitype);
+    // Set addresses and UI type from the element descriptor
+    void setElement(const dwinelem_t &elem);
+    // Decimal places of the INT/LONG element (as set in the DGUS project),
+    // sendData(double) sends round(val*10^decimals), getUiData() returns the value with the decimals
+    void setDecimals(const uint8_t &decimals);
     // Set the min. and max. values, 
     // delta to increase/decrease the value
     void setLimits(const uint32_t &minVal, const uint32_t &maxVal, const bool &loopRotation = false);
@@ -201,7 +668,11 @@ public:
     // Setting the initial value
     void setStartVal(const double &currentVal);
     // Set a text list of values for UI elements
+#ifndef DWIN_NO_HEAP
     void setStrListVal(const std::vector<String> listStrVal);
+#endif
+    // Text list from an array of C strings, the array is not copied and must live while used
+    void setStrListVal(const char *const *listStr, const size_t &count);
     // Set blink rate in milliseconds
     void setBlinkPeriod(const uint64_t &blinkPeriodMs);
     // Setting the called colbeck function
@@ -212,6 +683,8 @@ public:
     // Overloaded function
     void setColor(uint16_t colorHex);
     void setColor(uicolor_t color);
+    // Color from the uicolor_t palette in DWIN HEX format (RGB565)
+    static uint16_t colorHex(const uicolor_t &color);
     // Dwin answer
     String getDwinEcho();
     // Blink ui element.
@@ -224,6 +697,42 @@ public:
     void sendData(const int &data);
     void sendData(const double &data);
     void sendData(const String &data);
+    void sendData(const char *data);
+    // Send data to the element from the generated DwinMap.
+    // The ui type is checked at compile time, e.g. dwc.sendData<DwinMap::Int_1000>(55)
+    template<class E> void sendData(const int &data)
+    {
+        static_assert((E::type == INT) || (E::type == LONG), "sendData() wrong ui type, should be INT or LONG");
+        if (E::type == LONG) sendVpLong(uint16_t(E::vp), data);
+        else sendVpWord(uint16_t(E::vp), data);
+    }
+    template<class E> void sendData(const double &data)
+    {
+        static_assert((E::type == DOUBLE) || (E::type == FLOAT), "sendData() wrong ui type, should be DOUBLE or FLOAT");
+        if (E::type == FLOAT) sendVpFloat(uint16_t(E::vp), data);
+        else sendVpDouble(uint16_t(E::vp), data);
+    }
+    template<class E> void sendData(const String &data)
+    {
+        static_assert((E::type == ASCII) || (E::type == UTF), "sendData() wrong ui type, should be text");
+        sendVpText(uitype_t(E::type), uint16_t(E::vp), data.c_str());
+    }
+    template<class E> void setVarIcon(const int &icoNum)
+    {
+        static_assert(E::type == ICON, "setVarIcon() wrong ui type, should be ICON");
+        sendVpWord(uint16_t(E::vp), icoNum);
+    }
+    // Encode the text write command for the text VP (ASCII or UTF ui type) without sending it
+    static bool encodeText(const uitype_t &uitype, const uint16_t &vpHexAddr, const String &data, std::vector<uint8_t> &command);
+    // The same into a buffer of DWIN_MAX_BLOCK_WORDS*2 + 6 bytes. Returns the command length, 0 on error
+    static size_t encodeText(const uitype_t &uitype, const uint16_t &vpHexAddr, const char *data, uint8_t *command);
+    // Write an array of VP words starting from vpHexAddr.
+    // Split into the max-size frames, which are queued at once
+    void writeBlock(const uint16_t &vpHexAddr, const uint16_t *data, const size_t &count);
+    void writeBlock(const uint16_t &vpHexAddr, const std::vector<uint16_t> &data);
+    // Read count VP words starting from vpHexAddr. Returns the number of words read
+    size_t readBlock(const uint16_t &vpHexAddr, uint16_t *data, const size_t &count);
+    std::vector<uint16_t> readBlock(const uint16_t &vpHexAddr, const size_t &count);
     // Set Variables Icon
     void setVarIcon(const int &icoNum);
     // Set UI-element position
@@ -232,8 +741,16 @@ public:
     void sendRawCommand(const uint8_t *cmd, const size_t &cmdLength);
     // Increment/decrement the value by a specified delta depending on the direction when calling the method
     void update(const double &delta = 1.0, const bool &rightDir = true);
-    // Clearing the text field
+    // The same as |steps| update() calls (steps > 0 - right direction), with one frame of the final value.
+    // Nothing is sent if the value stays at the limit
+    void updateSteps(const int32_t &steps, const double &delta = 1.0);
+    // Clearing the text field with one 0xFFFF terminator word, length is not used
     void clearText(uint8_t length = 10);
+    // Keep the element commands instead of sending them (element page is not shown)
+    void setDeferred(const bool &deferred);
+    bool getDeferred();
+    // Move the kept commands to the end of commands
+    void takePending(std::vector<uint8_t> &commands);
     // Get blink status
     bool getBlinkStatus();
     // Get the current value (as a number for int and dbl values and as an index for text values)
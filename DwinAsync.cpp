@@ -0,0 +1,207 @@
+#include <DwinAsync.h>
+
+#ifdef DWIN_COROUTINES
+// Define static variables
+DwinTask::handle_t DwinAsync::_tasks[ASYNC_MAX_TASKS] = {};
+alignas(16) uint8_t DwinAsync::_frames[ASYNC_MAX_TASKS][ASYNC_FRAME_SIZE];
+bool DwinAsync::_frameUsed[ASYNC_MAX_TASKS] = {};
+
+//***********************************************************************************************************************
+//************* DWIN Task class *****************************************************************************************
+//***********************************************************************************************************************
+void *DwinTask::promise_type::operator new(size_t size) noexcept
+{
+    return DwinAsync::allocFrame(size);
+}
+
+void DwinTask::promise_type::operator delete(void *ptr) noexcept
+{
+    DwinAsync::freeFrame(ptr);
+}
+
+//***********************************************************************************************************************
+//************* DWIN Async awaitables ***********************************************************************************
+//***********************************************************************************************************************
+DwinAsync::ReadAwait::ReadAwait(DWIN2 *dwin, const uint16_t &vpHexAddr, uint16_t *data, const uint8_t &count, const uint32_t &timeoutMs)
+{
+    _dwin = dwin;
+    _read.vp = vpHexAddr;
+    _read.count = count;
+    _read.data = data;
+    _read.state = DWIN_READ_IDLE;
+    _read.next = nullptr;
+    _startMs = 0;
+    _timeoutMs = timeoutMs;
+    _queued = false;
+}
+
+bool DwinAsync::ReadAwait::await_ready()
+{
+    _startMs = millis();
+    _queued = _dwin->readAsync(_read);
+    // Not queued, resume at once with 0 words
+    return !_queued;
+}
+
+bool DwinAsync::ReadAwait::ready()
+{
+    return (_read.state != DWIN_READ_PENDING) || (millis() - _startMs >= _timeoutMs);
+}
+
+size_t DwinAsync::ReadAwait::await_resume()
+{
+    if (!_queued) return 0;
+    // Still pending on timeout: the bus must not write into the frame any more
+    return (_dwin->endRead(_read) == DWIN_READ_DONE) ? _read.count : 0;
+}
+
+DwinAsync::FlushAwait::FlushAwait(DWIN2 *dwin, const uint32_t &timeoutMs)
+{
+    _dwin = dwin;
+    _mark.busCount = 0;
+    _startMs = 0;
+    _timeoutMs = timeoutMs;
+    _done = false;
+    _ok = false;
+}
+
+bool DwinAsync::FlushAwait::await_ready()
+{
+    _startMs = millis();
+    _dwin->markFlush(_mark);
+    return ready();
+}
+
+bool DwinAsync::FlushAwait::ready()
+{
+    _done = _dwin->checkFlush(_mark, _ok);
+    return _done || (millis() - _startMs >= _timeoutMs);
+}
+
+bool DwinAsync::FlushAwait::await_resume()
+{
+    return _done && _ok;
+}
+
+DwinAsync::SleepAwait::SleepAwait(const uint32_t &ms)
+{
+    _startMs = 0;
+    _ms = ms;
+}
+
+bool DwinAsync::SleepAwait::await_ready()
+{
+    _startMs = millis();
+    return _ms == 0;
+}
+
+bool DwinAsync::SleepAwait::ready()
+{
+    return millis() - _startMs >= _ms;
+}
+
+//***********************************************************************************************************************
+//************* DWIN Async class ****************************************************************************************
+//***********************************************************************************************************************
+DwinAsync::DwinAsync(DWIN2 &dwin)
+{
+    _dwin = &dwin;
+}
+
+DwinAsync::ReadAwait DwinAsync::read(const uint16_t &vpHexAddr, uint16_t *data, const uint8_t &count, const uint32_t &timeoutMs)
+{
+    return ReadAwait(_dwin, vpHexAddr, data, count, timeoutMs);
+}
+
+DwinAsync::FlushAwait DwinAsync::flush(const uint32_t &timeoutMs)
+{
+    return FlushAwait(_dwin, timeoutMs);
+}
+
+DwinAsync::SleepAwait DwinAsync::sleep(const uint32_t &ms)
+{
+    return SleepAwait(ms);
+}
+
+DWIN2 &DwinAsync::dwin()
+{
+    return *_dwin;
+}
+
+void *DwinAsync::allocFrame(const size_t &size)
+{
+    if (size > ASYNC_FRAME_SIZE)
+    {
+        Serial.printf("DwinAsync: coroutine frame of %u bytes, ASYNC_FRAME_SIZE is %d\n", (unsigned)size, ASYNC_FRAME_SIZE);
+        return nullptr;
+    }
+    for (size_t i = 0; i < ASYNC_MAX_TASKS; i++)
+    {
+        if (_frameUsed[i]) continue;
+        _frameUsed[i] = true;
+        return _frames[i];
+    }
+    Serial.printf("DwinAsync: more than %d coroutines\n", ASYNC_MAX_TASKS);
+    return nullptr;
+}
+
+void DwinAsync::freeFrame(void *ptr)
+{
+    for (size_t i = 0; i < ASYNC_MAX_TASKS; i++)
+    {
+        if (ptr == _frames[i]) _frameUsed[i] = false;
+    }
+}
+
+bool DwinAsync::spawn(DwinTask task)
+{
+    DwinTask::handle_t handle = task.release();
+    if (!handle) return false;
+    // There is a slot for each frame of the pool
+    for (size_t i = 0; i < ASYNC_MAX_TASKS; i++)
+    {
+        if (_tasks[i]) continue;
+        // Run up to the first co_await
+        handle.resume();
+        if (handle.done()) handle.destroy();
+        else _tasks[i] = handle;
+        return true;
+    }
+    handle.destroy();
+    return false;
+}
+
+size_t DwinAsync::service()
+{
+    size_t count = 0;
+    for (size_t i = 0; i < ASYNC_MAX_TASKS; i++)
+    {
+        DwinTask::handle_t handle = _tasks[i];
+        if (!handle) continue;
+        DwinWait *waiting = handle.promise().waiting;
+        if ((waiting == nullptr) || waiting->ready())
+        {
+            handle.promise().waiting = nullptr;
+            handle.resume();
+            if (handle.done())
+            {
+                _tasks[i] = nullptr;
+                handle.destroy();
+                continue;
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+size_t DwinAsync::running()
+{
+    size_t count = 0;
+    for (size_t i = 0; i < ASYNC_MAX_TASKS; i++)
+    {
+        if (_tasks[i]) count++;
+    }
+    return count;
+}
+#endif
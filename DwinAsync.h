@@ -0,0 +1,189 @@
+//***************************************************
+//* C++20 coroutines for DWIN2 library              *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Multi-step display interactions without blocking calls. A workflow is a
+// coroutine returning DwinTask, it awaits the bus operations:
+//
+//   DwinTask setpointFlow(DwinAsync &bus)
+//   {
+//       uint16_t setpoint;
+//       if (co_await bus.read(0x1000, &setpoint) == 0) co_return;
+//       ...
+//       co_await bus.flush();
+//   }
+//   DwinAsync::spawn(setpointFlow(bus));
+//   void loop() { DwinAsync::service(); }
+//
+// A read is completed by the bus when its answer frame is parsed
+// (DWIN2::readAsync()), the coroutine is resumed by the next service()
+// call, so many workflows are in flight at once on the loop task.
+// Coroutine frames come from a fixed pool of ASYNC_MAX_TASKS blocks of
+// ASYNC_FRAME_SIZE bytes, no heap: spawn() returns false if the pool is
+// used up or the frame of the coroutine is larger than the block.
+// Create, spawn and service the tasks on one task. In the DWIN_NO_RTOS
+// build call poll() of the display objects in the loop as well.
+//
+// Needs C++20 (-std=gnu++20), the header is empty for older standards.
+
+#ifndef DwinAsync_h
+#define DwinAsync_h
+
+#include <Dwin2.h>
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define DWIN_COROUTINES
+#include <coroutine>
+
+// Number of coroutines in flight and the frame size of each
+#ifndef ASYNC_MAX_TASKS
+#define ASYNC_MAX_TASKS 8
+#endif
+#ifndef ASYNC_FRAME_SIZE
+#define ASYNC_FRAME_SIZE 512
+#endif
+// Answer timeout of the awaited reads, ms
+#define ASYNC_READ_TIMEOUT_MS 100
+
+// Operation a suspended coroutine waits for, checked by DwinAsync::service()
+class DwinWait
+{
+public:
+    virtual bool ready() = 0;
+};
+
+//***********************************************************************************************************************
+//************* DWIN Task class *****************************************************************************************
+//***********************************************************************************************************************
+class DwinTask
+{
+public:
+    struct promise_type
+    {
+        DwinWait *waiting = nullptr;
+
+        DwinTask get_return_object() { return DwinTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        // The frame pool is used up, spawn() gets an empty task
+        static DwinTask get_return_object_on_allocation_failure() { return DwinTask(nullptr); }
+        // Started by spawn(), destroyed by service() when finished
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {}
+        static void *operator new(size_t size) noexcept;
+        static void operator delete(void *ptr) noexcept;
+    };
+    typedef std::coroutine_handle<promise_type> handle_t;
+
+    explicit DwinTask(handle_t handle) : _handle(handle) {}
+    DwinTask(DwinTask &&other) noexcept : _handle(other._handle) { other._handle = nullptr; }
+    DwinTask(const DwinTask &) = delete;
+    DwinTask &operator=(const DwinTask &) = delete;
+    ~DwinTask() { if (_handle) _handle.destroy(); }
+    // Give the coroutine to the scheduler
+    handle_t release()
+    {
+        handle_t handle = _handle;
+        _handle = nullptr;
+        return handle;
+    }
+
+private:
+    handle_t _handle;
+};
+
+// Suspend the coroutine until the operation is ready
+class DwinAwait : public DwinWait
+{
+public:
+    void await_suspend(DwinTask::handle_t handle) { handle.promise().waiting = this; }
+};
+
+//***********************************************************************************************************************
+//************* DWIN Async class ****************************************************************************************
+//***********************************************************************************************************************
+class DwinAsync
+{
+public:
+    // co_await read(): the number of words read, 0 on timeout or no answer
+    class ReadAwait : public DwinAwait
+    {
+    private:
+        DWIN2 *_dwin;
+        dwinread_t _read;
+        uint32_t _startMs;
+        uint32_t _timeoutMs;
+        bool _queued;
+
+    public:
+        ReadAwait(DWIN2 *dwin, const uint16_t &vpHexAddr, uint16_t *data, const uint8_t &count, const uint32_t &timeoutMs);
+        // The read is queued here, the answer may come before the suspension
+        bool await_ready();
+        bool ready() override;
+        size_t await_resume();
+    };
+
+    // co_await flush(): true if the frames queued before are sent and answered
+    class FlushAwait : public DwinAwait
+    {
+    private:
+        DWIN2 *_dwin;
+        dwinflush_t _mark;
+        uint32_t _startMs;
+        uint32_t _timeoutMs;
+        bool _done;
+        bool _ok;
+
+    public:
+        FlushAwait(DWIN2 *dwin, const uint32_t &timeoutMs);
+        bool await_ready();
+        bool ready() override;
+        bool await_resume();
+    };
+
+    // co_await sleep(): resumed after ms
+    class SleepAwait : public DwinAwait
+    {
+    private:
+        uint32_t _startMs;
+        uint32_t _ms;
+
+    public:
+        SleepAwait(const uint32_t &ms);
+        bool await_ready();
+        bool ready() override;
+        void await_resume() {}
+    };
+
+    DwinAsync(DWIN2 &dwin);
+
+    // Read count words (up to DWIN_MAX_BLOCK_WORDS) from vpHexAddr
+    ReadAwait read(const uint16_t &vpHexAddr, uint16_t *data, const uint8_t &count = 1, const uint32_t &timeoutMs = ASYNC_READ_TIMEOUT_MS);
+    // Wait until the commands queued before are acked
+    FlushAwait flush(const uint32_t &timeoutMs = 1000);
+    static SleepAwait sleep(const uint32_t &ms);
+    // Display object of the bus, to send commands from the coroutine (they are queued, not waited for)
+    DWIN2 &dwin();
+
+    // Start the coroutine, it runs up to its first co_await. Returns false if it could not be created
+    static bool spawn(DwinTask task);
+    // Resume the coroutines whose operations are ready, call from the loop. Returns the number in flight
+    static size_t service();
+    static size_t running();
+
+    // Coroutine frame pool
+    static void *allocFrame(const size_t &size);
+    static void freeFrame(void *ptr);
+
+private:
+    DWIN2 *_dwin;
+    static DwinTask::handle_t _tasks[ASYNC_MAX_TASKS];
+    alignas(16) static uint8_t _frames[ASYNC_MAX_TASKS][ASYNC_FRAME_SIZE];
+    static bool _frameUsed[ASYNC_MAX_TASKS];
+};
+
+#endif
+
+#endif
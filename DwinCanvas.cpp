@@ -0,0 +1,173 @@
+#include <DwinCanvas.h>
+
+// Unchanged words between two changed runs of a large update, which are still sent in one frame.
+// Cheaper than the 6 byte header of the separate frame
+#define CANVAS_MERGE_GAP 3
+
+//***********************************************************************************************************************
+//************* DWIN Canvas class ***************************************************************************************
+//***********************************************************************************************************************
+DwinCanvas::DwinCanvas(DWIN2 &dwin, const uint16_t &vpHexAddr, const uint16_t &maxWords)
+{
+    _dwin = &dwin;
+    _vpHexAddr = vpHexAddr;
+    _maxWords = maxWords;
+    _area.reserve(maxWords);
+    _lastArea.reserve(maxWords);
+}
+
+void DwinCanvas::clear()
+{
+    _primitives.clear();
+}
+
+void DwinCanvas::add(const uigraph_t &kind, const uint16_t *data)
+{
+    uiprimitive_t prim;
+    prim.kind = kind;
+    memcpy(prim.data, data, packSize(kind)*sizeof(uint16_t));
+    _primitives.push_back(prim);
+}
+
+void DwinCanvas::dot(const uint16_t &x, const uint16_t &y, const uint16_t &color)
+{
+    const uint16_t data[3] = {x, y, color};
+    add(DOT, data);
+}
+
+void DwinCanvas::line(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color)
+{
+    const uint16_t data[5] = {color, x0, y0, x1, y1};
+    add(LINE, data);
+}
+
+void DwinCanvas::rect(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color)
+{
+    const uint16_t data[5] = {x0, y0, x1, y1, color};
+    add(RECT, data);
+}
+
+void DwinCanvas::fillRect(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color)
+{
+    const uint16_t data[5] = {x0, y0, x1, y1, color};
+    add(FILL_RECT, data);
+}
+
+void DwinCanvas::circle(const uint16_t &x, const uint16_t &y, const uint16_t &radius, const uint16_t &color)
+{
+    const uint16_t data[4] = {x, y, radius, color};
+    add(CIRCLE, data);
+}
+
+uint8_t DwinCanvas::packSize(const uigraph_t &kind)
+{
+    switch (kind)
+    {
+    case DOT:
+        return 3;
+    case CIRCLE:
+        return 4;
+    default:
+        return 5;
+    }
+}
+
+bool DwinCanvas::encode()
+{
+    _area.clear();
+    size_t i = 0;
+    while (i < _primitives.size())
+    {
+        // Primitives of the same kind in a row share one command block
+        const uigraph_t kind = _primitives[i].kind;
+        const uint8_t pack = packSize(kind);
+        size_t j = i;
+        while ((j < _primitives.size()) && (_primitives[j].kind == kind)) j++;
+
+        // Command, number of packs, packs, end of area
+        if (_area.size() + 2 + (j - i)*pack + 1 > _maxWords) return false;
+        _area.push_back(kind);
+        _area.push_back(j - i);
+        for (; i < j; i++)
+        {
+            _area.insert(_area.end(), _primitives[i].data, _primitives[i].data + pack);
+        }
+    }
+    _area.push_back(0xFF00);
+    return true;
+}
+
+bool DwinCanvas::flush()
+{
+    if (!encode())
+    {
+        Serial.printf("DwinCanvas ERR flush() %u primitives do not fit %d words\n", (unsigned)_primitives.size(), _maxWords);
+        return false;
+    }
+
+    // Span of the changed words. Words after the end of the new area are not used by the panel
+    size_t first = _area.size();
+    size_t last = 0;
+    for (size_t i = 0; i < _area.size(); i++)
+    {
+        if ((i < _lastArea.size()) && (_area[i] == _lastArea[i])) continue;
+        if (first == _area.size()) first = i;
+        last = i + 1;
+    }
+    if (first == _area.size())
+    {
+        _lastArea = _area;
+        return false;
+    }
+
+    // The panel may run the command area between two frames of the update
+    if (last - first <= DWIN_MAX_BLOCK_WORDS)
+    {
+        // One frame, the old drawing is replaced at once
+        _dwin->writeBlock(_vpHexAddr + first, &_area[first], last - first);
+    }
+    else
+    {
+        // The area is ended at the first command word while the changed runs are written,
+        // the command word goes last: the panel draws the old frame, nothing or the new one
+        const uint16_t areaEnd = 0xFF00;
+        _dwin->writeBlock(_vpHexAddr, &areaEnd, 1);
+        size_t i = 1;
+        while (i < _area.size())
+        {
+            if ((i < _lastArea.size()) && (_area[i] == _lastArea[i]))
+            {
+                i++;
+                continue;
+            }
+            const size_t start = i;
+            size_t end = i + 1;
+            size_t gap = 0;
+            for (size_t k = end; k < _area.size(); k++)
+            {
+                if ((k < _lastArea.size()) && (_area[k] == _lastArea[k]))
+                {
+                    if (++gap > CANVAS_MERGE_GAP) break;
+                    continue;
+                }
+                gap = 0;
+                end = k + 1;
+            }
+            _dwin->writeBlock(_vpHexAddr + start, &_area[start], end - start);
+            i = end;
+        }
+        _dwin->writeBlock(_vpHexAddr, &_area[0], 1);
+    }
+    _lastArea = _area;
+    return true;
+}
+
+void DwinCanvas::invalidate()
+{
+    _lastArea.clear();
+}
+
+size_t DwinCanvas::size()
+{
+    return _primitives.size();
+}
@@ -0,0 +1,80 @@
+//***************************************************
+//* Basic graphics drawing list for DWIN2 library   *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Drawing through the DGUS "Basic Graphic" display control.
+// Primitives are recorded between clear() and flush(), then encoded into
+// the command area of the control:
+//   VP+0: command, VP+1: number of data packs, VP+2...: data packs,
+//   next command block..., 0xFF00 end of the command area
+// The panel redraws the command area on every display cycle, so flush()
+// writes only the words that differ from the previous frame. Primitives
+// identical to the previous frame are not sent at all. The changes go in
+// one frame when they fit, otherwise the area is ended at its first word
+// during the update: the panel never draws a mix of the two frames.
+
+#ifndef DwinCanvas_h
+#define DwinCanvas_h
+
+#include <Dwin2.h>
+
+typedef enum {
+    DOT = 0x0001,
+    RECT = 0x0003,
+    FILL_RECT = 0x0004,
+    CIRCLE = 0x0005,
+    LINE = 0x000A
+} uigraph_t;
+
+typedef struct {
+    uigraph_t kind;
+    uint16_t data[5];
+} uiprimitive_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Canvas class ***************************************************************************************
+//***********************************************************************************************************************
+class DwinCanvas
+{
+private:
+    DWIN2 *_dwin;
+    uint16_t _vpHexAddr;
+    // Command area size in words, as set in the DGUS project
+    uint16_t _maxWords;
+
+    // Primitives of the current frame
+    std::vector<uiprimitive_t> _primitives;
+    // Encoded command area of the last flushed frame
+    std::vector<uint16_t> _lastArea;
+    // Encoded command area of the current frame
+    std::vector<uint16_t> _area;
+
+    void add(const uigraph_t &kind, const uint16_t *data);
+    // Number of data words of one primitive
+    static uint8_t packSize(const uigraph_t &kind);
+    // Encode primitives into _area, returns false if it does not fit _maxWords
+    bool encode();
+
+public:
+    DwinCanvas(DWIN2 &dwin, const uint16_t &vpHexAddr, const uint16_t &maxWords = 240);
+
+    // Start recording a new frame
+    void clear();
+    // Record primitives. Coordinates in pixels, color in DWIN HEX format (RGB565)
+    void dot(const uint16_t &x, const uint16_t &y, const uint16_t &color);
+    void line(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color);
+    void rect(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color);
+    void fillRect(const uint16_t &x0, const uint16_t &y0, const uint16_t &x1, const uint16_t &y1, const uint16_t &color);
+    void circle(const uint16_t &x, const uint16_t &y, const uint16_t &radius, const uint16_t &color);
+    // Send the changed part of the frame to the display. Returns false if nothing was sent
+    bool flush();
+    // Forget the last frame, the next flush() sends the full command area
+    void invalidate();
+    // Number of recorded primitives
+    size_t size();
+};
+
+#endif
@@ -0,0 +1,397 @@
+//***************************************************
+//* Statically typed UI elements for DWIN2 library  *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// DwinElement<Format> is a UI element whose data format is known at compile
+// time: DwinElement<Int16>, DwinElement<Double>, DwinElement<Utf<20>>...
+// Each element has exactly one encoder and one decoder, frames are built in
+// fixed-size buffers sized from the format, there are no ui type checks at
+// run time and no heap allocations when sending. An element takes 8 bytes:
+// pointer to the DWIN2 object used for UART and the VP/SP addresses.
+
+#ifndef DwinElement_h
+#define DwinElement_h
+
+#include <Dwin2.h>
+#include <DwinKernels.h>
+
+// Header of the VP write frame: 0x5A 0xA5 len 0x82 VP VP
+#define ELEMENT_HEADER 6
+
+//***********************************************************************************************************************
+//************* Data formats ********************************************************************************************
+//***********************************************************************************************************************
+// Each format gives the value type, the ui type, the max VP words and
+// encode()/decode(). encode() returns the number of bytes written to dst.
+
+// 10^n for the scale of the fixed point formats, at compile time
+constexpr float elementPow10(const uint8_t n) { return n == 0 ? 1.0f : 10.0f*elementPow10(n - 1); }
+
+struct Int16
+{
+    typedef int16_t value_type;
+    static constexpr uitype_t uitype = INT;
+    static constexpr uint8_t words = 1;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        dst[0] = highByte(val);
+        dst[1] = lowByte(val);
+        return 2;
+    }
+    static value_type decode(const uint16_t *src) { return static_cast<int16_t>(src[0]); }
+};
+
+struct Icon
+{
+    typedef uint16_t value_type;
+    static constexpr uitype_t uitype = ICON;
+    static constexpr uint8_t words = 1;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        dst[0] = highByte(val);
+        dst[1] = lowByte(val);
+        return 2;
+    }
+    static value_type decode(const uint16_t *src) { return src[0]; }
+};
+
+struct Float
+{
+    typedef float value_type;
+    static constexpr uitype_t uitype = FLOAT;
+    static constexpr uint8_t words = 2;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        uint32_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        dwinHostToBe32(dst, &bits, 1);
+        return 4;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        const uint32_t bits = (static_cast<uint32_t>(src[0]) << 16) | src[1];
+        float val;
+        memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+};
+
+struct Int32
+{
+    typedef int32_t value_type;
+    static constexpr uitype_t uitype = LONG;
+    static constexpr uint8_t words = 2;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        const uint32_t word = static_cast<uint32_t>(val);
+        dwinHostToBe32(dst, &word, 1);
+        return 4;
+    }
+    static value_type decode(const uint16_t *src) { return static_cast<int32_t>((static_cast<uint32_t>(src[0]) << 16) | src[1]); }
+};
+
+// Scaled fixed point: the value x10^D as int32, the display shows D decimals
+// (set the same decimal places for the data variable in the DGUS project).
+// Half the payload of Double, the panel formats the decimals
+template<uint8_t D>
+struct Fixed
+{
+    static_assert(D <= 9, "Fixed<D> int32 holds at most 9 decimals");
+    typedef float value_type;
+    static constexpr uitype_t uitype = LONG;
+    static constexpr uint8_t words = 2;
+    static constexpr float scale() { return elementPow10(D); }
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        dwinFloatToFixed32(dst, &val, 1, scale());
+        return 4;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        uint8_t bytes[4];
+        dwinHostToBe16(bytes, src, 2);
+        value_type val;
+        dwinFixed32ToFloat(&val, bytes, 1, scale());
+        return val;
+    }
+};
+
+// The same as int16, for values within +-32767 after scaling: one VP word
+template<uint8_t D>
+struct Fixed16
+{
+    static_assert(D <= 4, "Fixed16<D> int16 holds at most 4 decimals");
+    typedef float value_type;
+    static constexpr uitype_t uitype = INT;
+    static constexpr uint8_t words = 1;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        dwinFloatToFixed16(dst, &val, 1, elementPow10(D));
+        return 2;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        return static_cast<int16_t>(src[0])/elementPow10(D);
+    }
+};
+
+struct Double
+{
+    typedef double value_type;
+    static constexpr uitype_t uitype = DOUBLE;
+    static constexpr uint8_t words = 4;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        dwinHostToBe64(dst, val);
+        return 8;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        uint8_t bytes[8];
+        dwinHostToBe16(bytes, src, 4);
+        return dwinBeToHost64(bytes);
+    }
+};
+
+// Text of N UTF-16 characters
+template<uint8_t N>
+struct Utf
+{
+    static_assert(N > 0 && N < DWIN_MAX_BLOCK_WORDS, "Utf<N> text must fit one frame");
+    typedef String value_type;
+    static constexpr uitype_t uitype = UTF;
+    // Text and the end of line word
+    static constexpr uint8_t words = N + 1;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        // UTF-8 to big endian UTF-16
+        size_t len = dwinUtf8ToUtf16Be(dst, val.c_str(), N);
+        dst[len++] = 0xFF;
+        dst[len++] = 0xFF;
+        return len;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        String text;
+        for (uint8_t i = 0; (i < N) && (src[i] != 0xFFFF) && (src[i] != 0x0000); i++)
+        {
+            const uint16_t unicode = src[i];
+            if (unicode <= 0x7F) text += (char)unicode;
+            else if (unicode <= 0x7FF)
+            {
+                text += (char)(0xC0 | (unicode >> 6));
+                text += (char)(0x80 | (unicode & 0x3F));
+            }
+            else
+            {
+                text += (char)(0xE0 | (unicode >> 12));
+                text += (char)(0x80 | ((unicode >> 6) & 0x3F));
+                text += (char)(0x80 | (unicode & 0x3F));
+            }
+        }
+        return text;
+    }
+};
+
+// Text of N ASCII characters
+template<uint8_t N>
+struct Ascii
+{
+    static_assert(N > 0 && N < DWIN_MAX_BLOCK_WORDS*2 - 2, "Ascii<N> text must fit one frame");
+    typedef String value_type;
+    static constexpr uitype_t uitype = ASCII;
+    static constexpr uint8_t words = (N + 2 + 1)/2;
+    static size_t encode(uint8_t *dst, const value_type &val)
+    {
+        const size_t len = std::min<size_t>(val.length(), N);
+        memcpy(dst, val.c_str(), len);
+        dst[len] = 0xFF;
+        dst[len+1] = 0xFF;
+        return len + 2;
+    }
+    static value_type decode(const uint16_t *src)
+    {
+        String text;
+        for (uint8_t i = 0; i < N; i++)
+        {
+            const uint8_t c = (i % 2 == 0) ? highByte(src[i/2]) : lowByte(src[i/2]);
+            if ((c == 0xFF) || (c == 0x00)) break;
+            text += (char)c;
+        }
+        return text;
+    }
+};
+
+
+//***********************************************************************************************************************
+//************* DWIN Element class **************************************************************************************
+//***********************************************************************************************************************
+template<class T>
+class DwinElement
+{
+protected:
+    DWIN2 *_dwin;
+    uint16_t _vpHexAddr;
+    uint16_t _spHexAddr;
+
+    // Send the VP write frame with the data already in frame
+    void sendFrame(uint8_t *frame, const uint16_t &addr, const size_t &dataLen)
+    {
+        frame[0] = 0x5A;
+        frame[1] = 0xA5;
+        frame[2] = static_cast<uint8_t>(dataLen + 3);
+        frame[3] = 0x82;
+        frame[4] = highByte(addr);
+        frame[5] = lowByte(addr);
+        _dwin->sendRawCommand(frame, ELEMENT_HEADER + dataLen);
+    }
+
+    // Write one word to the SP of the element with the given offset
+    void sendSpWord(const uint8_t &offset, const uint16_t &data)
+    {
+        uint8_t frame[ELEMENT_HEADER + 2] = {};
+        frame[ELEMENT_HEADER] = highByte(data);
+        frame[ELEMENT_HEADER + 1] = lowByte(data);
+        sendFrame(frame, _spHexAddr + offset, 2);
+    }
+
+public:
+    typedef typename T::value_type value_type;
+
+    DwinElement(DWIN2 &dwin, const uint16_t &vpHexAddr, const uint16_t &spHexAddr = 0)
+        : _dwin(&dwin), _vpHexAddr(vpHexAddr), _spHexAddr(spHexAddr) {}
+
+    // Element from the generated DwinMap, e.g. DwinElement<Int16> speed(dwc, DwinMap::Int_1000())
+    template<class E, class = decltype(E::vp)>
+    DwinElement(DWIN2 &dwin, const E &)
+        : _dwin(&dwin), _vpHexAddr(E::vp), _spHexAddr(E::sp)
+    {
+        static_assert(E::type == T::uitype, "DwinElement format does not match the ui type of the map element");
+    }
+
+    // Send the value to the display
+    void set(const value_type &val)
+    {
+        uint8_t frame[ELEMENT_HEADER + T::words*2];
+        sendFrame(frame, _vpHexAddr, T::encode(&frame[ELEMENT_HEADER], val));
+    }
+    // Read the value from the display
+    value_type get()
+    {
+        uint16_t words[T::words] = {};
+        _dwin->readBlock(_vpHexAddr, words, T::words);
+        return T::decode(words);
+    }
+
+    // SP commands
+    void setColor(const uint16_t &colorHex) { sendSpWord(0x03, colorHex); }
+    void showUi() { sendSpWord(0x00, _vpHexAddr); }
+    void hideUi() { sendSpWord(0x00, 0xFFFF); }
+    void setPos(const uint16_t &x, const uint16_t &y)
+    {
+        uint8_t frame[ELEMENT_HEADER + 4];
+        frame[ELEMENT_HEADER] = highByte(x);
+        frame[ELEMENT_HEADER + 1] = lowByte(x);
+        frame[ELEMENT_HEADER + 2] = highByte(y);
+        frame[ELEMENT_HEADER + 3] = lowByte(y);
+        sendFrame(frame, _spHexAddr + 1, 4);
+    }
+
+    uint16_t getVpAddr() { return _vpHexAddr; }
+    uint16_t getSpAddr() { return _spHexAddr; }
+};
+
+
+//***********************************************************************************************************************
+//************* DWIN Text class *****************************************************************************************
+//***********************************************************************************************************************
+// Text element that keeps the last sent text: set() writes only the words
+// from the first to the last changed one, at their offset in the text VP.
+// The display ends the text at the 0xFFFF terminator, so a shorter text
+// needs no padding and clear() is one terminator word. A lost frame on the
+// port (getStat().lostFrames) makes the next set() send the whole text.
+// DwinText<Utf<40>> status(dwc, 0x5100); status.set("Speed 12"); status.set("Speed 13");
+// sends 6 bytes of the header and one word for the second set()
+template<class T>
+class DwinText : public DwinElement<T>
+{
+private:
+    static_assert((T::uitype == UTF) || (T::uitype == ASCII), "DwinText format should be Utf<N> or Ascii<N>");
+    // Encoded text with the terminator, padded to whole words
+    static constexpr size_t textBytes = T::words*2;
+    uint8_t _last[textBytes];
+    uint8_t _lastWords = 0;
+    // The text on the display is not known: first set(), invalidate(), a lost frame
+    bool _known = false;
+    // Frames lost on the port when _last was sent
+    uint32_t _lostFrames = 0;
+
+    // The last text may not have reached the display
+    uint32_t checkLost()
+    {
+        const uint32_t lostFrames = this->_dwin->getStat().lostFrames;
+        if (lostFrames != _lostFrames) _known = false;
+        return lostFrames;
+    }
+
+public:
+    typedef typename T::value_type value_type;
+
+    DwinText(DWIN2 &dwin, const uint16_t &vpHexAddr, const uint16_t &spHexAddr = 0)
+        : DwinElement<T>(dwin, vpHexAddr, spHexAddr) {}
+    template<class E, class = decltype(E::vp)>
+    DwinText(DWIN2 &dwin, const E &elem) : DwinElement<T>(dwin, elem) {}
+
+    // Send the changed span of the text, nothing if the text is the same
+    void set(const value_type &val)
+    {
+        uint8_t text[textBytes];
+        size_t len = T::encode(text, val);
+        // ASCII text of odd length: the terminator is padded to the whole word
+        if (len % 2 != 0) text[len++] = 0xFF;
+        const uint8_t words = len/2;
+        const uint32_t lostFrames = checkLost();
+
+        // First and last changed words, the words after the old text are changed
+        uint8_t first = 0;
+        uint8_t last = words;
+        if (_known)
+        {
+            while ((first < words) && (first < _lastWords) &&
+                (text[first*2] == _last[first*2]) && (text[first*2 + 1] == _last[first*2 + 1])) first++;
+            if (first == words) return;
+            while ((last > first + 1) && (last <= _lastWords) &&
+                (text[(last-1)*2] == _last[(last-1)*2]) && (text[(last-1)*2 + 1] == _last[(last-1)*2 + 1])) last--;
+        }
+
+        uint8_t frame[ELEMENT_HEADER + textBytes];
+        memcpy(&frame[ELEMENT_HEADER], &text[first*2], (last - first)*2);
+        this->sendFrame(frame, this->_vpHexAddr + first, (last - first)*2);
+        memcpy(_last, text, len);
+        _lastWords = words;
+        _lostFrames = lostFrames;
+        _known = true;
+    }
+
+    // Empty text: one 0xFFFF terminator word at the start of the VP
+    void clear()
+    {
+        const uint32_t lostFrames = checkLost();
+        uint8_t frame[ELEMENT_HEADER + 2];
+        frame[ELEMENT_HEADER] = 0xFF;
+        frame[ELEMENT_HEADER + 1] = 0xFF;
+        this->sendFrame(frame, this->_vpHexAddr, 2);
+        _last[0] = 0xFF;
+        _last[1] = 0xFF;
+        _lastWords = 1;
+        _lostFrames = lostFrames;
+        _known = true;
+    }
+
+    // The display lost the text (restart), the next set() sends the whole text
+    void invalidate() { _known = false; }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include <DwinEncoder.h>
+
+// Quadrature transitions: index (previous AB << 2) | current AB, value -1/0/+1
+static const int8_t QUADRATURE_TABLE[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+
+//***********************************************************************************************************************
+//************* DWIN Encoder class **************************************************************************************
+//***********************************************************************************************************************
+DwinEncoder::DwinEncoder(DWIN2 &dwin, const double &delta)
+{
+    _dwin = &dwin;
+    _delta = delta;
+    _refreshMs = ENCODER_REFRESH_MS;
+    _lastServiceMs = 0;
+    _ticks = 0;
+    _abState = 0;
+    _abSteps = 0;
+    _stepsPerDetent = ENCODER_STEPS_PER_DETENT;
+    // No acceleration by default
+    _slowRate = 0;
+    _fastRate = 0;
+    _maxFactor = 1.0f;
+    _rate = 0.0f;
+    _remainder = 0.0f;
+    _lastRightDir = true;
+#ifndef DWIN_NO_RTOS
+    _timerHandle = nullptr;
+#endif
+}
+
+DwinEncoder::~DwinEncoder()
+{
+    end();
+}
+
+void DwinEncoder::begin(const uint32_t &refreshMs)
+{
+    _refreshMs = refreshMs > 0 ? refreshMs : 1;
+    _lastServiceMs = millis();
+#ifndef DWIN_NO_RTOS
+    if (_timerHandle == nullptr)
+    {
+        esp_timer_create_args_t timerConfig;
+        timerConfig.arg = this;
+        timerConfig.callback = reinterpret_cast<esp_timer_cb_t>(timerTask);
+        timerConfig.dispatch_method = ESP_TIMER_TASK;
+        timerConfig.name = "DwinEncoder";
+        esp_timer_create(&timerConfig, &_timerHandle);
+    }
+    if (esp_timer_is_active(_timerHandle)) esp_timer_stop(_timerHandle);
+    esp_timer_start_periodic(_timerHandle, static_cast<uint64_t>(_refreshMs)*1000);
+#endif
+}
+
+void DwinEncoder::end()
+{
+#ifndef DWIN_NO_RTOS
+    if (_timerHandle == nullptr) return;
+    if (esp_timer_is_active(_timerHandle)) esp_timer_stop(_timerHandle);
+    esp_timer_delete(_timerHandle);
+    _timerHandle = nullptr;
+#endif
+}
+
+#ifndef DWIN_NO_RTOS
+void DwinEncoder::timerTask(DwinEncoder *encoder)
+{
+    // The timer keeps the period, no check of the time
+    encoder->applyTicks();
+}
+#endif
+
+void IRAM_ATTR DwinEncoder::tick(const bool &rightDir)
+{
+    __atomic_fetch_add(&_ticks, rightDir ? 1 : -1, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR DwinEncoder::readPins(const bool &a, const bool &b)
+{
+    _abState = ((_abState << 2) | (a << 1) | b) & 0x0F;
+    _abSteps += QUADRATURE_TABLE[_abState];
+    // Count a tick at the full detent, bounces cancel out
+    if (_abSteps >= _stepsPerDetent)
+    {
+        _abSteps = 0;
+        tick(true);
+    }
+    else if (_abSteps <= -_stepsPerDetent)
+    {
+        _abSteps = 0;
+        tick(false);
+    }
+}
+
+void DwinEncoder::setStepsPerDetent(const uint8_t &steps)
+{
+    _stepsPerDetent = steps > 0 ? steps : 1;
+}
+
+void DwinEncoder::setAcceleration(const uint16_t &slowRate, const uint16_t &fastRate, const float &maxFactor)
+{
+    _slowRate = slowRate;
+    _fastRate = fastRate > slowRate ? fastRate : slowRate;
+    _maxFactor = maxFactor > 1.0f ? maxFactor : 1.0f;
+    _remainder = 0.0f;
+}
+
+void DwinEncoder::setDelta(const double &delta)
+{
+    _delta = delta;
+}
+
+float DwinEncoder::accelFactor(const float &rate)
+{
+    if ((_maxFactor <= 1.0f) || (rate <= _slowRate)) return 1.0f;
+    if (rate >= _fastRate) return _maxFactor;
+    // Linear between the slow and the fast speed
+    return 1.0f + (_maxFactor - 1.0f)*(rate - _slowRate)/(_fastRate - _slowRate);
+}
+
+bool DwinEncoder::service()
+{
+    if (millis() - _lastServiceMs < _refreshMs) return false;
+    return applyTicks();
+}
+
+bool DwinEncoder::applyTicks()
+{
+    const uint32_t nowMs = millis();
+    const uint32_t elapsedMs = (nowMs - _lastServiceMs) > 0 ? nowMs - _lastServiceMs : 1;
+    _lastServiceMs = nowMs;
+
+    // Take all ticks of the period, the interrupt keeps counting from zero
+    const int32_t ticks = __atomic_exchange_n(&_ticks, 0, __ATOMIC_RELAXED);
+    const uint32_t absTicks = ticks > 0 ? ticks : -ticks;
+    _rate = absTicks*1000.0f/elapsedMs;
+    if (ticks == 0)
+    {
+        _remainder = 0.0f;
+        return false;
+    }
+
+    // Accelerated steps, the fraction is kept for the next period of the same direction
+    if ((ticks > 0) != _lastRightDir) _remainder = 0.0f;
+    _lastRightDir = (ticks > 0);
+    const float steps = absTicks*accelFactor(_rate) + _remainder;
+    const int32_t wholeSteps = static_cast<int32_t>(steps);
+    _remainder = steps - wholeSteps;
+    _dwin->updateSteps(ticks > 0 ? wholeSteps : -wholeSteps, _delta);
+    return true;
+}
+
+int32_t DwinEncoder::pendingTicks()
+{
+    return __atomic_load_n(&_ticks, __ATOMIC_RELAXED);
+}
+
+float DwinEncoder::getRate()
+{
+    return _rate;
+}
@@ -0,0 +1,95 @@
+//***************************************************
+//* Rotary encoder input for DWIN2 library          *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Encoder front end for a DWIN2 element. The encoder interrupt only counts
+// ticks: tick() or the quadrature decoder readPins() are IRAM functions that
+// change one atomic counter, no UART and no locks. Once per refresh period
+// service() takes all ticks at once, applies the acceleration curve and
+// writes the final value with one frame (DWIN2::updateSteps()), so a fast
+// spin is one write per period instead of a backlog of per-tick frames.
+// Limits and loop rotation of the element are kept.
+//
+// With RTOS begin() starts an esp_timer that calls service(),
+// in the DWIN_NO_RTOS build call service() from the superloop.
+
+#ifndef DwinEncoder_h
+#define DwinEncoder_h
+
+#include <Dwin2.h>
+
+// Default refresh period, ms
+#define ENCODER_REFRESH_MS 20
+// Quadrature steps per detent of a common mechanical encoder
+#define ENCODER_STEPS_PER_DETENT 4
+
+
+//***********************************************************************************************************************
+//************* DWIN Encoder class **************************************************************************************
+//***********************************************************************************************************************
+class DwinEncoder
+{
+private:
+    DWIN2 *_dwin;
+    // Value change of one tick
+    double _delta;
+    uint32_t _refreshMs;
+    uint32_t _lastServiceMs;
+
+    // Ticks counted by the interrupt, taken by service()
+    volatile int32_t _ticks;
+    // Quadrature decoder state, changed only by readPins()
+    uint8_t _abState;
+    int8_t _abSteps;
+    uint8_t _stepsPerDetent;
+
+    // Acceleration curve: x1 up to _slowRate ticks/s, x_maxFactor from _fastRate, linear in between
+    uint16_t _slowRate;
+    uint16_t _fastRate;
+    float _maxFactor;
+    // Speed of the last period and the step remainder of the acceleration
+    float _rate;
+    float _remainder;
+    bool _lastRightDir;
+
+#ifndef DWIN_NO_RTOS
+    esp_timer_handle_t _timerHandle;
+    static void timerTask(DwinEncoder *encoder);
+#endif
+
+    // Steps multiplier for the speed in ticks per second
+    float accelFactor(const float &rate);
+    // Take the counted ticks and send the value, returns true if there were ticks
+    bool applyTicks();
+
+public:
+    DwinEncoder(DWIN2 &dwin, const double &delta = 1.0);
+    ~DwinEncoder();
+
+    // Start the refresh timer (RTOS build), with DWIN_NO_RTOS only sets the period
+    void begin(const uint32_t &refreshMs = ENCODER_REFRESH_MS);
+    void end();
+
+    // Interrupt side. One detent in the direction (true - right)
+    void IRAM_ATTR tick(const bool &rightDir);
+    // Quadrature decoder, call from the interrupt of the A and B pins with their levels
+    void IRAM_ATTR readPins(const bool &a, const bool &b);
+    void setStepsPerDetent(const uint8_t &steps);
+
+    // Acceleration: up to slowRate ticks/s each tick is one step, from fastRate a tick is maxFactor steps
+    void setAcceleration(const uint16_t &slowRate, const uint16_t &fastRate, const float &maxFactor);
+    // Value change of one step
+    void setDelta(const double &delta);
+
+    // Task side. Send the value if the refresh period has passed and ticks were counted.
+    // Returns true if the ticks were applied
+    bool service();
+    // Ticks not yet applied
+    int32_t pendingTicks();
+    // Encoder speed in the last refresh period, ticks per second
+    float getRate();
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include <DwinKernels.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define DWIN_KERNEL_SSSE3
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DWIN_KERNEL_NEON
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "DwinKernels expects a little endian host"
+#endif
+
+//***********************************************************************************************************************
+//************* Helpers *************************************************************************************************
+//***********************************************************************************************************************
+
+// Swap bytes of count 16-bit words from src to dst (src and dst may be the same buffer)
+static void swap16Words(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+#if defined(DWIN_KERNEL_SSSE3)
+    const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*2), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(DWIN_KERNEL_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1q_u8(dst + i*2, vrev16q_u8(vld1q_u8(src + i*2)));
+    }
+#endif
+    // Two words per 32-bit operation. memcpy keeps it safe for unaligned buffers on Xtensa
+    for (; i + 2 <= count; i += 2)
+    {
+        uint32_t w;
+        memcpy(&w, src + i*2, sizeof(w));
+        w = ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+        memcpy(dst + i*2, &w, sizeof(w));
+    }
+    if (i < count)
+    {
+        const uint8_t hi = src[i*2 + 1];
+        dst[i*2 + 1] = src[i*2];
+        dst[i*2] = hi;
+    }
+}
+
+// Reverse bytes of count 32-bit words from src to dst
+static void swap32Words(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+#if defined(DWIN_KERNEL_SSSE3)
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*4), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(DWIN_KERNEL_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u8(dst + i*4, vrev32q_u8(vld1q_u8(src + i*4)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint32_t w;
+        memcpy(&w, src + i*4, sizeof(w));
+        w = __builtin_bswap32(w);
+        memcpy(dst + i*4, &w, sizeof(w));
+    }
+}
+
+static int32_t floatToFixed(const float &val, const float &scale, const float &minVal, const float &maxVal)
+{
+    float f = val*scale;
+    // NaN is taken as minVal, the same as _mm_max_ps() of the SSSE3 path
+    if (!(f >= minVal)) f = minVal;
+    if (f > maxVal) f = maxVal;
+    return static_cast<int32_t>(lrintf(f));
+}
+
+//***********************************************************************************************************************
+//************* Kernels *************************************************************************************************
+//***********************************************************************************************************************
+
+void dwinHostToBe16(uint8_t *dst, const uint16_t *src, size_t count)
+{
+    swap16Words(dst, reinterpret_cast<const uint8_t*>(src), count);
+}
+
+void dwinBeToHost16(uint16_t *dst, const uint8_t *src, size_t count)
+{
+    swap16Words(reinterpret_cast<uint8_t*>(dst), src, count);
+}
+
+void dwinHostToBe32(uint8_t *dst, const uint32_t *src, size_t count)
+{
+    swap32Words(dst, reinterpret_cast<const uint8_t*>(src), count);
+}
+
+void dwinBeToHost32(uint32_t *dst, const uint8_t *src, size_t count)
+{
+    swap32Words(reinterpret_cast<uint8_t*>(dst), src, count);
+}
+
+void dwinSwap16(uint8_t *buf, size_t count)
+{
+    swap16Words(buf, buf, count);
+}
+
+void dwinHostToBe64(uint8_t *dst, const double &src)
+{
+    uint64_t w;
+    memcpy(&w, &src, sizeof(w));
+    w = __builtin_bswap64(w);
+    memcpy(dst, &w, sizeof(w));
+}
+
+double dwinBeToHost64(const uint8_t *src)
+{
+    uint64_t w;
+    memcpy(&w, src, sizeof(w));
+    w = __builtin_bswap64(w);
+    double d;
+    memcpy(&d, &w, sizeof(d));
+    return d;
+}
+
+void dwinFloatToFixed16(uint8_t *dst, const float *src, size_t count, float scale)
+{
+    size_t i = 0;
+#if defined(DWIN_KERNEL_SSSE3)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin = _mm_set1_ps(-32768.0f);
+    const __m128 vmax = _mm_set1_ps(32767.0f);
+    const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8)
+    {
+        // Clamp before the conversion: out of the int32 range it gives INT_MIN
+        __m128 flo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vscale), vmin), vmax);
+        __m128 fhi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), vscale), vmin), vmax);
+        __m128i lo = _mm_cvtps_epi32(flo);
+        __m128i hi = _mm_cvtps_epi32(fhi);
+        // Pack to int16, then to big endian
+        __m128i v = _mm_shuffle_epi8(_mm_packs_epi32(lo, hi), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*2), v);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        const int32_t v = floatToFixed(src[i], scale, -32768.0f, 32767.0f);
+        dst[i*2] = static_cast<uint8_t>(v >> 8);
+        dst[i*2 + 1] = static_cast<uint8_t>(v);
+    }
+}
+
+void dwinFloatToFixed32(uint8_t *dst, const float *src, size_t count, float scale)
+{
+    size_t i = 0;
+#if defined(DWIN_KERNEL_SSSE3)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin = _mm_set1_ps(-2147483648.0f);
+    const __m128 vmax = _mm_set1_ps(2147483520.0f);
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4)
+    {
+        // Clamp before the conversion: out of the int32 range it gives INT_MIN
+        __m128 f = _mm_mul_ps(_mm_loadu_ps(src + i), vscale);
+        f = _mm_min_ps(_mm_max_ps(f, vmin), vmax);
+        __m128i v = _mm_shuffle_epi8(_mm_cvtps_epi32(f), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*4), v);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint32_t v = static_cast<uint32_t>(floatToFixed(src[i], scale, -2147483648.0f, 2147483520.0f));
+        v = __builtin_bswap32(v);
+        memcpy(dst + i*4, &v, sizeof(v));
+    }
+}
+
+void dwinFixed16ToFloat(float *dst, const uint8_t *src, size_t count, float scale)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const int16_t v = static_cast<int16_t>((src[i*2] << 8) | src[i*2 + 1]);
+        dst[i] = v/scale;
+    }
+}
+
+void dwinFixed32ToFloat(float *dst, const uint8_t *src, size_t count, float scale)
+{
+    size_t i = 0;
+#if defined(DWIN_KERNEL_SSSE3)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*4)), mask);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(v), vscale));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint32_t v;
+        memcpy(&v, src + i*4, sizeof(v));
+        dst[i] = static_cast<int32_t>(__builtin_bswap32(v))/scale;
+    }
+}
+
+size_t dwinUtf8ToUtf16Be(uint8_t *dst, const char *src, size_t maxWords)
+{
+    const uint8_t *text = reinterpret_cast<const uint8_t*>(src);
+    size_t words = 0;
+    size_t i = 0;
+    while ((text[i] != 0) && (words < maxWords))
+    {
+        uint32_t unicode;
+        if (text[i] < 0x80)
+        {
+            unicode = text[i++];
+        }
+        else if (((text[i] & 0xE0) == 0xC0) && text[i+1])
+        {
+            unicode = ((text[i] & 0x1F) << 6) | (text[i+1] & 0x3F);
+            i += 2;
+        }
+        else if (((text[i] & 0xF0) == 0xE0) && text[i+1] && text[i+2])
+        {
+            unicode = ((text[i] & 0x0F) << 12) | ((text[i+1] & 0x3F) << 6) | (text[i+2] & 0x3F);
+            i += 3;
+        }
+        else if (((text[i] & 0xF8) == 0xF0) && text[i+1] && text[i+2] && text[i+3])
+        {
+            unicode = ((text[i] & 0x07) << 18) | ((text[i+1] & 0x3F) << 12) | ((text[i+2] & 0x3F) << 6) | (text[i+3] & 0x3F);
+            i += 4;
+        }
+        else
+        {
+            // Broken sequence, skip the byte
+            i++;
+            continue;
+        }
+
+        if (unicode > 0xFFFF)
+        {
+            // Surrogate pair, both words or nothing
+            if (words + 2 > maxWords) break;
+            unicode -= 0x10000;
+            const uint16_t high = 0xD800 | (unicode >> 10);
+            dst[words*2] = static_cast<uint8_t>(high >> 8);
+            dst[words*2 + 1] = static_cast<uint8_t>(high);
+            words++;
+            unicode = 0xDC00 | (unicode & 0x3FF);
+        }
+        dst[words*2] = static_cast<uint8_t>(unicode >> 8);
+        dst[words*2 + 1] = static_cast<uint8_t>(unicode);
+        words++;
+    }
+    return words*2;
+}
+
+//***********************************************************************************************************************
+//************* Reference scalar versions *******************************************************************************
+//***********************************************************************************************************************
+
+void dwinHostToBe16Scalar(uint8_t *dst, const uint16_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i*2] = static_cast<uint8_t>(src[i] >> 8);
+        dst[i*2 + 1] = static_cast<uint8_t>(src[i] & 0xFF);
+    }
+}
+
+void dwinBeToHost16Scalar(uint16_t *dst, const uint8_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = static_cast<uint16_t>((src[i*2] << 8) | src[i*2 + 1]);
+    }
+}
+
+void dwinHostToBe32Scalar(uint8_t *dst, const uint32_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i*4] = static_cast<uint8_t>(src[i] >> 24);
+        dst[i*4 + 1] = static_cast<uint8_t>(src[i] >> 16);
+        dst[i*4 + 2] = static_cast<uint8_t>(src[i] >> 8);
+        dst[i*4 + 3] = static_cast<uint8_t>(src[i]);
+    }
+}
+
+void dwinSwap16Scalar(uint8_t *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t temp = buf[i*2];
+        buf[i*2] = buf[i*2 + 1];
+        buf[i*2 + 1] = temp;
+    }
+}
+
+void dwinFloatToFixed16Scalar(uint8_t *dst, const float *src, size_t count, float scale)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const int32_t v = floatToFixed(src[i], scale, -32768.0f, 32767.0f);
+        dst[i*2] = static_cast<uint8_t>(v >> 8);
+        dst[i*2 + 1] = static_cast<uint8_t>(v);
+    }
+}
+
+void dwinFloatToFixed32Scalar(uint8_t *dst, const float *src, size_t count, float scale)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const int32_t v = floatToFixed(src[i], scale, -2147483648.0f, 2147483520.0f);
+        dst[i*4] = static_cast<uint8_t>(v >> 24);
+        dst[i*4 + 1] = static_cast<uint8_t>(v >> 16);
+        dst[i*4 + 2] = static_cast<uint8_t>(v >> 8);
+        dst[i*4 + 3] = static_cast<uint8_t>(v);
+    }
+}
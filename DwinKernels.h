@@ -0,0 +1,50 @@
+//***************************************************
+//* Bulk endian/packing kernels for DWIN2 library   *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// DGUS stores VP data in big endian words. These kernels convert whole arrays
+// at once, using the widest path available on the target:
+//  - SSSE3/NEON byte shuffles on the host (PC builds, tests)
+//  - 32-bit word operations on Xtensa (ESP32), two 16-bit words per step
+// The *Scalar versions are the byte-by-byte reference, used by the benchmark.
+
+#ifndef DwinKernels_h
+#define DwinKernels_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host uint16_t array to big endian bytes (dst size = count*2)
+void dwinHostToBe16(uint8_t *dst, const uint16_t *src, size_t count);
+// Big endian bytes to host uint16_t array
+void dwinBeToHost16(uint16_t *dst, const uint8_t *src, size_t count);
+// Host uint32_t array to big endian bytes (dst size = count*4)
+void dwinHostToBe32(uint8_t *dst, const uint32_t *src, size_t count);
+// Big endian bytes to host uint32_t array
+void dwinBeToHost32(uint32_t *dst, const uint8_t *src, size_t count);
+// Swap high and low bytes of each 16-bit word in place (UTF-16 LE <-> BE)
+void dwinSwap16(uint8_t *buf, size_t count);
+// Double to 8 big endian bytes and back
+void dwinHostToBe64(uint8_t *dst, const double &src);
+double dwinBeToHost64(const uint8_t *src);
+// Float array to fixed point: round(src*scale), saturated, big endian
+void dwinFloatToFixed16(uint8_t *dst, const float *src, size_t count, float scale);
+void dwinFloatToFixed32(uint8_t *dst, const float *src, size_t count, float scale);
+// Big endian fixed point to float array: src/scale
+void dwinFixed16ToFloat(float *dst, const uint8_t *src, size_t count, float scale);
+void dwinFixed32ToFloat(float *dst, const uint8_t *src, size_t count, float scale);
+// UTF-8 text to big endian UTF-16, at most maxWords words (characters above 0xFFFF take two).
+// Returns the number of bytes written, no heap allocations
+size_t dwinUtf8ToUtf16Be(uint8_t *dst, const char *src, size_t maxWords);
+
+// Reference scalar versions
+void dwinHostToBe16Scalar(uint8_t *dst, const uint16_t *src, size_t count);
+void dwinBeToHost16Scalar(uint16_t *dst, const uint8_t *src, size_t count);
+void dwinHostToBe32Scalar(uint8_t *dst, const uint32_t *src, size_t count);
+void dwinSwap16Scalar(uint8_t *buf, size_t count);
+void dwinFloatToFixed16Scalar(uint8_t *dst, const float *src, size_t count, float scale);
+void dwinFloatToFixed32Scalar(uint8_t *dst, const float *src, size_t count, float scale);
+
+#endif
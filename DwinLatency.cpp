@@ -0,0 +1,213 @@
+#include <DwinLatency.h>
+#include <algorithm>
+
+//***********************************************************************************************************************
+//************* DWIN Latency class **************************************************************************************
+//***********************************************************************************************************************
+DwinLatency::DwinLatency(DWIN2 &dwin)
+{
+    _dwin = &dwin;
+    _touch = touchPanel;
+    _buttonVp = 0;
+    _feedbackVp = 0;
+    _x = 0;
+    _y = 0;
+    _touches = 0;
+    _intervalMs = 0;
+    _touchMs = 0;
+    _running = false;
+    _phase = PHASE_IDLE;
+    _touchUs = 0;
+    _uploadUs = 0;
+    _dispatchUs = 0;
+    _queuedUs = 0;
+    _ackUs = 0;
+    _ackFrame = 0;
+    _lost = false;
+    _count = 0;
+    _timeouts = 0;
+    _lostAcks = 0;
+}
+
+DwinLatency::~DwinLatency()
+{
+    _dwin->setLatency(nullptr);
+}
+
+void DwinLatency::touchPanel(DWIN2 &dwin, const uint16_t &x, const uint16_t &y)
+{
+    const uint16_t touch[4] = {0x5AA5, LATENCY_TOUCH_CLICK, x, y};
+    dwin.writeBlock(LATENCY_TOUCH_VP, touch, 4);
+}
+
+void DwinLatency::setTouchDriver(TouchFunction f)
+{
+    _touch = (f != NULL) ? f : touchPanel;
+}
+
+void DwinLatency::start(const uint16_t &buttonVp, const uint16_t &feedbackVp, const uint16_t &x, const uint16_t &y,
+                        const uint32_t &touches, const uint32_t &intervalMs)
+{
+    _buttonVp = buttonVp;
+    _feedbackVp = feedbackVp;
+    _x = x;
+    _y = y;
+    _touches = touches;
+    _intervalMs = intervalMs;
+    _count = 0;
+    _timeouts = 0;
+    _lostAcks = 0;
+    _phase = PHASE_IDLE;
+    _running = true;
+    _dwin->setLatency(this);
+    // The first touch after the queued commands are done
+    _dwin->flush();
+    _touchMs = millis() - intervalMs;
+}
+
+void DwinLatency::inject()
+{
+    _lost = false;
+    _touchUs = micros();
+    _phase = PHASE_TOUCHED;
+    _touchMs = millis();
+    _touch(*_dwin, _x, _y);
+}
+
+bool DwinLatency::service()
+{
+    if (!_running) return false;
+    const latencyphase_t phase = _phase;
+    if (phase == PHASE_ACKED)
+    {
+        // The last LATENCY_MAX_SAMPLES touches are kept
+        const size_t slot = _count % LATENCY_MAX_SAMPLES;
+        _samples[LATENCY_UPLOAD][slot] = _uploadUs - _touchUs;
+        _samples[LATENCY_DISPATCH][slot] = _dispatchUs - _uploadUs;
+        _samples[LATENCY_APP][slot] = _queuedUs - _dispatchUs;
+        _samples[LATENCY_ACK][slot] = _ackUs - _queuedUs;
+        _samples[LATENCY_TOTAL][slot] = _ackUs - _touchUs;
+        if (_lost) _lostAcks++;
+        _count++;
+        _phase = PHASE_IDLE;
+    }
+    else if ((phase != PHASE_IDLE) && (millis() - _touchMs >= LATENCY_TIMEOUT_MS))
+    {
+        // Stage not finished
+        const latencystage_t stage = (phase == PHASE_TOUCHED) ? LATENCY_UPLOAD : (phase == PHASE_UPLOADED) ? LATENCY_APP : LATENCY_ACK;
+        Serial.printf("DwinLatency: touch %lu not acked in %d ms, no %s\n",
+                      (unsigned long)(_count + _timeouts), LATENCY_TIMEOUT_MS, stageName(stage));
+        _timeouts++;
+        _phase = PHASE_IDLE;
+    }
+
+    if (_phase != PHASE_IDLE) return true;
+    if (_count + _timeouts >= _touches)
+    {
+        _running = false;
+        _dwin->setLatency(nullptr);
+        return false;
+    }
+    if (millis() - _touchMs >= _intervalMs) inject();
+    return true;
+}
+
+bool DwinLatency::running()
+{
+    return _running;
+}
+
+void DwinLatency::uploaded(const uint16_t &vp, const uint32_t &rxUs, const uint32_t &dispatchUs)
+{
+    if ((_phase != PHASE_TOUCHED) || (vp != _buttonVp)) return;
+    _uploadUs = rxUs;
+    _dispatchUs = dispatchUs;
+    _phase = PHASE_UPLOADED;
+}
+
+void DwinLatency::queued(const uint8_t *command, const size_t &cmdLength, const uint32_t &lastFrame)
+{
+    if (_phase != PHASE_UPLOADED) return;
+    // Frames of the command: the first one writing the feedback VP
+    uint32_t frames = 0;
+    size_t found = cmdLength;
+    for (size_t pos = 0; (pos + 6 <= cmdLength) && (pos + command[pos+2] + 3 <= cmdLength); pos += command[pos+2] + 3)
+    {
+        const uint16_t vp = (command[pos+4] << 8) | command[pos+5];
+        if ((found == cmdLength) && (command[pos+3] == 0x82) && (vp == _feedbackVp)) found = frames;
+        frames++;
+    }
+    if (found == cmdLength) return;
+    _queuedUs = micros();
+    _ackFrame = lastFrame - (frames - 1 - found);
+    _phase = PHASE_QUEUED;
+}
+
+void DwinLatency::acked(const uint32_t &doneFrames, const uint8_t &lost)
+{
+    if (_phase != PHASE_QUEUED) return;
+    if (int32_t(doneFrames - _ackFrame) < 0) return;
+    _ackUs = micros();
+    _lost = (lost > 0);
+    _phase = PHASE_ACKED;
+}
+
+uint32_t DwinLatency::percentile(const latencystage_t &stage, const uint8_t &pct)
+{
+    const size_t count = std::min<size_t>(_count, LATENCY_MAX_SAMPLES);
+    if ((stage >= LATENCY_STAGES) || (count == 0)) return 0;
+    uint32_t sorted[LATENCY_MAX_SAMPLES];
+    std::copy(_samples[stage], _samples[stage] + count, sorted);
+    std::sort(sorted, sorted + count);
+    // Nearest rank
+    size_t rank = (count*std::min<uint8_t>(pct, 100) + 99)/100;
+    if (rank > 0) rank--;
+    return sorted[rank];
+}
+
+uint32_t DwinLatency::getCount()
+{
+    return _count;
+}
+
+uint32_t DwinLatency::getTimeouts()
+{
+    return _timeouts;
+}
+
+uint32_t DwinLatency::getLostAcks()
+{
+    return _lostAcks;
+}
+
+bool DwinLatency::check(const latencystage_t &stage, const uint8_t &pct, const uint32_t &limitUs)
+{
+    return (_count > 0) && (_timeouts == 0) && (percentile(stage, pct) <= limitUs);
+}
+
+const char *DwinLatency::stageName(const latencystage_t &stage)
+{
+    switch (stage)
+    {
+        case LATENCY_UPLOAD: return "upload";
+        case LATENCY_DISPATCH: return "dispatch";
+        case LATENCY_APP: return "app";
+        case LATENCY_ACK: return "ack";
+        case LATENCY_TOTAL: return "total";
+        default: return "?";
+    }
+}
+
+void DwinLatency::report(Print &out)
+{
+    out.printf("touches %lu, timeouts %lu, lost acks %lu\n",
+               (unsigned long)_count, (unsigned long)_timeouts, (unsigned long)_lostAcks);
+    out.printf("stage         p50 us    p90 us    p99 us    max us\n");
+    for (size_t i = 0; i < LATENCY_STAGES; i++)
+    {
+        const latencystage_t stage = latencystage_t(i);
+        out.printf("%-10s %9lu %9lu %9lu %9lu\n", stageName(stage),
+                   (unsigned long)percentile(stage, 50), (unsigned long)percentile(stage, 90),
+                   (unsigned long)percentile(stage, 99), (unsigned long)percentile(stage, 100));
+    }
+}
@@ -0,0 +1,145 @@
+//***************************************************
+//* Touch-to-feedback latency for DWIN2 library     *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Measures the time from a touch on the display to the acked write of the
+// application's response. Touches are injected one at a time, the bus
+// timestamps the stages of each (micros()):
+//  touch     the touch is injected
+//  upload    the auto-upload frame of the button VP is received by the bus
+//  callback  serviceUploads() calls the upload handlers
+//  queued    the first write to the feedback VP after the callback is queued
+//  acked     the display acked that write
+// and the report gives the percentiles of each stage and of the whole path:
+//
+//   DwinLatency latency(dwc);
+//   button.setUploadHandler([](DWIN2 &d, const uint16_t *data, const uint8_t &words) { led.sendData(data[0]); });
+//   latency.start(0x1000, 0x1010, 100, 200, 500);    // button VP, feedback VP, x, y, touches
+//   while (latency.service()) { dwc.serviceUploads(); }
+//   latency.report(Serial);
+//
+// Touch drivers: by default the DGUS touch simulation register (0x00D4) is
+// written, the touch at x, y is pressed and released by the display firmware,
+// so the "upload" stage includes the touch command on the line and the touch
+// processing. On the host give setTouchDriver() a function injecting the
+// touch into the simulated panel. check() compares a percentile with a limit,
+// e.g. as a regression gate of the UI responsiveness. In the DWIN_NO_RTOS
+// build call poll() of the display in the loop as well.
+
+#ifndef DwinLatency_h
+#define DwinLatency_h
+
+#include <Dwin2.h>
+
+// Samples kept for the percentiles
+#ifndef LATENCY_MAX_SAMPLES
+#define LATENCY_MAX_SAMPLES 256
+#endif
+// Max time from the touch to the ack, the touch is counted as a timeout after it
+#define LATENCY_TIMEOUT_MS 1000
+// DGUS touch simulation: 0x5AA5, mode, x, y
+#define LATENCY_TOUCH_VP 0x00D4
+// Press and release
+#define LATENCY_TOUCH_CLICK 0x0004
+
+typedef enum {
+    // Touch to the auto-upload frame received
+    LATENCY_UPLOAD,
+    // Received to the upload handler called
+    LATENCY_DISPATCH,
+    // Handler called to the feedback write queued
+    LATENCY_APP,
+    // Queued to the display ack
+    LATENCY_ACK,
+    // Touch to the ack
+    LATENCY_TOTAL,
+    LATENCY_STAGES
+} latencystage_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Latency class **************************************************************************************
+//***********************************************************************************************************************
+class DwinLatency
+{
+public:
+    // Inject the touch at x, y
+    typedef void (*TouchFunction)(DWIN2 &dwin, const uint16_t &x, const uint16_t &y);
+
+private:
+    typedef enum {
+        PHASE_IDLE,
+        PHASE_TOUCHED,
+        PHASE_UPLOADED,
+        PHASE_QUEUED,
+        PHASE_ACKED
+    } latencyphase_t;
+
+    DWIN2 *_dwin;
+    TouchFunction _touch;
+    uint16_t _buttonVp;
+    uint16_t _feedbackVp;
+    uint16_t _x;
+    uint16_t _y;
+    uint32_t _touches;
+    uint32_t _intervalMs;
+    uint32_t _touchMs;
+    bool _running;
+    // Timestamps of the touch in progress: set by the bus hooks, taken by service()
+    volatile latencyphase_t _phase;
+    volatile uint32_t _touchUs;
+    volatile uint32_t _uploadUs;
+    volatile uint32_t _dispatchUs;
+    volatile uint32_t _queuedUs;
+    volatile uint32_t _ackUs;
+    // Frame number of the feedback write, acked when doneFrames reaches it
+    volatile uint32_t _ackFrame;
+    volatile bool _lost;
+    // Samples of each stage, us
+    uint32_t _samples[LATENCY_STAGES][LATENCY_MAX_SAMPLES];
+    uint32_t _count;
+    uint32_t _timeouts;
+    uint32_t _lostAcks;
+
+    // Default driver: DGUS touch simulation register
+    static void touchPanel(DWIN2 &dwin, const uint16_t &x, const uint16_t &y);
+    void inject();
+
+public:
+    DwinLatency(DWIN2 &dwin);
+    ~DwinLatency();
+
+    void setTouchDriver(TouchFunction f);
+    // Inject touches at x, y, one every intervalMs after the previous one is acked or timed out.
+    // The button VP is uploaded by the display, the application writes the feedback VP in the upload handler
+    void start(const uint16_t &buttonVp, const uint16_t &feedbackVp, const uint16_t &x, const uint16_t &y,
+               const uint32_t &touches, const uint32_t &intervalMs = 50);
+    // Inject the touches and take the samples, call from the loop with serviceUploads().
+    // Returns false when all touches are measured
+    bool service();
+    bool running();
+
+    // Percentile (0..100) of the stage, us
+    uint32_t percentile(const latencystage_t &stage, const uint8_t &pct);
+    // Touches measured, timed out, and measured with a lost frame in the acked group
+    uint32_t getCount();
+    uint32_t getTimeouts();
+    uint32_t getLostAcks();
+    // No timeouts and the percentile of the stage is within limitUs
+    bool check(const latencystage_t &stage, const uint8_t &pct, const uint32_t &limitUs);
+    // Table of p50, p90, p99 and max of the stages
+    void report(Print &out);
+    static const char *stageName(const latencystage_t &stage);
+
+    // Bus hooks, see DWIN2::setLatency()
+    // The auto-upload frame of vp received at rxUs is passed to the handlers at dispatchUs
+    void uploaded(const uint16_t &vp, const uint32_t &rxUs, const uint32_t &dispatchUs);
+    // The command is queued, lastFrame is the number of its last frame on the bus
+    void queued(const uint8_t *command, const size_t &cmdLength, const uint32_t &lastFrame);
+    // Group done: doneFrames frames processed by the bus, lost of the group without answer
+    void acked(const uint32_t &doneFrames, const uint8_t &lost);
+};
+
+#endif
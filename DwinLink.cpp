@@ -0,0 +1,101 @@
+#include <DwinLink.h>
+
+// High byte of the token, the low byte is counted
+#define LINK_TOKEN_BASE 0xA500
+
+//***********************************************************************************************************************
+//************* DWIN Link class *****************************************************************************************
+//***********************************************************************************************************************
+DwinLink::DwinLink(DWIN2 &dwin, const uint16_t &markerVp)
+{
+    _dwin = &dwin;
+    _markerVp = markerVp;
+    _token = LINK_TOKEN_BASE;
+    _periodMs = LINK_PERIOD_MS;
+    _lastCheckMs = 0;
+    _state = LINK_UNKNOWN;
+    _failMs = 0;
+    _resyncCount = 0;
+    _recoveryMs = 0;
+}
+
+void DwinLink::begin(const uint32_t &periodMs)
+{
+    _periodMs = periodMs;
+#ifndef DWIN_NO_HEAP
+    _dwin->setShadow(true);
+#endif
+    writeToken();
+    _state = LINK_OK;
+    _lastCheckMs = millis();
+}
+
+void DwinLink::writeToken()
+{
+    // Never 0x0000 or 0xFFFF, the values of the cleared VP memory
+    _token = LINK_TOKEN_BASE | ((_token + 1) & 0xFF);
+    _dwin->writeBlock(_markerVp, &_token, 1);
+}
+
+bool DwinLink::service()
+{
+    const uint32_t nowMs = millis();
+    const uint32_t periodMs = (_state == LINK_LOST) ? LINK_RETRY_MS : _periodMs;
+    if (nowMs - _lastCheckMs < periodMs) return false;
+    _lastCheckMs = nowMs;
+
+    uint16_t marker = 0;
+    if (!_dwin->readWord(_markerVp, marker, LINK_TIMEOUT_MS))
+    {
+        if (_state != LINK_LOST)
+        {
+            Serial.printf("DwinLink: no answer from the display\n");
+            _state = LINK_LOST;
+            _failMs = nowMs;
+        }
+        return false;
+    }
+    if ((_state == LINK_OK) && (marker == _token)) return false;
+
+    // Reset detected now, or the display answers again after the lost link
+    if (_state != LINK_LOST) _failMs = nowMs;
+    recover();
+    return true;
+}
+
+void DwinLink::recover()
+{
+    _state = LINK_RESYNC;
+    size_t words = 0;
+#ifndef DWIN_NO_HEAP
+    words = _dwin->resync();
+#endif
+    writeToken();
+    if (_resync_cb != NULL) _resync_cb(*this);
+    _dwin->flush();
+    _recoveryMs = millis() - _failMs;
+    _resyncCount++;
+    _state = LINK_OK;
+    _lastCheckMs = millis();
+    Serial.printf("DwinLink: display state written back, %u words, %lu ms\n", (unsigned)words, (unsigned long)_recoveryMs);
+}
+
+linkstate_t DwinLink::getState()
+{
+    return _state;
+}
+
+uint32_t DwinLink::getResyncCount()
+{
+    return _resyncCount;
+}
+
+uint32_t DwinLink::getRecoveryMs()
+{
+    return _recoveryMs;
+}
+
+void DwinLink::setResyncHandler(ResyncFunction f)
+{
+    _resync_cb = f;
+}
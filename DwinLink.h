@@ -0,0 +1,91 @@
+//***************************************************
+//* Link health monitor for DWIN2 library           *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Heartbeat of the display port. The monitor writes a token to a marker VP
+// and reads it back once per period (one word read, 7 bytes each way).
+// VP memory is cleared by a display reset, so:
+//  - no answer          - the link is lost, the read is retried every LINK_RETRY_MS
+//  - another value      - the display was reset (restartHMI(), brown-out)
+// When the display answers again, the shadow state of the port (the last
+// values of the user VPs and the page, see DWIN2::setShadow()) is written
+// back in the max-size frames and the token is renewed. No fixed delays:
+// the answer to the heartbeat read is the ready signal.
+//
+// service() blocks for the read, call it from the loop or a task.
+// In the DWIN_NO_HEAP build there is no shadow state: the monitor detects
+// the reset and calls the resync handler only.
+
+#ifndef DwinLink_h
+#define DwinLink_h
+
+#include <Dwin2.h>
+
+// Marker VP, must not be used by the DGUS project
+#define LINK_MARKER_VP 0x7FFE
+// Heartbeat period while the link is ok, ms
+#define LINK_PERIOD_MS 500
+// Read period while the display does not answer, ms
+#define LINK_RETRY_MS 20
+// Answer timeout of the heartbeat read, ms
+#define LINK_TIMEOUT_MS 50
+
+typedef enum {
+    LINK_UNKNOWN,
+    LINK_OK,
+    // No answer to the heartbeat
+    LINK_LOST,
+    // Display is ready again, the state is written back
+    LINK_RESYNC
+} linkstate_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Link class *****************************************************************************************
+//***********************************************************************************************************************
+class DwinLink
+{
+private:
+    DWIN2 *_dwin;
+    uint16_t _markerVp;
+    uint16_t _token;
+    uint32_t _periodMs;
+    uint32_t _lastCheckMs;
+    linkstate_t _state;
+    // Start of the failure: the first missed heartbeat or the reset detection
+    uint32_t _failMs;
+    uint32_t _resyncCount;
+    uint32_t _recoveryMs;
+#ifndef DWIN_NO_HEAP
+    typedef std::function<void(DwinLink &link)> ResyncFunction;
+#else
+    typedef void (*ResyncFunction)(DwinLink &link);
+#endif
+    ResyncFunction _resync_cb = NULL;
+
+    // Write a new token to the marker VP
+    void writeToken();
+    // Write the state back after the display answered again
+    void recover();
+
+public:
+    DwinLink(DWIN2 &dwin, const uint16_t &markerVp = LINK_MARKER_VP);
+
+    // Enable the shadow state of the port and write the token
+    void begin(const uint32_t &periodMs = LINK_PERIOD_MS);
+    // Heartbeat, call often: checks the link once per period (LINK_RETRY_MS while lost).
+    // Returns true if the state was written back in this call
+    bool service();
+
+    linkstate_t getState();
+    // Number of recoveries and the time of the last one: from the failure to the state written back
+    uint32_t getResyncCount();
+    uint32_t getRecoveryMs();
+    // Called after the state is written back, e.g. to send what is not in the shadow state
+    // (DwinText::invalidate(), DwinPage...)
+    void setResyncHandler(ResyncFunction f);
+};
+
+#endif
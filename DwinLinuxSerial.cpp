@@ -0,0 +1,211 @@
+#include <DwinLinuxSerial.h>
+
+#ifdef DWIN_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+
+// termios speed of the baud rate, B0 if not supported
+static speed_t termiosSpeed(const uint32_t &baud)
+{
+    switch (baud)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return B0;
+    }
+}
+
+//***********************************************************************************************************************
+//************* DWIN Linux serial transport *****************************************************************************
+//***********************************************************************************************************************
+DwinLinuxSerial::DwinLinuxSerial(const char *path, const uint32_t &baud)
+{
+    _path = path;
+    _baud = baud;
+    _fd = -1;
+    _epollFd = -1;
+    _ownFd = false;
+    _hangup = false;
+}
+
+DwinLinuxSerial::DwinLinuxSerial(const int &fd, const uint32_t &baud)
+{
+    _path = "fd";
+    _baud = baud;
+    _fd = fd;
+    _epollFd = -1;
+    _ownFd = false;
+    _hangup = false;
+}
+
+DwinLinuxSerial::~DwinLinuxSerial()
+{
+    if (_epollFd >= 0) close(_epollFd);
+    if (_ownFd && (_fd >= 0)) close(_fd);
+}
+
+bool DwinLinuxSerial::begin(const uint8_t &rxPin, const uint8_t &txPin)
+{
+    // The tty has no pins to set
+    (void)rxPin;
+    (void)txPin;
+    const speed_t speed = termiosSpeed(_baud);
+    if (speed == B0)
+    {
+        Serial.printf("DwinLinuxSerial: %lu baud is not supported\n", (unsigned long)_baud);
+        return false;
+    }
+    if (_fd < 0)
+    {
+        _fd = open(_path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (_fd < 0)
+        {
+            Serial.printf("DwinLinuxSerial: %s not opened, %s\n", _path, strerror(errno));
+            return false;
+        }
+        _ownFd = true;
+    }
+    else
+    {
+        fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    // Raw 8N1, no flow control, read() returns what is received
+    termios tio;
+    if (tcgetattr(_fd, &tio) != 0)
+    {
+        Serial.printf("DwinLinuxSerial: %s is not a tty, %s\n", _path, strerror(errno));
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(_fd, TCSANOW, &tio) != 0)
+    {
+        Serial.printf("DwinLinuxSerial: %s settings failed, %s\n", _path, strerror(errno));
+        return false;
+    }
+    // USB-serial adapters buffer the answer up to their latency timer without it
+    serial_struct serial;
+    if (ioctl(_fd, TIOCGSERIAL, &serial) == 0)
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(_fd, TIOCSSERIAL, &serial);
+    }
+    tcflush(_fd, TCIOFLUSH);
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = _fd;
+    if ((_epollFd < 0) || (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _fd, &event) != 0))
+    {
+        Serial.printf("DwinLinuxSerial: epoll failed, %s\n", strerror(errno));
+        return false;
+    }
+    _hangup = false;
+    return true;
+}
+
+bool DwinLinuxSerial::waitWritable(const uint32_t &timeoutMs)
+{
+    pollfd pfd = {};
+    pfd.fd = _fd;
+    pfd.events = POLLOUT;
+    int ready;
+    do
+    {
+        ready = poll(&pfd, 1, timeoutMs);
+    } while ((ready < 0) && (errno == EINTR));
+    return (ready > 0) && (pfd.revents & POLLOUT);
+}
+
+size_t DwinLinuxSerial::write(const uint8_t *data, const size_t &len)
+{
+    if (_fd < 0) return 0;
+    // Time of the bytes on the line: 10 bits per byte
+    const uint32_t timeoutMs = len*10000/_baud + LINUX_TX_TIMEOUT_MS;
+    size_t sent = 0;
+    while (sent < len)
+    {
+        const ssize_t n = ::write(_fd, data + sent, len - sent);
+        if (n > 0)
+        {
+            sent += n;
+            continue;
+        }
+        if ((n < 0) && (errno == EINTR)) continue;
+        if ((n < 0) && (errno != EAGAIN)) break;
+        // TX buffer of the tty is full
+        if (!waitWritable(timeoutMs)) break;
+    }
+    if (sent < len) Serial.printf("DwinLinuxSerial: %u of %u bytes sent\n", (unsigned)sent, (unsigned)len);
+    return sent;
+}
+
+size_t DwinLinuxSerial::available()
+{
+    int rxLen = 0;
+    if ((_fd < 0) || (ioctl(_fd, FIONREAD, &rxLen) != 0)) return 0;
+    return rxLen > 0 ? rxLen : 0;
+}
+
+size_t DwinLinuxSerial::read(uint8_t *data, const size_t &len)
+{
+    if ((_fd < 0) || (len == 0)) return 0;
+    ssize_t n;
+    do
+    {
+        n = ::read(_fd, data, len);
+    } while ((n < 0) && (errno == EINTR));
+    return n > 0 ? n : 0;
+}
+
+void DwinLinuxSerial::flushInput()
+{
+    if (_fd >= 0) tcflush(_fd, TCIFLUSH);
+}
+
+bool DwinLinuxSerial::waitRx(const uint32_t &timeoutMs)
+{
+    if (_epollFd < 0) return false;
+    epoll_event event;
+    int ready;
+    do
+    {
+        ready = epoll_wait(_epollFd, &event, 1, timeoutMs);
+    } while ((ready < 0) && (errno == EINTR));
+    if (ready <= 0) return false;
+    if (event.events & EPOLLIN) return true;
+    if (!_hangup)
+    {
+        _hangup = true;
+        Serial.printf("DwinLinuxSerial: %s closed\n", _path);
+    }
+    // Hangup is reported by every epoll_wait() call, sleep instead of spinning
+    poll(nullptr, 0, timeoutMs);
+    return false;
+}
+
+int DwinLinuxSerial::getFd()
+{
+    return _fd;
+}
+#endif
@@ -0,0 +1,67 @@
+//***************************************************
+//* Linux serial transport for DWIN2 library        *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Display port of a Linux gateway: a USB-serial adapter (/dev/ttyUSB0) or
+// any tty, e.g. the slave side of a pseudo-terminal. The tty is raw and
+// non-blocking, received bytes are waited for with epoll, so wait(),
+// flush() and the reads sleep until the answer instead of spinning.
+// Each group of frames is one write() call, the rest of a partial write
+// is sent when the tty is writable again. Low latency mode is requested
+// from the adapter driver (FTDI latency timer), ignored if not supported.
+//
+// Build the library with -DDWIN_LINUX and set the transport before begin():
+//   DwinLinuxSerial serial("/dev/ttyUSB0");
+//   DWIN2::setTransport(HW_SERIAL_NUM, &serial);
+//   dwc.begin(0x5000, 0x1000);
+
+#ifndef DwinLinuxSerial_h
+#define DwinLinuxSerial_h
+
+#ifdef DWIN_LINUX
+#include <Dwin2.h>
+
+// Max time to pass a group to a full tty TX buffer, in addition to its time on the line
+#define LINUX_TX_TIMEOUT_MS 100
+
+
+//***********************************************************************************************************************
+//************* DWIN Linux serial transport *****************************************************************************
+//***********************************************************************************************************************
+class DwinLinuxSerial : public DwinTransport
+{
+private:
+    const char *_path;
+    uint32_t _baud;
+    int _fd;
+    int _epollFd;
+    // The fd was opened by begin() and is closed by the destructor
+    bool _ownFd;
+    // The other side of the tty is closed, reported once
+    bool _hangup;
+
+    // Wait until the tty takes more bytes, false on timeout
+    bool waitWritable(const uint32_t &timeoutMs);
+
+public:
+    // Port by its path, the path is not copied
+    DwinLinuxSerial(const char *path, const uint32_t &baud = DWIN_BAUDRATE);
+    // Already open tty, e.g. the slave of a pseudo-terminal pair. It is set raw and non-blocking by begin()
+    DwinLinuxSerial(const int &fd, const uint32_t &baud = DWIN_BAUDRATE);
+    ~DwinLinuxSerial();
+
+    bool begin(const uint8_t &rxPin, const uint8_t &txPin) override;
+    size_t write(const uint8_t *data, const size_t &len) override;
+    size_t available() override;
+    size_t read(uint8_t *data, const size_t &len) override;
+    void flushInput() override;
+    bool waitRx(const uint32_t &timeoutMs) override;
+    uint32_t getBaud() override { return _baud; }
+    // File descriptor of the tty, -1 before begin()
+    int getFd();
+};
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+#include <DwinListView.h>
+
+//***********************************************************************************************************************
+//************* DWIN List View class ************************************************************************************
+//***********************************************************************************************************************
+DwinListView::DwinListView(DWIN2 &dwin, const uint8_t &rows, const uitype_t &uitype)
+{
+    _dwin = &dwin;
+    _rows = rows > 0 ? rows : 1;
+    _uitype = uitype;
+    _vpHexAddr = 0;
+    _vpStep = 0x10;
+    _spHexAddr = 0;
+    _spStep = 0x10;
+    _x = 0;
+    _y = 0;
+    _rowHeight = 0;
+    _count = 0;
+    _first = 0;
+    _cacheNext = 0;
+    _slotIndex.assign(_rows, -1);
+    _slotLine.assign(_rows, -1);
+    _cache.reserve(_rows*LISTVIEW_CACHE_PAGES);
+}
+
+void DwinListView::setAddress(const uint16_t &spHexAddr, const uint16_t &vpHexAddr, const uint16_t &spStep, const uint16_t &vpStep)
+{
+    _spHexAddr = spHexAddr;
+    _vpHexAddr = vpHexAddr;
+    _spStep = spStep;
+    _vpStep = vpStep;
+    invalidateAll();
+}
+
+void DwinListView::setGeometry(const uint16_t &x, const uint16_t &y, const uint16_t &rowHeight)
+{
+    _x = x;
+    _y = y;
+    _rowHeight = rowHeight;
+    _slotLine.assign(_rows, -1);
+}
+
+void DwinListView::setSource(RowSourceFunction f, const size_t &count)
+{
+    _source = f;
+    _count = count;
+    invalidateAll();
+}
+
+void DwinListView::setCount(const size_t &count)
+{
+    _count = count;
+    render();
+}
+
+void DwinListView::scrollTo(const size_t &first)
+{
+    _first = first;
+    render();
+}
+
+void DwinListView::scroll(const int &delta)
+{
+    if ((delta < 0) && (static_cast<size_t>(-delta) > _first)) _first = 0;
+    else _first += delta;
+    render();
+}
+
+void DwinListView::invalidate(const size_t &index)
+{
+    for (auto it = _cache.begin(); it != _cache.end(); ++it)
+    {
+        if (it->index == index)
+        {
+            // Entry is not reused until it is replaced
+            it->index = SIZE_MAX;
+            break;
+        }
+    }
+    const uint8_t slot = index % _rows;
+    if (_slotIndex[slot] == static_cast<int32_t>(index))
+    {
+        _slotIndex[slot] = -1;
+        render();
+    }
+}
+
+void DwinListView::invalidateAll()
+{
+    _cache.clear();
+    _cacheNext = 0;
+    _slotIndex.assign(_rows, -1);
+    _slotLine.assign(_rows, -1);
+    if (_source != NULL) render();
+}
+
+size_t DwinListView::getFirst()
+{
+    return _first;
+}
+
+const std::vector<uint8_t> &DwinListView::rowFrame(const size_t &index)
+{
+    for (auto it = _cache.begin(); it != _cache.end(); ++it)
+    {
+        if (it->index == index) return it->frame;
+    }
+
+    // Not cached, encode and replace the oldest entry
+    const uint16_t vp = _vpHexAddr + (index % _rows)*_vpStep;
+    uirowframe_t *entry;
+    if (_cache.size() < _rows*LISTVIEW_CACHE_PAGES)
+    {
+        _cache.push_back(uirowframe_t());
+        entry = &_cache.back();
+    }
+    else
+    {
+        entry = &_cache[_cacheNext];
+        _cacheNext = (_cacheNext + 1) % _cache.size();
+    }
+    entry->index = index;
+    DWIN2::encodeText(_uitype, vp, _source(index), entry->frame);
+    return entry->frame;
+}
+
+void DwinListView::addPosFrame(std::vector<uint8_t> &frames, const uint8_t &slot, const uint16_t &line)
+{
+    // Position is stored after the VP pointer of the SP
+    const uint16_t spPosAddr = _spHexAddr + slot*_spStep + 1;
+    const uint16_t y = _y + line*_rowHeight;
+    frames.insert(frames.end(), {0x5A, 0xA5, 0x07, 0x82, highByte(spPosAddr), lowByte(spPosAddr),
+                                 highByte(_x), lowByte(_x), highByte(y), lowByte(y)});
+}
+
+void DwinListView::render()
+{
+    if (_source == NULL) return;
+    // Do not scroll past the end of the data
+    if (_first + _rows > _count) _first = (_count > _rows) ? _count - _rows : 0;
+
+    // All changes are collected and queued at once
+    std::vector<uint8_t> frames;
+    for (uint8_t line = 0; line < _rows; line++)
+    {
+        const size_t index = _first + line;
+        const uint8_t slot = index % _rows;
+        if (index >= _count)
+        {
+            // No data for the line, clear the slot
+            if (_slotIndex[slot] != -1)
+            {
+                std::vector<uint8_t> frame;
+                DWIN2::encodeText(_uitype, _vpHexAddr + slot*_vpStep, "", frame);
+                frames.insert(frames.end(), frame.begin(), frame.end());
+                _slotIndex[slot] = -1;
+            }
+            continue;
+        }
+        // New row for the slot, write its text
+        if (_slotIndex[slot] != static_cast<int32_t>(index))
+        {
+            const std::vector<uint8_t> &frame = rowFrame(index);
+            frames.insert(frames.end(), frame.begin(), frame.end());
+            _slotIndex[slot] = index;
+        }
+        // The row is already shown by the slot, only move it
+        if ((_rowHeight > 0) && (_slotLine[slot] != line))
+        {
+            addPosFrame(frames, slot, line);
+            _slotLine[slot] = line;
+        }
+    }
+    if (frames.size() > 0) _dwin->sendRawCommand(frames.data(), frames.size());
+}
@@ -0,0 +1,92 @@
+//***************************************************
+//* Virtualized scrolling list for DWIN2 library    *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// A fixed set of text VPs (row slots) shows a window of a large data set.
+// Data row i is always drawn by slot i % rows, so on scrolling the rows
+// that stay visible are only moved to the new line through the SP position,
+// and only the newly visible rows get their text written.
+// Encoded text frames are cached, scrolling back does not encode them again.
+
+#ifndef DwinListView_h
+#define DwinListView_h
+
+#include <Dwin2.h>
+
+// Number of cached encoded rows per visible row
+#define LISTVIEW_CACHE_PAGES 3
+
+typedef struct {
+    size_t index;
+    std::vector<uint8_t> frame;
+} uirowframe_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN List View class ************************************************************************************
+//***********************************************************************************************************************
+class DwinListView
+{
+public:
+    typedef std::function<String(const size_t &index)> RowSourceFunction;
+
+private:
+    DWIN2 *_dwin;
+    uitype_t _uitype;
+    uint8_t _rows;
+
+    // Addresses of the first row slot and the step to the next one
+    uint16_t _vpHexAddr;
+    uint16_t _vpStep;
+    uint16_t _spHexAddr;
+    uint16_t _spStep;
+    // Position of the first line and line height in pixels
+    uint16_t _x;
+    uint16_t _y;
+    uint16_t _rowHeight;
+
+    RowSourceFunction _source = NULL;
+    size_t _count;
+    size_t _first;
+
+    // Data row index and line shown by each slot, -1 if nothing
+    std::vector<int32_t> _slotIndex;
+    std::vector<int16_t> _slotLine;
+
+    // Cache of encoded text frames, the oldest entry is replaced first
+    std::vector<uirowframe_t> _cache;
+    size_t _cacheNext;
+
+    // Encoded text frame of the data row, from the cache if possible
+    const std::vector<uint8_t> &rowFrame(const size_t &index);
+    // Append the SP position command of the slot
+    void addPosFrame(std::vector<uint8_t> &frames, const uint8_t &slot, const uint16_t &line);
+    // Update the slots and send the changes as one batch
+    void render();
+
+public:
+    DwinListView(DWIN2 &dwin, const uint8_t &rows, const uitype_t &uitype = UTF);
+
+    // Set the addresses of the first row slot and the step to the next slot
+    void setAddress(const uint16_t &spHexAddr, const uint16_t &vpHexAddr, const uint16_t &spStep = 0x10, const uint16_t &vpStep = 0x10);
+    // Set the position of the first line and the line height in pixels
+    void setGeometry(const uint16_t &x, const uint16_t &y, const uint16_t &rowHeight);
+    // Set the callback returning the text of a data row and the number of rows
+    void setSource(RowSourceFunction f, const size_t &count);
+    // Change the number of data rows (new rows appended to a log)
+    void setCount(const size_t &count);
+    // Show the data rows starting from first
+    void scrollTo(const size_t &first);
+    // Scroll by delta rows, negative delta scrolls up
+    void scroll(const int &delta);
+    // Text of the data row changed, redraw it if visible
+    void invalidate(const size_t &index);
+    // Forget everything shown on the display and redraw the visible rows
+    void invalidateAll();
+    // First visible data row
+    size_t getFirst();
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include <DwinPage.h>
+
+// Define static variables
+std::vector<DwinPage*> DwinPage::_pages;
+uint8_t DwinPage::_currentPage = 0;
+bool DwinPage::_initActive = false;
+uint32_t DwinPage::_firstScreenMs = 0;
+
+//***********************************************************************************************************************
+//************* DWIN Page class *****************************************************************************************
+//***********************************************************************************************************************
+DwinPage::DwinPage(DWIN2 &dwin, const uint8_t &pageNum)
+{
+    _dwin = &dwin;
+    _pageNum = pageNum;
+    _pages.push_back(this);
+}
+
+DwinPage::~DwinPage()
+{
+    _pages.erase(std::remove(_pages.begin(), _pages.end(), this), _pages.end());
+}
+
+void DwinPage::addElement(DWIN2 &element)
+{
+    _elements.push_back(&element);
+    element.setDeferred(_initActive || (_pageNum != _currentPage));
+}
+
+bool DwinPage::prepare(const uint32_t &timeoutMs)
+{
+    // Init frames not sent in the background yet go first
+    std::vector<uint8_t> commands;
+    commands.swap(_bulk);
+    for (auto it = _elements.begin(); it != _elements.end(); ++it)
+    {
+        (*it)->takePending(commands);
+    }
+    if (commands.size() == 0) return true;
+
+    std::vector<uint8_t> frames;
+    DWIN2::coalesce(commands, frames);
+    _dwin->sendRawCommand(frames.data(), frames.size());
+    return _dwin->flush(timeoutMs);
+}
+
+uint8_t DwinPage::getPageNum()
+{
+    return _pageNum;
+}
+
+DwinPage *DwinPage::findPage(const uint8_t &pageNum)
+{
+    for (auto it = _pages.begin(); it != _pages.end(); ++it)
+    {
+        if ((*it)->_pageNum == pageNum) return *it;
+    }
+    return nullptr;
+}
+
+bool DwinPage::preparePage(const uint8_t &pageNum, const uint32_t &timeoutMs)
+{
+    DwinPage *page = findPage(pageNum);
+    if (page == nullptr)
+    {
+        Serial.printf("DwinPage ERR preparePage() page %d not found\n", pageNum);
+        return false;
+    }
+    return page->prepare(timeoutMs);
+}
+
+bool DwinPage::setPage(const uint8_t &pageNum, const uint32_t &timeoutMs)
+{
+    DwinPage *page = findPage(pageNum);
+    if (page == nullptr)
+    {
+        Serial.printf("DwinPage ERR setPage() page %d not found\n", pageNum);
+        return false;
+    }
+    // The page is not switched to values the display has not acked
+    if (!page->prepare(timeoutMs))
+    {
+        Serial.printf("DwinPage ERR setPage() page %d values not acked\n", pageNum);
+        return false;
+    }
+
+    // Elements of the other pages keep their commands from now on
+    deferOtherPages(pageNum);
+    // Values changed while waiting for the acks are sent before the switch
+    if (!page->prepare(timeoutMs))
+    {
+        Serial.printf("DwinPage ERR setPage() page %d values not acked\n", pageNum);
+        deferOtherPages(_currentPage);
+        return false;
+    }
+
+    page->_dwin->setPage(pageNum);
+    _currentPage = pageNum;
+    return true;
+}
+
+void DwinPage::deferOtherPages(const uint8_t &pageNum)
+{
+    for (auto pit = _pages.begin(); pit != _pages.end(); ++pit)
+    {
+        for (auto it = (*pit)->_elements.begin(); it != (*pit)->_elements.end(); ++it)
+        {
+            (*it)->setDeferred((*pit)->_pageNum != pageNum);
+        }
+    }
+}
+
+uint8_t DwinPage::getCurrentPage()
+{
+    return _currentPage;
+}
+
+void DwinPage::beginInit()
+{
+    _initActive = true;
+    for (auto pit = _pages.begin(); pit != _pages.end(); ++pit)
+    {
+        for (auto it = (*pit)->_elements.begin(); it != (*pit)->_elements.end(); ++it) (*it)->setDeferred(true);
+    }
+}
+
+bool DwinPage::endInit(const uint8_t &visiblePage, const uint32_t &timeoutMs)
+{
+    _initActive = false;
+    DwinPage *page = findPage(visiblePage);
+    if (page == nullptr)
+    {
+        Serial.printf("DwinPage ERR endInit() page %d not found\n", visiblePage);
+        return false;
+    }
+    // ESP32 boots faster than the display, wait for its answer instead of a fixed delay
+    if (!page->_dwin->waitReady(PAGE_READY_TIMEOUT_MS))
+    {
+        Serial.printf("DwinPage ERR endInit() no answer from the display\n");
+    }
+
+    // Values of the other pages are sent in the background
+    for (auto pit = _pages.begin(); pit != _pages.end(); ++pit)
+    {
+        if (*pit == page) continue;
+        std::vector<uint8_t> commands;
+        for (auto it = (*pit)->_elements.begin(); it != (*pit)->_elements.end(); ++it) (*it)->takePending(commands);
+        DWIN2::coalesce(commands, (*pit)->_bulk);
+    }
+
+    // Visible page first, the first screen is there when the page switch is acked
+    if (!setPage(visiblePage, timeoutMs) || !page->_dwin->flush(timeoutMs)) return false;
+    _firstScreenMs = millis();
+    return true;
+}
+
+bool DwinPage::serviceBulk(const size_t &maxBytes)
+{
+    for (auto pit = _pages.begin(); pit != _pages.end(); ++pit)
+    {
+        std::vector<uint8_t> &bulk = (*pit)->_bulk;
+        if (bulk.size() == 0) continue;
+        // Bulk priority: only when the commands sent by the application are gone
+        if ((*pit)->_dwin->pendingTxBytes() > 0) return true;
+
+        // Whole frames up to maxBytes, at least one
+        size_t len = 0;
+        while ((len + 3 <= bulk.size()) && (len + bulk[len+2] + 3 <= bulk.size()))
+        {
+            const size_t frameLen = bulk[len+2] + 3;
+            if ((len > 0) && (len + frameLen > maxBytes)) break;
+            len += frameLen;
+        }
+        if (len == 0)
+        {
+            // Broken tail
+            bulk.clear();
+            continue;
+        }
+        (*pit)->_dwin->sendRawCommand(bulk.data(), len);
+        bulk.erase(bulk.begin(), bulk.begin() + len);
+        return true;
+    }
+    return false;
+}
+
+uint32_t DwinPage::getFirstScreenMs()
+{
+    return _firstScreenMs;
+}
@@ -0,0 +1,84 @@
+//***************************************************
+//* Display pages for DWIN2 library                 *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// A page knows its UI elements. While the page is not shown, the elements
+// keep their last commands (deferred mode) instead of sending them.
+// preparePage() sends the kept values as coalesced frames, and setPage()
+// switches the page only after those values are acked by the display,
+// so the page appears with up-to-date values.
+//
+// Boot-time init: between beginInit() and endInit() all page elements keep
+// their commands. endInit() sends the visible page first as coalesced frames
+// and switches to it, the other pages are sent by serviceBulk() afterwards,
+// a chunk at a time when the port is idle. The time from power-on to the
+// acked switch to the first screen is kept for getFirstScreenMs().
+
+#ifndef DwinPage_h
+#define DwinPage_h
+
+#include <Dwin2.h>
+
+// Max bytes queued by one serviceBulk() call
+#define PAGE_BULK_CHUNK 512
+// Time for the display to boot at power-on
+#define PAGE_READY_TIMEOUT_MS 3000
+
+
+//***********************************************************************************************************************
+//************* DWIN Page class *****************************************************************************************
+//***********************************************************************************************************************
+class DwinPage
+{
+private:
+    // All created pages and the page shown on the display
+    static std::vector<DwinPage*> _pages;
+    static uint8_t _currentPage;
+    // Boot-time init: all elements keep their commands
+    static bool _initActive;
+    static uint32_t _firstScreenMs;
+
+    // Object for the common display commands
+    DWIN2 *_dwin;
+    uint8_t _pageNum;
+    std::vector<DWIN2*> _elements;
+    // Coalesced frames of the init waiting for serviceBulk()
+    std::vector<uint8_t> _bulk;
+
+    static DwinPage *findPage(const uint8_t &pageNum);
+    // Elements of the pages other than pageNum keep their commands
+    static void deferOtherPages(const uint8_t &pageNum);
+
+public:
+    DwinPage(DWIN2 &dwin, const uint8_t &pageNum);
+    ~DwinPage();
+
+    // Add the UI element shown on the page
+    void addElement(DWIN2 &element);
+    // Send the values changed while the page was not shown, wait for the acks
+    bool prepare(const uint32_t &timeoutMs = 500);
+    uint8_t getPageNum();
+
+    // Prepare page pageNum
+    static bool preparePage(const uint8_t &pageNum, const uint32_t &timeoutMs = 500);
+    // Prepare page pageNum and switch to it. Returns false without switching if the values
+    // were not acked in time
+    static bool setPage(const uint8_t &pageNum, const uint32_t &timeoutMs = 500);
+    // Page shown on the display
+    static uint8_t getCurrentPage();
+
+    // Start the boot-time init: the values of all page elements are kept until endInit()
+    static void beginInit();
+    // Wait for the display, send the values of the visible page and switch to it.
+    // The other pages go to serviceBulk(). Returns false if the values or the switch were not acked in time
+    static bool endInit(const uint8_t &visiblePage, const uint32_t &timeoutMs = 500);
+    // Send the next chunk of the other pages if the port is idle, call from the loop.
+    // Returns true while there is something to send
+    static bool serviceBulk(const size_t &maxBytes = PAGE_BULK_CHUNK);
+    // Time from power-on to the first screen, ms (0 - endInit() was not called or failed)
+    static uint32_t getFirstScreenMs();
+};
+
+#endif
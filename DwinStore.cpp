@@ -0,0 +1,252 @@
+#include <DwinStore.h>
+
+// System variable for the NOR flash read/write
+#define NOR_ACCESS_VP 0x0008
+#define NOR_READ 0x5A
+#define NOR_WRITE 0xA5
+#define NOR_TIMEOUT_MS 1000
+
+#define RECORD_MARKER 0x5AA5
+#define RECORD_HEADER 4
+#define RECORD_REMOVED 0x8000
+
+#define STORE_HEADER 2
+
+//***********************************************************************************************************************
+//************* DWIN Store class ****************************************************************************************
+//***********************************************************************************************************************
+DwinStore::DwinStore(DWIN2 &dwin, const uint32_t &norAddr, const uint32_t &norWords, const uint16_t &vpBufAddr, const uint16_t &vpBufWords)
+{
+    _dwin = &dwin;
+    // NOR flash is accessed by even addresses and even lengths
+    _norAddr = norAddr & ~1UL;
+    _norWords = norWords & ~1UL;
+    _vpBufAddr = vpBufAddr & ~1U;
+    _vpBufWords = vpBufWords & ~1U;
+    _areaWords = ((_norWords - STORE_HEADER) / 2) & ~1UL;
+    _area = 0;
+    _logEnd = 0;
+}
+
+uint32_t DwinStore::areaAddr(const uint8_t &area)
+{
+    return _norAddr + STORE_HEADER + area*_areaWords;
+}
+
+bool DwinStore::norAccess(const uint8_t &mode, const uint32_t &norAddr, const uint16_t &words)
+{
+    // Mode, NOR address (3 bytes), VP address, number of words
+    const uint16_t command[4] = {
+        static_cast<uint16_t>((mode << 8) | ((norAddr >> 16) & 0xFF)),
+        static_cast<uint16_t>(norAddr & 0xFFFF),
+        _vpBufAddr,
+        words
+    };
+    _dwin->writeBlock(NOR_ACCESS_VP, command, 4);
+
+    // The display clears the mode byte at the end of the operation
+    const uint32_t startMs = millis();
+    while (millis() - startMs < NOR_TIMEOUT_MS)
+    {
+        uint16_t state = mode << 8;
+        if ((_dwin->readBlock(NOR_ACCESS_VP, &state, 1) == 1) && (highByte(state) == 0)) return true;
+        _dwin->wait(2);
+    }
+    Serial.printf("DwinStore ERR NOR access timeout at 0x%06lX\n", (unsigned long)norAddr);
+    return false;
+}
+
+bool DwinStore::writeLog(const uint32_t &norAddr, const uint16_t *data, const size_t &count)
+{
+    size_t done = 0;
+    while (done < count)
+    {
+        const uint16_t words = std::min<size_t>(count - done, _vpBufWords);
+        _dwin->writeBlock(_vpBufAddr, &data[done], words);
+        if (!norAccess(NOR_WRITE, norAddr + done, words)) return false;
+        done += words;
+    }
+    return true;
+}
+
+void DwinStore::addRecord(std::vector<uint16_t> &log, const uint16_t &key, const uint16_t *value, const uint16_t &count, const bool &removed)
+{
+    const uint16_t countWord = removed ? RECORD_REMOVED : count;
+    uint16_t sum = RECORD_MARKER + key + countWord;
+    for (uint16_t i = 0; i < count; i++) sum += value[i];
+
+    log.insert(log.end(), {RECORD_MARKER, key, countWord, sum});
+    log.insert(log.end(), value, value + count);
+    // Records start at even addresses
+    if ((RECORD_HEADER + count) % 2 != 0) log.push_back(0xFFFF);
+}
+
+size_t DwinStore::parseLog(const uint16_t *data, const size_t &count, bool &end)
+{
+    size_t i = 0;
+    while (i + 2 <= count)
+    {
+        // End marker, erased or damaged flash
+        if (data[i] != RECORD_MARKER)
+        {
+            end = true;
+            return i;
+        }
+        // Header is in the next buffer
+        if (i + RECORD_HEADER > count) break;
+        const uint16_t key = data[i+1];
+        const bool removed = (data[i+2] & RECORD_REMOVED) != 0;
+        const uint16_t valCount = removed ? 0 : data[i+2];
+        const size_t stride = (RECORD_HEADER + valCount + 1) & ~1UL;
+        if (i + stride > count) break;
+
+        uint16_t sum = RECORD_MARKER + key + data[i+2];
+        for (uint16_t k = 0; k < valCount; k++) sum += data[i + RECORD_HEADER + k];
+        if (sum != data[i+3])
+        {
+            // Interrupted commit, the log ends here
+            end = true;
+            return i;
+        }
+
+        if (removed) _table.erase(key);
+        else _table[key].assign(&data[i + RECORD_HEADER], &data[i + RECORD_HEADER + valCount]);
+        i += stride;
+    }
+    return i;
+}
+
+bool DwinStore::begin()
+{
+    _table.clear();
+    _batch.clear();
+    _logEnd = 0;
+#ifndef DWIN_NO_HEAP
+    // The VP buffer is not replayed after a display reset
+    _dwin->excludeShadowRange(_vpBufAddr, _vpBufWords);
+#endif
+
+    // Erased flash or interrupted header write: the first area
+    uint16_t header[STORE_HEADER];
+    if (!norAccess(NOR_READ, _norAddr, STORE_HEADER)) return false;
+    if (_dwin->readBlock(_vpBufAddr, header, STORE_HEADER) != STORE_HEADER) return false;
+    _area = ((header[0] == RECORD_MARKER) && (header[1] == 1)) ? 1 : 0;
+
+    std::vector<uint16_t> buf(_vpBufWords);
+    bool end = false;
+    uint32_t pos = 0;
+    while (!end && (pos < _areaWords))
+    {
+        const uint16_t words = std::min<uint32_t>(_vpBufWords, _areaWords - pos);
+        if (!norAccess(NOR_READ, areaAddr(_area) + pos, words)) return false;
+        if (_dwin->readBlock(_vpBufAddr, buf.data(), words) != words) return false;
+        const size_t parsed = parseLog(buf.data(), words, end);
+        // Record does not fit the buffer
+        if (parsed == 0) end = true;
+        pos += parsed;
+    }
+    _logEnd = pos;
+    return true;
+}
+
+bool DwinStore::put(const uint16_t &key, const uint16_t *value, const size_t &count)
+{
+    // begin() parses the log through the VP buffer, a larger record would end the log there
+    if ((count >= RECORD_REMOVED) || (RECORD_HEADER + count > _vpBufWords))
+    {
+        Serial.printf("DwinStore ERR put() key %u: %u words do not fit the VP buffer\n", (unsigned)key, (unsigned)count);
+        return false;
+    }
+    _table[key].assign(value, value + count);
+    addRecord(_batch, key, value, count, false);
+    if (_batch.size() >= STORE_AUTOCOMMIT_WORDS) commit();
+    return true;
+}
+
+bool DwinStore::putInt(const uint16_t &key, const int32_t &value)
+{
+    const uint16_t words[2] = {static_cast<uint16_t>(value >> 16), static_cast<uint16_t>(value & 0xFFFF)};
+    return put(key, words, 2);
+}
+
+size_t DwinStore::get(const uint16_t &key, uint16_t *value, const size_t &maxCount)
+{
+    auto it = _table.find(key);
+    if (it == _table.end()) return 0;
+    const size_t count = std::min(maxCount, it->second.size());
+    memcpy(value, it->second.data(), count*sizeof(uint16_t));
+    return count;
+}
+
+int32_t DwinStore::getInt(const uint16_t &key, const int32_t &defaultVal)
+{
+    uint16_t words[2];
+    if (get(key, words, 2) != 2) return defaultVal;
+    return static_cast<int32_t>((static_cast<uint32_t>(words[0]) << 16) | words[1]);
+}
+
+bool DwinStore::contains(const uint16_t &key)
+{
+    return _table.find(key) != _table.end();
+}
+
+void DwinStore::remove(const uint16_t &key)
+{
+    if (_table.erase(key) == 0) return;
+    addRecord(_batch, key, nullptr, 0, true);
+}
+
+bool DwinStore::commit()
+{
+    if (_batch.size() == 0) return true;
+    // No room for the batch and the end marker
+    if (_logEnd + _batch.size() + 2 > _areaWords) return compact();
+
+    _batch.insert(_batch.end(), {0x0000, 0x0000});
+    const bool ok = writeLog(areaAddr(_area) + _logEnd, _batch.data(), _batch.size());
+    if (ok)
+    {
+        _logEnd += _batch.size() - 2;
+        _batch.clear();
+    }
+    else
+    {
+        // Keep the batch for the next try
+        _batch.resize(_batch.size() - 2);
+    }
+    return ok;
+}
+
+bool DwinStore::compact()
+{
+    std::vector<uint16_t> log;
+    for (auto it = _table.begin(); it != _table.end(); ++it)
+    {
+        addRecord(log, it->first, it->second.data(), it->second.size(), false);
+    }
+    log.insert(log.end(), {0x0000, 0x0000});
+    if (log.size() > _areaWords)
+    {
+        Serial.printf("DwinStore ERR compact() %u words do not fit the log area\n", (unsigned)log.size());
+        return false;
+    }
+    // The active log stays valid until the header points to the new one
+    const uint8_t area = _area ^ 1;
+    if (!writeLog(areaAddr(area), log.data(), log.size())) return false;
+    const uint16_t header[STORE_HEADER] = {RECORD_MARKER, area};
+    if (!writeLog(_norAddr, header, STORE_HEADER)) return false;
+    _area = area;
+    _logEnd = log.size() - 2;
+    _batch.clear();
+    return true;
+}
+
+size_t DwinStore::size()
+{
+    return _table.size();
+}
+
+uint32_t DwinStore::getLogWords()
+{
+    return _logEnd + _batch.size();
+}
@@ -0,0 +1,89 @@
+//***************************************************
+//* Settings store in the DWIN user NOR flash       *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Key-value store kept in the user NOR flash of the display, so frequent
+// settings saves do not wear the ESP32 flash. The flash is accessed through
+// the 0x0008 system variable and a VP buffer.
+// The store is a log: records are only appended, put() collects them in RAM
+// and commit() writes the batch with one large flash write. begin() reads
+// the log once and rebuilds the RAM lookup table.
+// The flash range holds a 2-word header and two log areas. When the active
+// area is full, it is compacted: live values are written to the other area,
+// then the header is switched to it with one write, so a power loss during
+// compaction leaves the old log in place.
+//
+// Header (words): 0x5AA5 marker, active area (0 or 1).
+// Record (words): 0x5AA5, key, count (bit 15 - removed), checksum, value...
+// padded to an even number of words. The log ends with two 0x0000 words.
+
+#ifndef DwinStore_h
+#define DwinStore_h
+
+#include <Dwin2.h>
+#include <map>
+
+// Batch size in words after which put() commits automatically
+#define STORE_AUTOCOMMIT_WORDS 1024
+
+
+//***********************************************************************************************************************
+//************* DWIN Store class ****************************************************************************************
+//***********************************************************************************************************************
+class DwinStore
+{
+private:
+    DWIN2 *_dwin;
+    // Flash range in the NOR flash, in words
+    uint32_t _norAddr;
+    uint32_t _norWords;
+    // Size of each log area and the active one
+    uint32_t _areaWords;
+    uint8_t _area;
+    // VP buffer for the flash transfers
+    uint16_t _vpBufAddr;
+    uint16_t _vpBufWords;
+
+    // RAM lookup table
+    std::map<uint16_t, std::vector<uint16_t>> _table;
+    // Records waiting for commit()
+    std::vector<uint16_t> _batch;
+    // Position of the log end marker, relative to the active area
+    uint32_t _logEnd;
+
+    // Read/write words between the NOR flash and the VP buffer through 0x0008
+    bool norAccess(const uint8_t &mode, const uint32_t &norAddr, const uint16_t &words);
+    // NOR address of the log area
+    uint32_t areaAddr(const uint8_t &area);
+    // Write words to the flash at norAddr
+    bool writeLog(const uint32_t &norAddr, const uint16_t *data, const size_t &count);
+    // Append the record to the batch
+    void addRecord(std::vector<uint16_t> &log, const uint16_t &key, const uint16_t *value, const uint16_t &count, const bool &removed);
+    // Parse records from data, returns the number of words parsed, sets end if the log end is found
+    size_t parseLog(const uint16_t *data, const size_t &count, bool &end);
+
+public:
+    DwinStore(DWIN2 &dwin, const uint32_t &norAddr = 0, const uint32_t &norWords = 0x20000, const uint16_t &vpBufAddr = 0xC000, const uint16_t &vpBufWords = 0x1000);
+
+    // Read the log and rebuild the lookup table
+    bool begin();
+    // Set value of the key, written by the next commit(). False if the value does not fit the VP buffer
+    bool put(const uint16_t &key, const uint16_t *value, const size_t &count);
+    bool putInt(const uint16_t &key, const int32_t &value);
+    // Get value of the key, returns number of words copied
+    size_t get(const uint16_t &key, uint16_t *value, const size_t &maxCount);
+    int32_t getInt(const uint16_t &key, const int32_t &defaultVal = 0);
+    bool contains(const uint16_t &key);
+    void remove(const uint16_t &key);
+    // Write the batch to the flash
+    bool commit();
+    // Write only the live values to the other log area and switch to it
+    bool compact();
+    // Number of keys and used log words
+    size_t size();
+    uint32_t getLogWords();
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include <DwinTimeline.h>
+
+//***********************************************************************************************************************
+//************* DWIN Timeline class *************************************************************************************
+//***********************************************************************************************************************
+DwinTimeline::DwinTimeline()
+{
+    _head = 0;
+    _enabled = true;
+    _trackCount = 0;
+#ifndef DWIN_NO_RTOS
+    _lock = xSemaphoreCreateMutex();
+#else
+    // One task in the poll() mode
+    strncpy(_names[0], "loop", TIMELINE_NAME_LEN);
+    _trackCount = 1;
+#endif
+}
+
+uint8_t DwinTimeline::track()
+{
+#ifndef DWIN_NO_RTOS
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < _trackCount; i++)
+    {
+        if (_tasks[i] == task) return i;
+    }
+    if (_trackCount >= TIMELINE_MAX_TRACKS) return TIMELINE_MAX_TRACKS - 1;
+    _tasks[_trackCount] = task;
+    strncpy(_names[_trackCount], pcTaskGetName(task), TIMELINE_NAME_LEN - 1);
+    _names[_trackCount][TIMELINE_NAME_LEN - 1] = 0;
+    return _trackCount++;
+#else
+    return 0;
+#endif
+}
+
+void DwinTimeline::span(const tltype_t &type, const uint8_t &serialNum, const uint32_t &startUs, const uint16_t &arg)
+{
+    if (!_enabled) return;
+    const uint32_t endUs = micros();
+    if (!dwinLock(_lock)) return;
+    tlevent_t &event = _ring[_head % TIMELINE_EVENTS];
+    event.startUs = startUs;
+    event.durUs = endUs - startUs;
+    event.arg = arg;
+    event.type = type;
+    event.track = track();
+    event.port = serialNum;
+    _head++;
+    dwinUnlock(_lock);
+}
+
+size_t DwinTimeline::writeJson(Print &out)
+{
+    const bool enabled = _enabled;
+    _enabled = false;
+    // The event being recorded is finished
+    if (dwinLock(_lock)) dwinUnlock(_lock);
+
+    const size_t count = size();
+    const uint32_t first = _head - count;
+    // Time of the earliest start, the events are in the order of their end
+    uint32_t baseUs = (count > 0) ? _ring[first % TIMELINE_EVENTS].startUs : 0;
+    uint8_t ports = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const tlevent_t &event = _ring[(first + i) % TIMELINE_EVENTS];
+        if (int32_t(event.startUs - baseUs) < 0) baseUs = event.startUs;
+        if (event.port < 8) ports |= 1 << event.port;
+    }
+
+    out.printf("{\"traceEvents\":[\n");
+    bool comma = false;
+    // Names of the ports and of the tasks on each port
+    for (uint8_t port = 0; port < 8; port++)
+    {
+        if (!(ports & (1 << port))) continue;
+        out.printf("%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"DWIN port %d\"}}",
+                   comma ? ",\n" : "", port, port);
+        comma = true;
+        for (uint8_t i = 0; i < _trackCount; i++)
+        {
+            out.printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                       port, i, _names[i]);
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const tlevent_t &event = _ring[(first + i) % TIMELINE_EVENTS];
+        out.printf("%s{\"name\":\"%s\",\"cat\":\"dwin\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":%d,\"tid\":%d,\"args\":{\"n\":%d}}",
+                   comma ? ",\n" : "", typeName(tltype_t(event.type)), (unsigned long)(event.startUs - baseUs),
+                   (unsigned long)event.durUs, event.port, event.track, event.arg);
+        comma = true;
+    }
+    out.printf("\n]}\n");
+    _enabled = enabled;
+    return count;
+}
+
+void DwinTimeline::setEnabled(const bool &enabled)
+{
+    _enabled = enabled;
+}
+
+void DwinTimeline::clear()
+{
+    if (dwinLock(_lock))
+    {
+        _head = 0;
+        dwinUnlock(_lock);
+    }
+}
+
+size_t DwinTimeline::size()
+{
+    return std::min<uint32_t>(_head, TIMELINE_EVENTS);
+}
+
+uint32_t DwinTimeline::getRecorded()
+{
+    return _head;
+}
+
+const char *DwinTimeline::typeName(const tltype_t &type)
+{
+    switch (type)
+    {
+        case TL_ENQUEUE: return "enqueue";
+        case TL_QUEUE: return "queue wait";
+        case TL_TX: return "tx";
+        case TL_PANEL: return "panel";
+        case TL_RX: return "rx";
+        case TL_FINISH: return "finish";
+        case TL_CALLBACK: return "callback";
+        case TL_BLINK: return "blink";
+        default: return "?";
+    }
+}
@@ -0,0 +1,103 @@
+//***************************************************
+//* Timeline of bus operations for DWIN2 library    *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Records how the operations of a display port overlap in time, per task:
+//  enqueue     a command copied into the bus queue, incl. the wait for the
+//              buffer mutex and for free space (producer task)
+//  queue wait  commands in the queue until the bus task takes them
+//  tx          a group of frames passed to the transport
+//  panel       from the group sent to its answers received or timed out:
+//              the time on the line and the display processing
+//  rx          answer bytes read and the frames counted
+//  finish      answers of the group parsed: async reads, readers, echo
+//  callback    echo callback or auto-upload handler
+//  blink       blink frame written by the blink timer
+// Each operation is one event with its start time and duration in a fixed
+// ring, the oldest events are overwritten. writeJson() exports the ring as
+// Chrome trace-event JSON, open it in chrome://tracing or ui.perfetto.dev:
+// one process per port, one thread per task (uartTask, loop, esp_timer...).
+//
+//   DwinTimeline timeline;
+//   dwc.setTimeline(&timeline);
+//   ...
+//   File file = LittleFS.open("/timeline.json", "w");
+//   timeline.writeJson(file);
+//
+// On the host build (DWIN_LINUX) write the JSON to a file directly.
+
+#ifndef DwinTimeline_h
+#define DwinTimeline_h
+
+#include <Dwin2.h>
+
+// Ring capacity, events of 16 bytes
+#ifndef TIMELINE_EVENTS
+#define TIMELINE_EVENTS 512
+#endif
+// Tasks named in the timeline, the next ones share the last track
+#define TIMELINE_MAX_TRACKS 8
+#define TIMELINE_NAME_LEN 16
+
+typedef enum {
+    TL_ENQUEUE,
+    TL_QUEUE,
+    TL_TX,
+    TL_PANEL,
+    TL_RX,
+    TL_FINISH,
+    TL_CALLBACK,
+    TL_BLINK,
+    TL_TYPES
+} tltype_t;
+
+typedef struct {
+    uint32_t startUs;
+    uint32_t durUs;
+    // Bytes or frames of the operation
+    uint16_t arg;
+    uint8_t type;
+    uint8_t track;
+    uint8_t port;
+} tlevent_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Timeline class *************************************************************************************
+//***********************************************************************************************************************
+class DwinTimeline
+{
+private:
+    tlevent_t _ring[TIMELINE_EVENTS];
+    // Free running number of the events recorded
+    uint32_t _head;
+    bool _enabled;
+#ifndef DWIN_NO_RTOS
+    TaskHandle_t _tasks[TIMELINE_MAX_TRACKS];
+#endif
+    char _names[TIMELINE_MAX_TRACKS][TIMELINE_NAME_LEN];
+    uint8_t _trackCount;
+    dwinlock_t _lock;
+
+    // Track of the calling task, added on its first event
+    uint8_t track();
+
+public:
+    DwinTimeline();
+
+    // Record the operation started at startUs and ending now, called by the bus
+    void span(const tltype_t &type, const uint8_t &serialNum, const uint32_t &startUs, const uint16_t &arg = 0);
+    // Write the events of the ring as Chrome trace-event JSON. Recording is paused meanwhile.
+    // Returns the number of events written
+    size_t writeJson(Print &out);
+    void setEnabled(const bool &enabled);
+    void clear();
+    // Events in the ring and recorded in total
+    size_t size();
+    uint32_t getRecorded();
+    static const char *typeName(const tltype_t &type);
+};
+
+#endif
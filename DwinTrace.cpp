@@ -0,0 +1,149 @@
+#include <DwinTrace.h>
+
+// Bytes copied out of the ring per write to the output
+#define TRACE_CHUNK 256
+
+//***********************************************************************************************************************
+//************* DWIN Trace class ****************************************************************************************
+//***********************************************************************************************************************
+DwinTrace::DwinTrace()
+{
+    _head = 0;
+    _tail = 0;
+    _lastUs = 0;
+    _headerDone = false;
+    _enabled = true;
+    _gapBytes = 0;
+    _lostBytes = 0;
+    _recordedBytes = 0;
+#ifndef DWIN_NO_RTOS
+    _lock = xSemaphoreCreateMutex();
+#endif
+}
+
+size_t DwinTrace::putVarint(uint8_t *buf, uint32_t value)
+{
+    size_t len = 0;
+    while (value >= 0x80)
+    {
+        buf[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buf[len++] = value;
+    return len;
+}
+
+void DwinTrace::put(const uint8_t *data, const size_t &len)
+{
+    const size_t pos = _head % TRACE_BUFSIZE;
+    const size_t first = std::min<size_t>(len, TRACE_BUFSIZE - pos);
+    memcpy(&_ring[pos], data, first);
+    memcpy(_ring, data + first, len - first);
+    _head += len;
+}
+
+void DwinTrace::record(const uint8_t &serialNum, const bool &rx, const uint8_t *data, const size_t &len)
+{
+    if (!_enabled || (len == 0)) return;
+    if (!dwinLock(_lock)) return;
+    const uint32_t nowUs = micros();
+    const uint8_t port = serialNum & TRACE_TAG_PORT;
+
+    // Gap record before the first bytes after a drop, the record itself follows with dt 0
+    uint8_t header[16];
+    size_t headerLen = 0;
+    uint32_t dt = nowUs - _lastUs;
+    if (_gapBytes > 0)
+    {
+        header[headerLen++] = TRACE_TAG_GAP | port;
+        headerLen += putVarint(&header[headerLen], dt);
+        headerLen += putVarint(&header[headerLen], _gapBytes);
+        dt = 0;
+    }
+    header[headerLen++] = (rx ? TRACE_TAG_RX : 0) | port;
+    headerLen += putVarint(&header[headerLen], dt);
+    headerLen += putVarint(&header[headerLen], len);
+
+    if (TRACE_BUFSIZE - (_head - _tail) < headerLen + len)
+    {
+        // No room, drain() is late
+        _gapBytes += len;
+        _lostBytes += len;
+    }
+    else
+    {
+        put(header, headerLen);
+        put(data, len);
+        _gapBytes = 0;
+        _lastUs = nowUs;
+        _recordedBytes += len;
+    }
+    dwinUnlock(_lock);
+}
+
+size_t DwinTrace::drain(Print &out, const size_t &maxBytes)
+{
+    size_t written = 0;
+    if (!_headerDone)
+    {
+        const uint8_t fileHeader[8] = {'D', 'W', 'T', 'R', TRACE_VERSION, 0, 0, 0};
+        if (out.write(fileHeader, sizeof(fileHeader)) != sizeof(fileHeader)) return 0;
+        _headerDone = true;
+        written += sizeof(fileHeader);
+    }
+
+    uint8_t chunk[TRACE_CHUNK];
+    while (written < maxBytes)
+    {
+        // Only drain() moves _tail, the bytes up to _head are not changed by record()
+        size_t head = _tail;
+        if (dwinLock(_lock))
+        {
+            head = _head;
+            dwinUnlock(_lock);
+        }
+        const size_t len = std::min<size_t>(std::min<size_t>(head - _tail, TRACE_CHUNK), maxBytes - written);
+        if (len == 0) break;
+        const size_t pos = _tail % TRACE_BUFSIZE;
+        const size_t first = std::min<size_t>(len, TRACE_BUFSIZE - pos);
+        memcpy(chunk, &_ring[pos], first);
+        memcpy(chunk + first, _ring, len - first);
+
+        const size_t sent = out.write(chunk, len);
+        if (dwinLock(_lock))
+        {
+            _tail += sent;
+            dwinUnlock(_lock);
+        }
+        written += sent;
+        // The output is full, the rest stays for the next call
+        if (sent < len) break;
+    }
+    return written;
+}
+
+void DwinTrace::setEnabled(const bool &enabled)
+{
+    _enabled = enabled;
+}
+
+size_t DwinTrace::available()
+{
+    size_t len = 0;
+    if (dwinLock(_lock))
+    {
+        len = _head - _tail;
+        dwinUnlock(_lock);
+    }
+    return len;
+}
+
+uint32_t DwinTrace::getLostBytes()
+{
+    return _lostBytes;
+}
+
+uint32_t DwinTrace::getRecordedBytes()
+{
+    return _recordedBytes;
+}
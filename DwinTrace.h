@@ -0,0 +1,81 @@
+//***************************************************
+//* UART trace capture for DWIN2 library            *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Records the bytes of a display port with their time: every group of frames
+// passed to the UART (TX) and every read of the display answers (RX).
+// The bus task only copies the bytes into a fixed ring, the loop calls
+// drain() to write them to a file (SD, LittleFS) or any other Print.
+// If the ring is full the bytes are dropped and a gap record is written,
+// the session goes on. Replay the file on the PC with tools/dwin_trace.py.
+//
+// File: "DWTR", version, 3 reserved bytes, then the records:
+//  tag      bit 7 - RX, bit 6 - gap, bits 0..2 - serial port
+//  dt       varint, us from the previous record
+//  length   varint, bytes of the record (gap: number of dropped bytes)
+//  data     length bytes, none in the gap record
+// Varint: 7 bits per byte, low bits first, bit 7 - more bytes follow.
+
+#ifndef DwinTrace_h
+#define DwinTrace_h
+
+#include <Dwin2.h>
+
+// Ring capacity, bytes
+#ifndef TRACE_BUFSIZE
+#define TRACE_BUFSIZE 8192
+#endif
+static_assert((TRACE_BUFSIZE & (TRACE_BUFSIZE - 1)) == 0, "TRACE_BUFSIZE must be a power of 2");
+#define TRACE_VERSION 1
+// Record tag bits
+#define TRACE_TAG_RX 0x80
+#define TRACE_TAG_GAP 0x40
+#define TRACE_TAG_PORT 0x07
+
+
+//***********************************************************************************************************************
+//************* DWIN Trace class ****************************************************************************************
+//***********************************************************************************************************************
+class DwinTrace
+{
+private:
+    uint8_t _ring[TRACE_BUFSIZE];
+    // Free running positions, written by record() and read by drain()
+    size_t _head;
+    size_t _tail;
+    uint32_t _lastUs;
+    bool _headerDone;
+    bool _enabled;
+    // Bytes dropped since the last gap record and in total
+    uint32_t _gapBytes;
+    uint32_t _lostBytes;
+    uint32_t _recordedBytes;
+    dwinlock_t _lock;
+
+    // Copy bytes into the ring at _head, the space is checked by the caller
+    void put(const uint8_t *data, const size_t &len);
+    // Varint of value into buf, returns the number of bytes
+    static size_t putVarint(uint8_t *buf, uint32_t value);
+
+public:
+    DwinTrace();
+
+    // Record the bytes of the port, called by the bus. Never blocks on the ring:
+    // what does not fit is dropped and counted
+    void record(const uint8_t &serialNum, const bool &rx, const uint8_t *data, const size_t &len);
+    // Write up to maxBytes of the recorded bytes to out (the file header first).
+    // Returns the number of bytes written, call it from the loop
+    size_t drain(Print &out, const size_t &maxBytes = TRACE_BUFSIZE);
+    // Pause/resume the recording, the ring is kept
+    void setEnabled(const bool &enabled);
+    // Bytes waiting for drain()
+    size_t available();
+    // Bytes dropped because the ring was full
+    uint32_t getLostBytes();
+    // Bytes of the port recorded
+    uint32_t getRecordedBytes();
+};
+
+#endif
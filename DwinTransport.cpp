@@ -0,0 +1,106 @@
+#include <Dwin2.h>
+
+#ifndef DWIN_LINUX
+//***********************************************************************************************************************
+//************* DWIN ESP32 UART transport *******************************************************************************
+//***********************************************************************************************************************
+DwinEspUart::DwinEspUart(const uint8_t &serialNum, const uint32_t &baud)
+{
+    _port = static_cast<uart_port_t>(serialNum);
+    _baud = baud;
+#ifndef DWIN_NO_RTOS
+    _eventQueue = nullptr;
+#endif
+}
+
+bool DwinEspUart::begin(const uint8_t &rxPin, const uint8_t &txPin)
+{
+    // UART driver initialization, RX is reported by the event queue
+    uart_config_t config = {};
+    config.baud_rate = _baud;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+#ifndef DWIN_NO_RTOS
+    QueueHandle_t *eventQueue = &_eventQueue;
+    const int events = DWIN_UART_EVENTS;
+#else
+    // Answers are read by poll()
+    QueueHandle_t *eventQueue = nullptr;
+    const int events = 0;
+#endif
+    if ((uart_driver_install(_port, DWIN_RXBUFSIZE, DWIN_TXBUFSIZE, events, eventQueue, 0) != ESP_OK) ||
+        (uart_param_config(_port, &config) != ESP_OK) ||
+        (uart_set_pin(_port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK))
+    {
+        return false;
+    }
+    // UART_DATA event after 2 byte times of silence, the end of the display answer
+    uart_set_rx_timeout(_port, 2);
+    return true;
+}
+
+size_t DwinEspUart::write(const uint8_t *data, const size_t &len)
+{
+    // The whole group goes to the TX ring of the driver at once
+    const int sent = uart_write_bytes(_port, data, len);
+    return sent > 0 ? sent : 0;
+}
+
+size_t DwinEspUart::available()
+{
+    size_t rxLen = 0;
+    uart_get_buffered_data_len(_port, &rxLen);
+    return rxLen;
+}
+
+size_t DwinEspUart::read(uint8_t *data, const size_t &len)
+{
+    const int rxLen = (len > 0) ? uart_read_bytes(_port, data, len, 0) : 0;
+    return rxLen > 0 ? rxLen : 0;
+}
+
+void DwinEspUart::flushInput()
+{
+    uart_flush_input(_port);
+}
+
+bool DwinEspUart::waitRx(const uint32_t &timeoutMs)
+{
+#ifndef DWIN_NO_RTOS
+    uart_event_t event;
+    const TickType_t ticks = (timeoutMs == DWIN_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    while (true)
+    {
+        if (xQueueReceive(_eventQueue, &event, ticks) != pdTRUE) return false;
+        if ((event.type == UART_FIFO_OVF) || (event.type == UART_BUFFER_FULL))
+        {
+            // Answers are lost
+            uart_flush_input(_port);
+            xQueueReset(_eventQueue);
+            return false;
+        }
+        // Received bytes or wakeRx(), a spurious wake makes the bus only check the queue and the input
+        if ((event.type == UART_DATA) || (event.type == UART_EVENT_MAX)) return true;
+    }
+#else
+    const uint32_t startMs = millis();
+    while (available() == 0)
+    {
+        if (millis() - startMs >= timeoutMs) return false;
+    }
+    return true;
+#endif
+}
+
+#ifndef DWIN_NO_RTOS
+void DwinEspUart::wakeRx()
+{
+    // The driver never posts this type, the queue is shared with the UART ISR
+    uart_event_t event = {};
+    event.type = UART_EVENT_MAX;
+    xQueueSend(_eventQueue, &event, 0);
+}
+#endif
+#endif
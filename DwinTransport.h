@@ -0,0 +1,103 @@
+//***************************************************
+//* Serial transport of the DWIN2 bus               *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// The bus of a display port passes bytes through a transport: the ESP32
+// UART driver by default, DwinLinuxSerial on a Linux gateway with a
+// USB-serial adapter, or any other implementation set by
+// DWIN2::setTransport() before the first begin() on the port.
+// Frames, groups, pipelining and answers are handled by the bus, the
+// transport only moves bytes. Calls come from the bus task (or poll())
+// under the UART mutex of the bus.
+
+#ifndef DwinTransport_h
+#define DwinTransport_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Port speed of the DGUS T5L displays
+#define DWIN_BAUDRATE 115200
+// waitRx() timeout: until the bytes are received or wakeRx() is called
+#define DWIN_WAIT_FOREVER 0xFFFFFFFF
+// Max delay of the queued commands while the bus task waits for the auto-upload frames
+// on a transport without wakeRx(), ms
+#define DWIN_UPLOAD_POLL_MS 1
+
+
+//***********************************************************************************************************************
+//************* DWIN Transport interface ********************************************************************************
+//***********************************************************************************************************************
+class DwinTransport
+{
+public:
+    virtual ~DwinTransport() {}
+
+    // Open the port. Pins are used by the ESP32 UART only. Returns false on error
+    virtual bool begin(const uint8_t &rxPin, const uint8_t &txPin) = 0;
+    // Pass the bytes to the TX, returns the number of bytes taken
+    virtual size_t write(const uint8_t *data, const size_t &len) = 0;
+    // Bytes received and not read yet
+    virtual size_t available() = 0;
+    // Read up to len received bytes, without waiting. Returns the number of bytes read
+    virtual size_t read(uint8_t *data, const size_t &len) = 0;
+    // Drop the received bytes
+    virtual void flushInput() = 0;
+    // Wait up to timeoutMs for received bytes. Returns false on timeout
+    // or if the received bytes were lost (RX overflow, the input is flushed)
+    virtual bool waitRx(const uint32_t &timeoutMs) = 0;
+    // Make a waitRx() of the bus task return true now, called by other tasks when
+    // commands are queued. Transports polled by the bus (DWIN_NO_RTOS) need not implement it
+    virtual void wakeRx() {}
+    // waitRx() timeout of the idle bus task waiting for the auto-upload frames:
+    // DWIN_WAIT_FOREVER if wakeRx() is implemented
+    virtual uint32_t idleWaitMs() { return DWIN_UPLOAD_POLL_MS; }
+    // Line speed, for the time the frames take on the wire
+    virtual uint32_t getBaud() { return DWIN_BAUDRATE; }
+};
+
+
+#ifndef DWIN_LINUX
+#include <Arduino.h>
+#ifndef DWIN_NO_RTOS
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#endif
+#include <driver/uart.h>
+
+//***********************************************************************************************************************
+//************* DWIN ESP32 UART transport *******************************************************************************
+//***********************************************************************************************************************
+// ESP-IDF UART driver: TX ring of DWIN_TXBUFSIZE bytes, RX reported by the event
+// queue (the RX timeout of 2 byte times marks the end of the display answer)
+class DwinEspUart : public DwinTransport
+{
+private:
+    uart_port_t _port;
+    uint32_t _baud;
+#ifndef DWIN_NO_RTOS
+    // UART driver event queue
+    QueueHandle_t _eventQueue;
+#endif
+
+public:
+    DwinEspUart(const uint8_t &serialNum, const uint32_t &baud = DWIN_BAUDRATE);
+
+    bool begin(const uint8_t &rxPin, const uint8_t &txPin) override;
+    size_t write(const uint8_t *data, const size_t &len) override;
+    size_t available() override;
+    size_t read(uint8_t *data, const size_t &len) override;
+    void flushInput() override;
+    bool waitRx(const uint32_t &timeoutMs) override;
+    uint32_t getBaud() override { return _baud; }
+#ifndef DWIN_NO_RTOS
+    // A wake event in the UART event queue
+    void wakeRx() override;
+    uint32_t idleWaitMs() override { return DWIN_WAIT_FOREVER; }
+#endif
+};
+#endif
+
+#endif
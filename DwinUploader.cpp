@@ -0,0 +1,181 @@
+#include <DwinUploader.h>
+#include <DwinKernels.h>
+
+// System variable for writing the VP buffer into a 32KB flash block
+#define FLASH_WRITE_VP 0x00AA
+// Max time of writing one flash block
+#define FLASH_WRITE_TIMEOUT_MS 2000
+
+//***********************************************************************************************************************
+//************* DWIN Uploader class *************************************************************************************
+//***********************************************************************************************************************
+DwinUploader::DwinUploader(DWIN2 &dwin, const uint16_t &vpBufAddr)
+{
+    _dwin = &dwin;
+    _vpBufAddr = vpBufAddr;
+    _window = 8;
+    _maxRetries = 3;
+    _verify = false;
+    memset(&_stat, 0, sizeof(_stat));
+}
+
+void DwinUploader::setWindow(const uint8_t &chunks)
+{
+    _window = chunks > 0 ? chunks : 1;
+}
+
+void DwinUploader::setRetries(const uint8_t &retries)
+{
+    _maxRetries = retries;
+}
+
+void DwinUploader::setVerify(const bool &verify)
+{
+    _verify = verify;
+}
+
+void DwinUploader::setProgressHandler(ProgressFunction f)
+{
+    _progress_cb = f;
+}
+
+uiuploadstat_t DwinUploader::getStat()
+{
+    return _stat;
+}
+
+uint8_t DwinUploader::fileIdFromName(const String &name)
+{
+    // File ID is the number at the beginning of the name
+    return static_cast<uint8_t>(atoi(name.c_str()));
+}
+
+bool DwinUploader::upload(const uint8_t &fileId, ReadFunction read, const uint32_t &fileSize, const uint32_t &startOffset)
+{
+    const uint32_t startMs = millis();
+    // Continue from the beginning of the block, which was not written
+    uint32_t offset = startOffset - startOffset % UPLOAD_BLOCK_SIZE;
+    _stat.bytes = 0;
+    _stat.retries = 0;
+    _stat.resumeOffset = offset;
+#ifndef DWIN_NO_HEAP
+    // The VP buffer is not replayed after a display reset
+    _dwin->excludeShadowRange(_vpBufAddr, UPLOAD_BLOCK_SIZE/2);
+#endif
+
+    while (offset < fileSize)
+    {
+        const uint16_t blockNum = fileId*UPLOAD_BLOCKS_PER_ID + offset/UPLOAD_BLOCK_SIZE;
+        if (!loadBlock(read, offset, fileSize) || !writeFlashBlock(blockNum))
+        {
+            Serial.printf("DwinUploader ERR upload() file %d failed at offset %lu\n", fileId, (unsigned long)offset);
+            _stat.elapsedMs = millis() - startMs;
+            return false;
+        }
+        const uint32_t blockBytes = std::min<uint32_t>(UPLOAD_BLOCK_SIZE, fileSize - offset);
+        offset += blockBytes;
+        _stat.bytes += blockBytes;
+        _stat.resumeOffset = offset;
+        _stat.elapsedMs = millis() - startMs;
+        _stat.bytesPerSec = _stat.elapsedMs > 0 ? (uint64_t)_stat.bytes*1000/_stat.elapsedMs : 0;
+        if (_progress_cb != NULL) _progress_cb(_stat, fileSize);
+    }
+    return true;
+}
+
+bool DwinUploader::loadBlock(ReadFunction &read, const uint32_t &offset, const uint32_t &fileSize)
+{
+    const size_t chunkBytes = DWIN_MAX_BLOCK_WORDS*2;
+    std::vector<uint8_t> data(chunkBytes*_window);
+    std::vector<uint8_t> frames;
+    frames.reserve((chunkBytes + 6)*_window);
+    // Chunks of the window not written yet
+    std::vector<bool> pending(_window);
+
+    uint32_t pos = 0;
+    while (pos < UPLOAD_BLOCK_SIZE)
+    {
+        const size_t winLen = std::min<size_t>(chunkBytes*_window, UPLOAD_BLOCK_SIZE - pos);
+        // File data, the rest of the last block is filled with 0xFF
+        size_t fileLen = 0;
+        size_t got = 0;
+        if (offset + pos < fileSize)
+        {
+            fileLen = std::min<size_t>(winLen, fileSize - offset - pos);
+            got = read(offset + pos, data.data(), fileLen);
+        }
+        // A short read would burn a truncated asset
+        if (got < fileLen)
+        {
+            Serial.printf("DwinUploader ERR loadBlock() read %u of %u bytes at offset %lu\n", (unsigned)got,
+                          (unsigned)fileLen, (unsigned long)(offset + pos));
+            return false;
+        }
+        memset(data.data() + got, 0xFF, winLen - got);
+
+        const size_t chunks = (winLen + chunkBytes - 1)/chunkBytes;
+        std::fill(pending.begin(), pending.end(), true);
+        size_t left = chunks;
+        for (uint8_t attempt = 0; (attempt <= _maxRetries) && (left > 0); attempt++)
+        {
+            if (attempt > 0) _stat.retries += left;
+            // File bytes are already in the big endian order of VP words
+            frames.clear();
+            for (size_t c = 0; c < chunks; c++)
+            {
+                if (!pending[c]) continue;
+                const size_t i = c*chunkBytes;
+                const size_t len = std::min(chunkBytes, winLen - i);
+                const uint16_t vp = _vpBufAddr + (pos + i)/2;
+                frames.insert(frames.end(), {0x5A, 0xA5, static_cast<uint8_t>(len + 3), 0x82, highByte(vp), lowByte(vp)});
+                frames.insert(frames.end(), data.begin() + i, data.begin() + i + len);
+            }
+            _dwin->sendRawCommand(frames.data(), frames.size());
+            // All chunks of the window are acked
+            if (_dwin->flush() && !_verify)
+            {
+                left = 0;
+                break;
+            }
+            // An ack is lost or verification is on: the chunks read back the same are done
+            for (size_t c = 0; c < chunks; c++)
+            {
+                if (!pending[c]) continue;
+                const size_t i = c*chunkBytes;
+                if (!verifyChunk(_vpBufAddr + (pos + i)/2, data.data() + i, std::min(chunkBytes, winLen - i))) continue;
+                pending[c] = false;
+                left--;
+            }
+        }
+        if (left > 0) return false;
+        pos += winLen;
+    }
+    return true;
+}
+
+bool DwinUploader::verifyChunk(const uint16_t &vp, const uint8_t *data, const size_t &len)
+{
+    uint16_t words[DWIN_MAX_BLOCK_WORDS];
+    uint16_t expected[DWIN_MAX_BLOCK_WORDS];
+    const size_t count = len/2;
+    if (_dwin->readBlock(vp, words, count) != count) return false;
+    dwinBeToHost16(expected, data, count);
+    return memcmp(words, expected, count*2) == 0;
+}
+
+bool DwinUploader::writeFlashBlock(const uint16_t &blockNum)
+{
+    // 0x5A start, 0x02 write 32KB block, block number, VP buffer address, no delay
+    const uint16_t command[4] = {0x5A02, blockNum, _vpBufAddr, 0x0000};
+    _dwin->writeBlock(FLASH_WRITE_VP, command, 4);
+
+    // The display clears 0x5A when the block is written
+    const uint32_t startMs = millis();
+    while (millis() - startMs < FLASH_WRITE_TIMEOUT_MS)
+    {
+        uint16_t state = 0x5A00;
+        if ((_dwin->readBlock(FLASH_WRITE_VP, &state, 1) == 1) && (highByte(state) != 0x5A)) return true;
+        _dwin->wait(10);
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+//***************************************************
+//* Asset upload to DWIN display flash over UART    *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Uploads DWIN_SET files (icons, fonts, configs) into the display flash
+// without SD card. Each 32KB flash block is loaded into a VP buffer with
+// max-size write frames, a window of frames is sent before the acks are
+// checked. If an ack of the window is lost, each chunk is read back and
+// only the chunks that differ are sent again. Then the block is written
+// to flash through the 0x00AA system variable. A short file read fails
+// the block.
+// Resume granularity is one 32KB block: if upload() fails, call it again
+// with getStat().resumeOffset to continue the file.
+
+#ifndef DwinUploader_h
+#define DwinUploader_h
+
+#include <Dwin2.h>
+
+// Flash block written by one 0x00AA command
+#define UPLOAD_BLOCK_SIZE 32768
+// Flash blocks per file ID (256KB)
+#define UPLOAD_BLOCKS_PER_ID 8
+
+typedef struct {
+    uint32_t bytes;         // File bytes written
+    uint32_t elapsedMs;     // Upload time
+    uint32_t bytesPerSec;   // Throughput
+    uint16_t retries;       // Chunks sent again
+    uint32_t resumeOffset;  // File offset to continue from
+} uiuploadstat_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Uploader class *************************************************************************************
+//***********************************************************************************************************************
+class DwinUploader
+{
+public:
+    // Read len bytes of the file from offset into buf, returns number of bytes read
+    typedef std::function<size_t(const uint32_t &offset, uint8_t *buf, const size_t &len)> ReadFunction;
+    typedef std::function<void(const uiuploadstat_t &stat, const uint32_t &fileSize)> ProgressFunction;
+
+private:
+    DWIN2 *_dwin;
+    // VP buffer for one flash block, 16K words
+    uint16_t _vpBufAddr;
+    // Chunks sent before the acks are checked
+    uint8_t _window;
+    uint8_t _maxRetries;
+    // Read back and compare each chunk, also when the window is acked
+    bool _verify;
+    ProgressFunction _progress_cb = NULL;
+    uiuploadstat_t _stat;
+
+    // Load one block of the file into the VP buffer
+    bool loadBlock(ReadFunction &read, const uint32_t &offset, const uint32_t &fileSize);
+    // Read the chunk back from the VP buffer and compare it with the data
+    bool verifyChunk(const uint16_t &vp, const uint8_t *data, const size_t &len);
+    // Write the VP buffer into the flash block and wait for the end of writing
+    bool writeFlashBlock(const uint16_t &blockNum);
+
+public:
+    DwinUploader(DWIN2 &dwin, const uint16_t &vpBufAddr = 0x8000);
+
+    // Set number of chunks in flight, max retries of a chunk and read back verification
+    void setWindow(const uint8_t &chunks);
+    void setRetries(const uint8_t &retries);
+    void setVerify(const bool &verify);
+    // Callback called after each flash block
+    void setProgressHandler(ProgressFunction f);
+    // Upload the file to the flash area of fileId, starting from the block of startOffset
+    bool upload(const uint8_t &fileId, ReadFunction read, const uint32_t &fileSize, const uint32_t &startOffset = 0);
+    // Statistics of the last upload
+    uiuploadstat_t getStat();
+    // File ID from the DWIN_SET file name, "32.icl" -> 32, "0_DWIN_ASC.HZK" -> 0
+    static uint8_t fileIdFromName(const String &name);
+};
+
+#endif
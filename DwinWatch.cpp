@@ -0,0 +1,261 @@
+#include <DwinWatch.h>
+
+// Bytes on the line of one range read: 7 bytes command, 7 bytes answer header and the words
+#define WATCH_FRAME_COST 14
+
+//***********************************************************************************************************************
+//************* DWIN Watch class ****************************************************************************************
+//***********************************************************************************************************************
+DwinWatch::DwinWatch(DWIN2 &dwin)
+{
+    _dwin = &dwin;
+    _subCount = 0;
+    _snapshotUsed = 0;
+    for (size_t i = 0; i < WATCH_MAX_READS; i++) _reads[i].busy = false;
+    _cursor = 0;
+    _refillMs = millis();
+    setBudget(WATCH_BUDGET_BPS);
+    resetStat();
+}
+
+DwinWatch::~DwinWatch()
+{
+    for (size_t i = 0; i < WATCH_MAX_READS; i++)
+    {
+        if (_reads[i].busy) _dwin->endRead(_reads[i].read);
+    }
+}
+
+bool DwinWatch::subscribe(const uint16_t &vpHexAddr, const uint8_t &words, const uint32_t &periodMs, WatchFunction cb)
+{
+    if ((words == 0) || (words > DWIN_MAX_BLOCK_WORDS))
+    {
+        Serial.printf("DwinWatch: VP 0x%04X, %d words, 1..%d words can be read\n", vpHexAddr, words, DWIN_MAX_BLOCK_WORDS);
+        return false;
+    }
+    if ((_subCount >= WATCH_MAX_SUBS) || (_snapshotUsed + words > WATCH_SNAPSHOT_WORDS))
+    {
+        Serial.printf("DwinWatch: VP 0x%04X not subscribed, max %d subscriptions of %d words\n", vpHexAddr, WATCH_MAX_SUBS, WATCH_SNAPSHOT_WORDS);
+        return false;
+    }
+    // Keep the subscriptions sorted by VP, the adjacent ones are joined into one read
+    uint8_t pos = _subCount;
+    while ((pos > 0) && (_subs[pos-1].vp > vpHexAddr))
+    {
+        _subs[pos] = _subs[pos-1];
+        pos--;
+    }
+    watchsub_t &sub = _subs[pos];
+    sub.vp = vpHexAddr;
+    sub.words = words;
+    sub.periodMs = periodMs;
+    sub.dueMs = millis();
+    sub.snapshot = _snapshotUsed;
+    sub.valid = false;
+    sub.reading = false;
+    sub.cb = cb;
+    _snapshotUsed += words;
+    _subCount++;
+    return true;
+}
+
+void DwinWatch::unsubscribe(const uint16_t &vpHexAddr)
+{
+    uint8_t i = 0;
+    while (i < _subCount)
+    {
+        if (_subs[i].vp != vpHexAddr)
+        {
+            i++;
+            continue;
+        }
+        // Free the snapshot words
+        const uint16_t offset = _subs[i].snapshot;
+        const uint8_t words = _subs[i].words;
+        memmove(&_snapshot[offset], &_snapshot[offset + words], (_snapshotUsed - offset - words)*sizeof(uint16_t));
+        _snapshotUsed -= words;
+        for (uint8_t j = 0; j < _subCount; j++)
+        {
+            if (_subs[j].snapshot > offset) _subs[j].snapshot -= words;
+        }
+        for (uint8_t j = i; j + 1 < _subCount; j++) _subs[j] = _subs[j+1];
+        _subCount--;
+    }
+    if (_cursor >= _subCount) _cursor = 0;
+}
+
+void DwinWatch::setBudget(const uint32_t &bytesPerSec)
+{
+    _budgetBps = bytesPerSec;
+    // Start with the full burst
+    _tokens = maxTokens();
+}
+
+uint32_t DwinWatch::rangeCost(const uint16_t &words)
+{
+    return WATCH_FRAME_COST + words*2;
+}
+
+uint32_t DwinWatch::maxTokens()
+{
+    // The largest read always fits, even into a small budget
+    const uint32_t burst = _budgetBps*WATCH_BURST_MS;
+    const uint32_t largest = rangeCost(DWIN_MAX_BLOCK_WORDS)*1000;
+    return burst > largest ? burst : largest;
+}
+
+void DwinWatch::refill(const uint32_t &nowMs)
+{
+    // Budget is counted in 1/1000 bytes, so frequent service() calls lose nothing
+    uint32_t elapsedMs = nowMs - _refillMs;
+    _refillMs = nowMs;
+    if (elapsedMs > WATCH_BURST_MS) elapsedMs = WATCH_BURST_MS;
+    _tokens += elapsedMs*_budgetBps;
+    if (_tokens > maxTokens()) _tokens = maxTokens();
+}
+
+size_t DwinWatch::service()
+{
+    const uint32_t changes = _stat.changes;
+    takeReads();
+
+    const uint32_t nowMs = millis();
+    refill(nowMs);
+    const uint8_t cursor = _cursor;
+    uint8_t k = 0;
+    while (k < _subCount)
+    {
+        const uint8_t first = (cursor + k) % _subCount;
+        const watchsub_t &sub = _subs[first];
+        if (sub.reading || (int32_t(nowMs - sub.dueMs) < 0))
+        {
+            k++;
+            continue;
+        }
+        // Join the next due subscriptions while the gap is small and the range fits one frame
+        uint16_t start = sub.vp;
+        uint32_t end = uint32_t(sub.vp) + sub.words;
+        uint8_t last = first;
+        for (uint8_t j = first + 1; j < _subCount; j++)
+        {
+            const watchsub_t &next = _subs[j];
+            if (next.reading || (next.vp > end + WATCH_MAX_GAP)) break;
+            if (int32_t(nowMs - next.dueMs) < 0) continue;
+            const uint32_t nextEnd = uint32_t(next.vp) + next.words;
+            const uint32_t newEnd = nextEnd > end ? nextEnd : end;
+            if (newEnd - start > DWIN_MAX_BLOCK_WORDS) break;
+            end = newEnd;
+            last = j;
+        }
+        const uint16_t words = end - start;
+        if (_tokens < rangeCost(words)*1000)
+        {
+            // Over the budget, this range is the first one next time
+            _stat.overBudget++;
+            _cursor = first;
+            break;
+        }
+        if (!queueRange(first, last, nowMs)) break;
+        _tokens -= rangeCost(words)*1000;
+        k += last - first + 1;
+        _cursor = (last + 1) % _subCount;
+    }
+    return _stat.changes - changes;
+}
+
+bool DwinWatch::queueRange(const uint8_t &first, const uint8_t &last, const uint32_t &nowMs)
+{
+    watchread_t *slot = nullptr;
+    for (size_t i = 0; i < WATCH_MAX_READS; i++)
+    {
+        if (!_reads[i].busy)
+        {
+            slot = &_reads[i];
+            break;
+        }
+    }
+    if (slot == nullptr) return false;
+
+    uint32_t end = 0;
+    for (uint8_t i = first; i <= last; i++)
+    {
+        const uint32_t subEnd = uint32_t(_subs[i].vp) + _subs[i].words;
+        if (subEnd > end) end = subEnd;
+    }
+    slot->read.vp = _subs[first].vp;
+    slot->read.count = end - _subs[first].vp;
+    slot->read.data = slot->data;
+    if (!_dwin->readAsync(slot->read)) return false;
+    slot->busy = true;
+    slot->startMs = nowMs;
+    _stat.reads++;
+    _stat.bytes += rangeCost(slot->read.count);
+
+    // Every subscription inside the range is read, due or not
+    for (uint8_t i = 0; i < _subCount; i++)
+    {
+        watchsub_t &sub = _subs[i];
+        if ((sub.vp < slot->read.vp) || (uint32_t(sub.vp) + sub.words > end)) continue;
+        sub.reading = true;
+        sub.dueMs = nowMs + sub.periodMs;
+    }
+    return true;
+}
+
+void DwinWatch::takeReads()
+{
+    for (size_t i = 0; i < WATCH_MAX_READS; i++)
+    {
+        watchread_t &slot = _reads[i];
+        if (!slot.busy) continue;
+        dwinreadstate_t state = slot.read.state;
+        if (state == DWIN_READ_PENDING)
+        {
+            if (millis() - slot.startMs < WATCH_TIMEOUT_MS) continue;
+            state = _dwin->endRead(slot.read);
+        }
+        slot.busy = false;
+        if (state != DWIN_READ_DONE) _stat.lostReads++;
+        applyRange(slot.read.vp, slot.data, slot.read.count, state == DWIN_READ_DONE);
+    }
+}
+
+void DwinWatch::applyRange(const uint16_t &vp, const uint16_t *data, const uint8_t &words, const bool &ok)
+{
+    const uint32_t end = uint32_t(vp) + words;
+    for (uint8_t i = 0; i < _subCount; i++)
+    {
+        watchsub_t &sub = _subs[i];
+        if ((sub.vp < vp) || (uint32_t(sub.vp) + sub.words > end)) continue;
+        sub.reading = false;
+        // Lost read: polled again in the next period
+        if (!ok) continue;
+        _stat.updates++;
+        const uint16_t *value = &data[sub.vp - vp];
+        uint16_t *snapshot = &_snapshot[sub.snapshot];
+        if (sub.valid && (memcmp(snapshot, value, sub.words*sizeof(uint16_t)) == 0)) continue;
+        memcpy(snapshot, value, sub.words*sizeof(uint16_t));
+        sub.valid = true;
+        _stat.changes++;
+        if (sub.cb != NULL) sub.cb(sub.vp, snapshot, sub.words);
+    }
+}
+
+const uint16_t *DwinWatch::getValue(const uint16_t &vpHexAddr)
+{
+    for (uint8_t i = 0; i < _subCount; i++)
+    {
+        if ((_subs[i].vp == vpHexAddr) && _subs[i].valid) return &_snapshot[_subs[i].snapshot];
+    }
+    return nullptr;
+}
+
+watchstat_t DwinWatch::getStat()
+{
+    return _stat;
+}
+
+void DwinWatch::resetStat()
+{
+    memset(&_stat, 0, sizeof(_stat));
+}
@@ -0,0 +1,140 @@
+//***************************************************
+//* VP subscriptions for DWIN2 library              *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// Values changed by the display itself (DGUS counters, RTC, entries without
+// auto-upload) are polled by subscriptions instead of getUiData() calls:
+//
+//   DwinWatch watch(dwc);
+//   watch.subscribe(0x0010, 4, 1000, onRtc);    // RTC, once per second
+//   watch.subscribe(0x1000, 1, 200, onCounter);
+//   void loop() { watch.service(); }
+//
+// service() merges the due subscriptions of adjacent VPs into range reads
+// (gaps up to WATCH_MAX_GAP words are read as well, cheaper than another
+// frame), compares each result with the last snapshot and calls the
+// callback of the subscription only if its words changed. The first read
+// of a subscription is reported as a change. Subscriptions inside a range
+// read are refreshed by it even if not due yet.
+// Polling load is capped by the budget in bytes per second, counted on the
+// line for both the read command and its answer. Reads over the budget wait
+// for the next service() calls, the subscriptions are then polled slower
+// than their period. Reads are queued by DWIN2::readAsync(), service() does
+// not block. In the DWIN_NO_RTOS build call poll() of the display as well.
+
+#ifndef DwinWatch_h
+#define DwinWatch_h
+
+#include <Dwin2.h>
+
+// Max number of subscriptions and their total words
+#define WATCH_MAX_SUBS 16
+#define WATCH_SNAPSHOT_WORDS 256
+// Range reads in flight
+#define WATCH_MAX_READS 4
+// Max gap between the subscriptions joined into one read, words.
+// A read frame costs 14 bytes on the line (command and answer header), a gap word 2 bytes
+#define WATCH_MAX_GAP 6
+// Default polling budget, bytes per second: 10% of 115200 baud
+#define WATCH_BUDGET_BPS 1150
+// Budget saved while idle, ms of the budget
+#define WATCH_BURST_MS 100
+// Answer timeout of the range reads, ms
+#define WATCH_TIMEOUT_MS 100
+
+typedef struct {
+    // Range reads sent and left without answer
+    uint32_t reads;
+    uint32_t lostReads;
+    // Subscriptions read and the callbacks called
+    uint32_t updates;
+    uint32_t changes;
+    // Bytes of the polling on the line
+    uint32_t bytes;
+    // service() calls with due subscriptions left over the budget
+    uint32_t overBudget;
+} watchstat_t;
+
+
+//***********************************************************************************************************************
+//************* DWIN Watch class ****************************************************************************************
+//***********************************************************************************************************************
+class DwinWatch
+{
+public:
+#ifndef DWIN_NO_HEAP
+    typedef std::function<void(const uint16_t &vpHexAddr, const uint16_t *data, const uint8_t &words)> WatchFunction;
+#else
+    typedef void (*WatchFunction)(const uint16_t &vpHexAddr, const uint16_t *data, const uint8_t &words);
+#endif
+
+private:
+    typedef struct {
+        uint16_t vp;
+        uint8_t words;
+        uint32_t periodMs;
+        uint32_t dueMs;
+        // Offset of the last value in _snapshot
+        uint16_t snapshot;
+        bool valid;
+        // Read by a range read in flight
+        bool reading;
+        WatchFunction cb;
+    } watchsub_t;
+
+    typedef struct {
+        dwinread_t read;
+        uint16_t data[DWIN_MAX_BLOCK_WORDS];
+        uint32_t startMs;
+        bool busy;
+    } watchread_t;
+
+    DWIN2 *_dwin;
+    // Sorted by VP
+    watchsub_t _subs[WATCH_MAX_SUBS];
+    uint8_t _subCount;
+    uint16_t _snapshot[WATCH_SNAPSHOT_WORDS];
+    uint16_t _snapshotUsed;
+    watchread_t _reads[WATCH_MAX_READS];
+    // Budget left, 1/1000 bytes
+    uint32_t _budgetBps;
+    uint32_t _tokens;
+    uint32_t _refillMs;
+    // First subscription checked by the next service(), rotated so all get their turn over the budget
+    uint8_t _cursor;
+    watchstat_t _stat;
+
+    // Take the answers of the finished range reads
+    void takeReads();
+    // Compare the range with the snapshots of the subscriptions inside it
+    void applyRange(const uint16_t &vp, const uint16_t *data, const uint8_t &words, const bool &ok);
+    // Queue the range read of the subscriptions first..last, false if there is no free read slot
+    bool queueRange(const uint8_t &first, const uint8_t &last, const uint32_t &nowMs);
+    void refill(const uint32_t &nowMs);
+    uint32_t maxTokens();
+    static uint32_t rangeCost(const uint16_t &words);
+
+public:
+    DwinWatch(DWIN2 &dwin);
+    // Pending reads are stopped, the bus does not write into the object any more
+    ~DwinWatch();
+
+    // Poll words (1..DWIN_MAX_BLOCK_WORDS) from vpHexAddr once per periodMs, cb is called on change.
+    // Do not subscribe or unsubscribe from the callback. Returns false if the subscriptions or the snapshot words are used up
+    bool subscribe(const uint16_t &vpHexAddr, const uint8_t &words, const uint32_t &periodMs, WatchFunction cb);
+    // Remove the subscriptions of vpHexAddr
+    void unsubscribe(const uint16_t &vpHexAddr);
+    // Polling budget, bytes per second on the line (command and answer)
+    void setBudget(const uint32_t &bytesPerSec);
+    // Read the due subscriptions and call the callbacks of the changed ones, call often from the loop.
+    // Returns the number of changes reported
+    size_t service();
+    // Last value of the subscription of vpHexAddr, nullptr if not read yet
+    const uint16_t *getValue(const uint16_t &vpHexAddr);
+    watchstat_t getStat();
+    void resetStat();
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinPage.h>
+
+//*****************************************************************//
+// Boot-time init of many elements on several pages              **//
+// The visible page is sent first, the others in the background  **//
+// Time from power-on to the first screen is printed             **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+#define PAGES_QTY 3
+#define ELEMENTS_PER_PAGE 20
+
+static const char *const modes[] = {"Off", "Auto", "Manual"};
+
+DWIN2 dwc;
+DwinPage *pages[PAGES_QTY];
+DWIN2 elements[PAGES_QTY*ELEMENTS_PER_PAGE];
+
+void setup() {
+    Serial.begin(115200);
+    Serial.printf("-------- Start DWIN boot init demo --------\n");
+
+    dwc.begin(0, 0, RX_PIN, TX_PIN);
+    for (int p = 0; p < PAGES_QTY; p++) pages[p] = new DwinPage(dwc, p);
+
+    // No delay for the display boot: nothing is sent until endInit()
+    DwinPage::beginInit();
+    for (int i = 0; i < PAGES_QTY*ELEMENTS_PER_PAGE; i++)
+    {
+        DWIN2 &elem = elements[i];
+        // Elements of a page at adjacent VPs, so their values join into few frames
+        elem.begin(0x5000 + i*0x10, 0x1000 + i, RX_PIN, TX_PIN);
+        pages[i/ELEMENTS_PER_PAGE]->addElement(elem);
+        if (i % 4 == 3)
+        {
+            elem.setUiType(ASCII);
+            elem.setStrListVal(modes, 3);
+            elem.setLimits();
+            elem.setStartVal(1);
+        }
+        else
+        {
+            elem.setUiType(INT);
+            elem.setLimits(0, 100);
+            elem.setColor(i % 2 ? SKY_BLUE : ORANGE);
+            elem.setStartVal(i % 100);
+        }
+    }
+    DwinPage::endInit(0);
+    Serial.printf("First screen: %lu ms after power-on\n", (unsigned long)DwinPage::getFirstScreenMs());
+}
+
+
+void loop() {
+    // The other pages, only when the port is idle
+    static bool bulkDone = false;
+    if (!bulkDone && !DwinPage::serviceBulk())
+    {
+        bulkDone = true;
+        Serial.printf("All pages sent: %lu ms after power-on\n", millis());
+    }
+    delay(1);
+}
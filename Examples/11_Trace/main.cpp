@@ -0,0 +1,68 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Dwin2.h>
+#include <DwinTrace.h>
+
+//*****************************************************************//
+// UART trace of a session into /trace.bin of LittleFS.          **//
+// Send 'd' to stop the recording and print the file size, copy  **//
+// the file to the PC and run tools/dwin_trace.py replay on it   **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+#define TRACE_FILE "/trace.bin"
+
+DWIN2 dwc;
+DwinTrace trace;
+File traceFile;
+uint32_t lastSendMs = 0;
+uint32_t lastReadMs = 0;
+int counter = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN trace demo --------\n");
+
+    if (!LittleFS.begin(true))
+    {
+        Serial.printf("LittleFS mount failed\n");
+        return;
+    }
+    traceFile = LittleFS.open(TRACE_FILE, "w");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    // Record from the first command
+    dwc.setTrace(&trace);
+    dwc.setUiType(INT);
+    dwc.setPage(1);
+}
+
+
+void loop() {
+    if (millis() - lastSendMs >= 100)
+    {
+        lastSendMs = millis();
+        dwc.sendData(++counter);
+    }
+    if (millis() - lastReadMs >= 1000)
+    {
+        lastReadMs = millis();
+        Serial.printf("page %d\n", dwc.getPage());
+    }
+
+    // Flash writes are slow, the ring keeps the bytes meanwhile
+    if (traceFile) trace.drain(traceFile);
+
+    if (Serial.read() == 'd')
+    {
+        dwc.setTrace(nullptr);
+        trace.drain(traceFile);
+        Serial.printf("%s: %u bytes, %lu port bytes recorded, %lu dropped\n", TRACE_FILE, (unsigned)traceFile.size(),
+                      (unsigned long)trace.getRecordedBytes(), (unsigned long)trace.getLostBytes());
+        traceFile.close();
+    }
+    delay(1);
+}
@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinLinuxSerial.h>
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+
+//*****************************************************************//
+// Linux gateway build, runs on the PC without a display:        **//
+// DWIN2 on the slave side of a pseudo-terminal pair, a          **//
+// simulated panel (VP memory, acks, reads, page) on the master. **//
+// Replace the pair with DwinLinuxSerial serial("/dev/ttyUSB0")  **//
+// for a real display.                                           **//
+//                                                               **//
+// Built and run on the PC by tests/Makefile with the host       **//
+// Arduino layer of tests/host (String, Serial, millis()):       **//
+//   make -C tests test                                          **//
+//*****************************************************************//
+
+#define BLOCK_WORDS 2000
+#define ROUNDS 20
+
+static std::atomic<bool> panelRun(true);
+static uint16_t panelMem[0x10000];
+
+// Simulated display: answers the frames written to the master side
+static void panelTask(int fd)
+{
+    uint8_t buf[4096];
+    size_t len = 0;
+    while (panelRun)
+    {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        const ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+        if (n <= 0) continue;
+        len += n;
+
+        uint8_t answer[4096];
+        size_t answerLen = 0;
+        size_t pos = 0;
+        while (pos + 3 <= len)
+        {
+            if ((buf[pos] != 0x5A) || (buf[pos+1] != 0xA5)) { pos++; continue; }
+            const size_t frameLen = buf[pos+2] + 3;
+            if (pos + frameLen > len) break;
+            const uint8_t *frame = &buf[pos];
+            const uint16_t vp = (frame[4] << 8) | frame[5];
+            if (frame[3] == 0x82)
+            {
+                for (size_t i = 6; i + 1 < frameLen; i += 2) panelMem[vp + (i - 6)/2] = (frame[i] << 8) | frame[i+1];
+                // Page switch is reported by the page register
+                if ((vp == 0x0084) && (panelMem[0x0084] == 0x5A01)) panelMem[0x0014] = panelMem[0x0085];
+                const uint8_t ack[] = {0x5A, 0xA5, 0x03, 0x82, 0x4F, 0x4B};
+                memcpy(&answer[answerLen], ack, sizeof(ack));
+                answerLen += sizeof(ack);
+            }
+            else if (frame[3] == 0x83)
+            {
+                const uint8_t words = frame[6];
+                const uint8_t header[] = {0x5A, 0xA5, uint8_t(4 + words*2), 0x83, frame[4], frame[5], words};
+                memcpy(&answer[answerLen], header, sizeof(header));
+                answerLen += sizeof(header);
+                for (uint8_t i = 0; i < words; i++)
+                {
+                    answer[answerLen++] = highByte(panelMem[vp + i]);
+                    answer[answerLen++] = lowByte(panelMem[vp + i]);
+                }
+            }
+            pos += frameLen;
+        }
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+        if (answerLen > 0) write(fd, answer, answerLen);
+    }
+}
+
+int main()
+{
+    int master = -1;
+    int slave = -1;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+    {
+        Serial.printf("openpty failed\n");
+        return 1;
+    }
+    std::thread panel(panelTask, master);
+
+    DwinLinuxSerial serial(slave);
+    DWIN2::setTransport(HW_SERIAL_NUM, &serial);
+    DWIN2 dwc;
+    dwc.begin(0x5000, 0x1000);
+    dwc.setUiType(INT);
+
+    dwc.setPage(3);
+    dwc.sendData(1234);
+    Serial.printf("page %d, value %s\n", dwc.getPage(), dwc.getUiData().c_str());
+
+    // Block writes and read back, full link speed of the pty
+    static uint16_t block[BLOCK_WORDS];
+    static uint16_t readBack[BLOCK_WORDS];
+    const uint32_t startMs = millis();
+    size_t errors = 0;
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BLOCK_WORDS; i++) block[i] = r*BLOCK_WORDS + i;
+        dwc.writeBlock(0x2000, block, BLOCK_WORDS);
+        if (!dwc.flush()) errors++;
+        if (dwc.readBlock(0x2000, readBack, BLOCK_WORDS) != BLOCK_WORDS) errors++;
+        else if (memcmp(block, readBack, sizeof(block)) != 0) errors++;
+    }
+    const uint32_t ms = millis() - startMs;
+    Serial.printf("%d rounds of %d words written and read in %lu ms, %u errors\n",
+                  ROUNDS, BLOCK_WORDS, (unsigned long)ms, (unsigned)errors);
+
+    panelRun = false;
+    panel.join();
+    close(master);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinAsync.h>
+
+//*****************************************************************//
+// Coroutine workflows, build with -std=gnu++20.                 **//
+// Each zone: read the setpoint, limit it, write the setpoint    **//
+// and the power fields, switch the page and read it back.       **//
+// All zones are in flight at once, the loop is never blocked.   **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+#define ZONES_QTY 4
+#define SETPOINT_MAX 800
+
+DWIN2 dwc;
+DwinAsync bus(dwc);
+uint32_t loops = 0;
+
+DwinTask zoneFlow(DwinAsync &bus, uint8_t zone)
+{
+    const uint16_t vp = 0x1000 + zone*0x10;
+    uint16_t setpoint = 0;
+    if (co_await bus.read(vp, &setpoint) == 0)
+    {
+        Serial.printf("zone %d: no answer\n", zone);
+        co_return;
+    }
+    if (setpoint > SETPOINT_MAX) setpoint = SETPOINT_MAX;
+
+    // Queued at once, acked together
+    const uint16_t fields[2] = {setpoint, uint16_t(setpoint/10)};
+    bus.dwin().writeBlock(vp + 1, fields, 2);
+    bus.dwin().setPage(zone + 1);
+    if (!co_await bus.flush())
+    {
+        Serial.printf("zone %d: write not acked\n", zone);
+        co_return;
+    }
+
+    uint16_t page = 0;
+    if (co_await bus.read(0x0014, &page) == 0) co_return;
+    Serial.printf("zone %d: setpoint %d, page %d, %lu loops meanwhile\n", zone, setpoint, page, (unsigned long)loops);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN coroutines demo --------\n");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    for (uint8_t zone = 0; zone < ZONES_QTY; zone++)
+    {
+        if (!DwinAsync::spawn(zoneFlow(bus, zone))) Serial.printf("zone %d not started\n", zone);
+    }
+}
+
+
+void loop() {
+    // Control loop work goes on while the workflows wait for the display
+    loops++;
+    if (DwinAsync::service() == 0)
+    {
+        delay(1000);
+        for (uint8_t zone = 0; zone < ZONES_QTY; zone++) DwinAsync::spawn(zoneFlow(bus, zone));
+    }
+}
@@ -0,0 +1,68 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinWatch.h>
+
+//*****************************************************************//
+// VP subscriptions: the display RTC, a value entered without    **//
+// auto-upload and a DGUS counter are reported on change only.   **//
+// The adjacent setpoint VPs are read by one frame.              **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+// Display RTC: year-month, day-week, hour-minute, second
+#define RTC_VP 0x0010
+#define SETPOINT_VP 0x1000
+#define LIMIT_VP 0x1002
+#define COUNTER_VP 0x1100
+
+DWIN2 dwc;
+DwinWatch watch(dwc);
+uint32_t lastStatMs = 0;
+
+void onRtc(const uint16_t &, const uint16_t *data, const uint8_t &)
+{
+    Serial.printf("RTC %02d:%02d:%02d\n", highByte(data[2]), lowByte(data[2]), highByte(data[3]));
+}
+
+void onValue(const uint16_t &vp, const uint16_t *data, const uint8_t &)
+{
+    Serial.printf("VP 0x%04X = %d\n", vp, data[0]);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN subscriptions demo --------\n");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    dwc.setPage(1);
+
+    watch.subscribe(RTC_VP, 4, 1000, onRtc);
+    // 0x1000..0x1002 are joined into one read of 3 words
+    watch.subscribe(SETPOINT_VP, 1, 100, onValue);
+    watch.subscribe(LIMIT_VP, 1, 100, onValue);
+    watch.subscribe(COUNTER_VP, 2, 50, [](const uint16_t &, const uint16_t *data, const uint8_t &) {
+        Serial.printf("Counter %lu\n", (unsigned long)(((uint32_t)data[0] << 16) | data[1]));
+    });
+    // 5% of the 115200 baud line for the polling
+    watch.setBudget(576);
+}
+
+
+void loop() {
+    watch.service();
+
+    if (millis() - lastStatMs >= 10000)
+    {
+        lastStatMs = millis();
+        const watchstat_t stat = watch.getStat();
+        Serial.printf("%lu reads (%lu lost), %lu changes, %lu bytes, over budget %lu\n",
+                      (unsigned long)stat.reads, (unsigned long)stat.lostReads, (unsigned long)stat.changes,
+                      (unsigned long)stat.bytes, (unsigned long)stat.overBudget);
+        watch.resetStat();
+    }
+    delay(1);
+}
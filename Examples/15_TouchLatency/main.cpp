@@ -0,0 +1,205 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinLatency.h>
+#include <DwinLinuxSerial.h>
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+
+//*****************************************************************//
+// Touch-to-feedback latency on the host: the library on a       **//
+// pseudo-terminal pair, a simulated panel on the other side.    **//
+// A touch on the button uploads its VP, the application writes  **//
+// the LED VP in the upload handler. Measured with both touch    **//
+// drivers: injected into the panel directly and by the DGUS     **//
+// touch simulation register, then with the touches during a     **//
+// burst of block writes, so the uploads come between the acks.  **//
+// Exit code 1 if a touch is lost or the p99 of the whole path   **//
+// is over GATE_P99_US (regression gate).                        **//
+//                                                               **//
+// Built and run by tests/Makefile with the host Arduino layer   **//
+// of tests/host:                                                **//
+//   make -C tests test                                          **//
+//*****************************************************************//
+
+#define BUTTON_VP 0x1000
+#define LED_VP 0x1010
+// Touch area of the button
+#define BUTTON_X 100
+#define BUTTON_Y 200
+#define BUTTON_SIZE 50
+// Touch scan of the simulated panel
+#define TOUCH_SCAN_MS 2
+#define TOUCHES 200
+#define GATE_P99_US 20000
+// Block writes kept queued during the burst case
+#define BURST_VP 0x2000
+#define BURST_QUEUED_BYTES 1024
+
+static std::atomic<bool> panelRun(true);
+// Touch injected by the host driver: x << 16 | y, 0 - none
+static std::atomic<uint32_t> panelTouch(0);
+// Write burst case: the upload is sent right after the acks, split in two reads
+static std::atomic<bool> panelBurst(false);
+static uint16_t panelMem[0x10000];
+
+DWIN2 button;
+DWIN2 led;
+DwinLatency latency(button);
+
+// Simulated display: acks, reads, touch simulation register and the button auto-upload
+static void panelTask(int fd)
+{
+    uint8_t buf[4096];
+    size_t len = 0;
+    uint8_t upload[9];
+    bool uploadPending = false;
+    while (panelRun)
+    {
+        uint8_t answer[4096];
+        size_t answerLen = 0;
+        const uint32_t touch = panelTouch.exchange(0);
+        if (touch != 0)
+        {
+            const uint16_t x = touch >> 16;
+            const uint16_t y = touch & 0xFFFF;
+            usleep(TOUCH_SCAN_MS*1000);
+            if ((x >= BUTTON_X) && (x < BUTTON_X + BUTTON_SIZE) && (y >= BUTTON_Y) && (y < BUTTON_Y + BUTTON_SIZE))
+            {
+                // Return key value of the button control with the data auto-upload
+                panelMem[BUTTON_VP]++;
+                const uint8_t frame[] = {0x5A, 0xA5, 0x06, 0x83, highByte(BUTTON_VP), lowByte(BUTTON_VP), 0x01,
+                                         highByte(panelMem[BUTTON_VP]), lowByte(panelMem[BUTTON_VP])};
+                memcpy(upload, frame, sizeof(upload));
+                uploadPending = true;
+                if (!panelBurst)
+                {
+                    memcpy(&answer[answerLen], upload, sizeof(upload));
+                    answerLen += sizeof(upload);
+                    uploadPending = false;
+                }
+            }
+        }
+
+        pollfd pfd = {fd, POLLIN, 0};
+        if ((answerLen == 0) && (poll(&pfd, 1, 1) > 0))
+        {
+            const ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+            if (n > 0) len += n;
+        }
+        size_t pos = 0;
+        while (pos + 3 <= len)
+        {
+            if ((buf[pos] != 0x5A) || (buf[pos+1] != 0xA5)) { pos++; continue; }
+            const size_t frameLen = buf[pos+2] + 3;
+            if (pos + frameLen > len) break;
+            const uint8_t *frame = &buf[pos];
+            const uint16_t vp = (frame[4] << 8) | frame[5];
+            if (frame[3] == 0x82)
+            {
+                for (size_t i = 6; i + 1 < frameLen; i += 2) panelMem[vp + (i - 6)/2] = (frame[i] << 8) | frame[i+1];
+                // Touch simulation register: 0x5AA5, mode, x, y
+                if ((vp == LATENCY_TOUCH_VP) && (panelMem[LATENCY_TOUCH_VP] == 0x5AA5))
+                {
+                    panelMem[LATENCY_TOUCH_VP] = 0;
+                    panelTouch = (uint32_t(panelMem[LATENCY_TOUCH_VP + 2]) << 16) | panelMem[LATENCY_TOUCH_VP + 3];
+                }
+                const uint8_t ack[] = {0x5A, 0xA5, 0x03, 0x82, 0x4F, 0x4B};
+                memcpy(&answer[answerLen], ack, sizeof(ack));
+                answerLen += sizeof(ack);
+            }
+            else if (frame[3] == 0x83)
+            {
+                const uint8_t words = frame[6];
+                const uint8_t header[] = {0x5A, 0xA5, uint8_t(4 + words*2), 0x83, frame[4], frame[5], words};
+                memcpy(&answer[answerLen], header, sizeof(header));
+                answerLen += sizeof(header);
+                for (uint8_t i = 0; i < words; i++)
+                {
+                    answer[answerLen++] = highByte(panelMem[vp + i]);
+                    answer[answerLen++] = lowByte(panelMem[vp + i]);
+                }
+            }
+            pos += frameLen;
+        }
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+        if ((answerLen > 0) && uploadPending)
+        {
+            // The last ack and the start of the upload are read together, the rest later
+            memcpy(&answer[answerLen], upload, 4);
+            write(fd, answer, answerLen + 4);
+            usleep(200);
+            write(fd, upload + 4, sizeof(upload) - 4);
+            uploadPending = false;
+        }
+        else if (answerLen > 0)
+        {
+            write(fd, answer, answerLen);
+        }
+    }
+}
+
+// Host touch driver: straight into the simulated panel
+static void touchSim(DWIN2 &, const uint16_t &x, const uint16_t &y)
+{
+    panelTouch = (uint32_t(x) << 16) | y;
+}
+
+static bool measure(const char *driver, const bool &burst = false)
+{
+    static uint16_t burstWords[DWIN_MAX_BLOCK_WORDS];
+    panelBurst = burst;
+    latency.start(BUTTON_VP, LED_VP, BUTTON_X + 10, BUTTON_Y + 10, TOUCHES, 5);
+    while (latency.service())
+    {
+        // The bus is never idle: the uploads arrive while the acks of the writes are awaited
+        if (burst && (button.pendingTxBytes() < BURST_QUEUED_BYTES))
+        {
+            burstWords[0]++;
+            button.writeBlock(BURST_VP, burstWords, DWIN_MAX_BLOCK_WORDS);
+        }
+        button.poll();
+        button.serviceUploads();
+    }
+    Serial.printf("---- %s ----\n", driver);
+    latency.report(Serial);
+    return latency.check(LATENCY_TOTAL, 99, GATE_P99_US);
+}
+
+int main()
+{
+    int master = -1;
+    int slave = -1;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+    {
+        Serial.printf("openpty failed\n");
+        return 1;
+    }
+    std::thread panel(panelTask, master);
+
+    DwinLinuxSerial serial(slave);
+    DWIN2::setTransport(HW_SERIAL_NUM, &serial);
+    button.begin(0x5000, BUTTON_VP);
+    led.begin(0x5010, LED_VP);
+    led.setUiType(INT);
+    // Application: the LED shows the button count
+    button.setUploadHandler([](DWIN2 &, const uint16_t *data, const uint8_t &) {
+        led.sendData(int(data[0]));
+    });
+
+    latency.setTouchDriver(touchSim);
+    bool ok = measure("host driver");
+    latency.setTouchDriver(NULL);
+    ok &= measure("touch simulation register");
+    latency.setTouchDriver(touchSim);
+    ok &= measure("host driver, write burst", true);
+    Serial.printf("LED %d, gate p99 %d us: %s\n", panelMem[LED_VP], GATE_P99_US, ok ? "pass" : "FAIL");
+
+    panelRun = false;
+    panel.join();
+    close(master);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Dwin2.h>
+#include <DwinTimeline.h>
+
+//*****************************************************************//
+// Timeline of the bus: writes, a blocking read and async reads  **//
+// overlapping with the loop. Send 't' to write the last events  **//
+// into /timeline.json of LittleFS, copy the file to the PC and  **//
+// open it in chrome://tracing or ui.perfetto.dev                **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+#define TIMELINE_FILE "/timeline.json"
+#define VALUE_VP 0x1000
+
+DWIN2 dwc;
+DwinTimeline timeline;
+dwinread_t valueRead;
+uint16_t value[4];
+uint32_t lastSendMs = 0;
+uint32_t lastReadMs = 0;
+int counter = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN timeline demo --------\n");
+
+    if (!LittleFS.begin(true))
+    {
+        Serial.printf("LittleFS mount failed\n");
+    }
+
+    dwc.begin(0x5000, VALUE_VP, RX_PIN, TX_PIN);
+    dwc.setTimeline(&timeline);
+    dwc.setUiType(INT);
+    dwc.setPage(1);
+    valueRead.vp = VALUE_VP;
+    valueRead.count = 4;
+    valueRead.data = value;
+    valueRead.state = DWIN_READ_IDLE;
+}
+
+
+void loop() {
+    if (millis() - lastSendMs >= 20)
+    {
+        lastSendMs = millis();
+        dwc.sendData(++counter);
+        // The next read after the previous one is answered
+        if (valueRead.state != DWIN_READ_PENDING) dwc.readAsync(valueRead);
+    }
+    if (millis() - lastReadMs >= 500)
+    {
+        lastReadMs = millis();
+        Serial.printf("page %d\n", dwc.getPage());
+    }
+
+    if (Serial.read() == 't')
+    {
+        File file = LittleFS.open(TIMELINE_FILE, "w");
+        const size_t events = timeline.writeJson(file);
+        Serial.printf("%s: %u events of %lu recorded, %u bytes\n", TIMELINE_FILE, (unsigned)events,
+                      (unsigned long)timeline.getRecorded(), (unsigned)file.size());
+        file.close();
+        timeline.clear();
+    }
+    delay(1);
+}
@@ -74,9 +74,10 @@ void setup() {
 
 //----------------------------------------------------------------------------------------
 
-    // Restart HMI
+    // Restart HMI, returns when the display answers again
     //dwc.restartHMI();
-    delay(1000);
+    // Wait until the commands are sent and acked instead of a fixed delay
+    dwc.flush();
     Serial.printf("----- Dwin Display common commands end -----\n");
 
 //----------------------------------------------------------------------------------------
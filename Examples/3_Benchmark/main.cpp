@@ -0,0 +1,224 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinKernels.h>
+#include <DwinStore.h>
+#include <DwinElement.h>
+
+//*****************************************************************//
+// Benchmark of the bulk endian/packing kernels                  **//
+// against the byte-by-byte scalar versions,                     **//
+// numeric formats: encode time, bytes and frames per second     **//
+// and the startup time of the settings store (display needed)   **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+#define WORDS_QTY 1024
+#define ITERATIONS 200
+// Keys in the settings store benchmark
+#define STORE_KEYS 3000
+// Values sent in the numeric formats benchmark
+#define NUMERIC_QTY 500
+
+DWIN2 dwc;
+
+uint16_t words16[WORDS_QTY];
+uint32_t words32[WORDS_QTY];
+float floats[WORDS_QTY];
+uint8_t bytes[WORDS_QTY*4];
+// Output of the scalar reference for the checks
+uint8_t refBytes[WORDS_QTY*4];
+uint16_t refWords16[WORDS_QTY];
+// Edge values of the fixed point conversions: rounding, saturation, out of the int32 range, NaN
+const float edgeFloats[] = {0.004f, 0.005f, -0.005f, 327.67f, 327.68f, -327.68f, -327.69f, 1e10f,
+                            -1e10f, 3e9f, -3e9f, NAN, INFINITY, -INFINITY, 21474836.0f, -21474837.0f};
+
+// Print time of one kernel run in microseconds and the speedup
+void printResult(const char *name, const uint32_t &scalarUs, const uint32_t &kernelUs)
+{
+    Serial.printf("%-18s scalar %6lu us  kernel %6lu us  x%.2f\n", name,
+        (unsigned long)scalarUs, (unsigned long)kernelUs, (float)scalarUs/(kernelUs > 0 ? kernelUs : 1));
+}
+
+// Compare the kernel output with the scalar reference
+bool checkResult(const char *name, const void *kernel, const void *scalar, const size_t &bytesQty)
+{
+    const uint8_t *k = static_cast<const uint8_t*>(kernel);
+    const uint8_t *s = static_cast<const uint8_t*>(scalar);
+    for (size_t i = 0; i < bytesQty; i++)
+    {
+        if (k[i] == s[i]) continue;
+        Serial.printf("%-18s MISMATCH at byte %u: kernel %02X, scalar %02X\n", name, (unsigned)i, k[i], s[i]);
+        return false;
+    }
+    Serial.printf("%-18s matches scalar\n", name);
+    return true;
+}
+
+// Encode time of one value in the format, nanoseconds, and the frame size
+template<class F>
+void printFormat(const char *name)
+{
+    uint8_t frame[ELEMENT_HEADER + F::words*2];
+    volatile size_t len = 0;
+    const uint32_t start = micros();
+    for (int n = 0; n < ITERATIONS; n++)
+    {
+        for (int i = 0; i < WORDS_QTY; i++) len = F::encode(&frame[ELEMENT_HEADER], floats[i]);
+    }
+    const uint32_t us = micros() - start;
+    Serial.printf("%-12s encode %6.1f ns/value  frame %2d bytes\n", name,
+        us*1000.0f/(ITERATIONS*WORDS_QTY), ELEMENT_HEADER + (int)len);
+}
+
+// Send NUMERIC_QTY values to the display in the format and wait for the acks
+template<class F>
+void sendFormat(const char *name, const uint16_t &vp)
+{
+    DwinElement<F> element(dwc, vp);
+    const uint32_t start = millis();
+    for (int i = 0; i < NUMERIC_QTY; i++) element.set(floats[i]);
+    const bool ok = dwc.flush(5000);
+    const uint32_t ms = millis() - start;
+    Serial.printf("%-12s %d values: %5lu ms, %6.0f values/s %s\n", name, NUMERIC_QTY,
+        (unsigned long)ms, NUMERIC_QTY*1000.0f/(ms > 0 ? ms : 1), ok ? "" : "(lost frames)");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- DWIN2 kernels benchmark --------\n");
+    Serial.printf("%d words, %d iterations\n", WORDS_QTY, ITERATIONS);
+
+    for (int i = 0; i < WORDS_QTY; i++)
+    {
+        words16[i] = i*31;
+        words32[i] = i*100003;
+        floats[i] = i*0.37f - 100.0f;
+    }
+
+    uint32_t start, scalarUs, kernelUs;
+
+    // Host to big endian, 16 bit
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinHostToBe16Scalar(bytes, words16, WORDS_QTY);
+    scalarUs = micros() - start;
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinHostToBe16(bytes, words16, WORDS_QTY);
+    kernelUs = micros() - start;
+    printResult("HostToBe16", scalarUs, kernelUs);
+
+    // Big endian to host, 16 bit
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinBeToHost16Scalar(words16, bytes, WORDS_QTY);
+    scalarUs = micros() - start;
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinBeToHost16(words16, bytes, WORDS_QTY);
+    kernelUs = micros() - start;
+    printResult("BeToHost16", scalarUs, kernelUs);
+
+    // Host to big endian, 32 bit
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinHostToBe32Scalar(bytes, words32, WORDS_QTY);
+    scalarUs = micros() - start;
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinHostToBe32(bytes, words32, WORDS_QTY);
+    kernelUs = micros() - start;
+    printResult("HostToBe32", scalarUs, kernelUs);
+
+    // UTF-16 byte swap in place
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinSwap16Scalar(bytes, WORDS_QTY);
+    scalarUs = micros() - start;
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinSwap16(bytes, WORDS_QTY);
+    kernelUs = micros() - start;
+    printResult("Swap16", scalarUs, kernelUs);
+
+    // Float to fixed point x100
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinFloatToFixed32Scalar(bytes, floats, WORDS_QTY, 100.0f);
+    scalarUs = micros() - start;
+    start = micros();
+    for (int n = 0; n < ITERATIONS; n++) dwinFloatToFixed32(bytes, floats, WORDS_QTY, 100.0f);
+    kernelUs = micros() - start;
+    printResult("FloatToFixed32", scalarUs, kernelUs);
+
+    // The kernels give the same bytes as the scalar reference
+    bool same = true;
+    dwinHostToBe16Scalar(refBytes, words16, WORDS_QTY);
+    dwinHostToBe16(bytes, words16, WORDS_QTY);
+    same &= checkResult("HostToBe16", bytes, refBytes, WORDS_QTY*2);
+    dwinBeToHost16Scalar(refWords16, refBytes, WORDS_QTY);
+    dwinBeToHost16(words16, refBytes, WORDS_QTY);
+    same &= checkResult("BeToHost16", words16, refWords16, WORDS_QTY*2);
+    dwinHostToBe32Scalar(refBytes, words32, WORDS_QTY);
+    dwinHostToBe32(bytes, words32, WORDS_QTY);
+    same &= checkResult("HostToBe32", bytes, refBytes, WORDS_QTY*4);
+    memcpy(bytes, refBytes, WORDS_QTY*2);
+    dwinSwap16Scalar(refBytes, WORDS_QTY);
+    dwinSwap16(bytes, WORDS_QTY);
+    same &= checkResult("Swap16", bytes, refBytes, WORDS_QTY*2);
+    // Edge values at the start, in the vector part of the kernels
+    memcpy(floats, edgeFloats, sizeof(edgeFloats));
+    dwinFloatToFixed16Scalar(refBytes, floats, WORDS_QTY, 100.0f);
+    dwinFloatToFixed16(bytes, floats, WORDS_QTY, 100.0f);
+    same &= checkResult("FloatToFixed16", bytes, refBytes, WORDS_QTY*2);
+    dwinFloatToFixed32Scalar(refBytes, floats, WORDS_QTY, 100.0f);
+    dwinFloatToFixed32(bytes, floats, WORDS_QTY, 100.0f);
+    same &= checkResult("FloatToFixed32", bytes, refBytes, WORDS_QTY*4);
+    if (!same) Serial.printf("ERR kernels differ from the scalar reference\n");
+
+    Serial.printf("-------- DWIN2 kernels benchmark finished --------\n");
+
+//----------------------------------------------------------------------------------------
+
+    Serial.printf("\n-------- DWIN2 numeric formats benchmark --------\n");
+    printFormat<Double>("Double");
+    printFormat<Float>("Float");
+    printFormat<Fixed<2>>("Fixed<2>");
+    printFormat<Fixed16<2>>("Fixed16<2>");
+
+    // Wire throughput: 8, 4 and 2 data bytes per value
+    dwc.begin(0, 0, RX_PIN, TX_PIN);
+    sendFormat<Double>("Double", 0x5000);
+    sendFormat<Float>("Float", 0x5000);
+    sendFormat<Fixed<2>>("Fixed<2>", 0x5000);
+    sendFormat<Fixed16<2>>("Fixed16<2>", 0x5000);
+    // Round-trip time and pipeline depth the bus adapted to for this display and baud rate
+    const dwinstat_t stat = dwc.getStat();
+    Serial.printf("write RTT %lu us (+-%lu), timeout %lu ms, pipeline %d frames, %lu lost\n",
+        (unsigned long)stat.rtt[DWIN_RTT_WRITE].srttUs, (unsigned long)stat.rtt[DWIN_RTT_WRITE].rttvarUs,
+        (unsigned long)stat.rtt[DWIN_RTT_WRITE].timeoutMs, stat.pipelineDepth, (unsigned long)stat.lostFrames);
+    Serial.printf("-------- DWIN2 numeric formats benchmark finished --------\n");
+
+//----------------------------------------------------------------------------------------
+
+    Serial.printf("\n-------- DWIN2 store benchmark --------\n");
+    DwinStore store(dwc);
+
+    // Fill the store, one batch per 500 keys
+    start = millis();
+    store.begin();
+    for (int i = 0; i < STORE_KEYS; i++)
+    {
+        store.putInt(i, i*10);
+        if (i % 500 == 499) store.commit();
+    }
+    store.commit();
+    Serial.printf("Write %d keys: %lu ms, log %lu words\n", STORE_KEYS, millis() - start, (unsigned long)store.getLogWords());
+
+    // Rebuild the lookup table from the log, as at startup
+    start = millis();
+    bool ok = store.begin();
+    Serial.printf("Startup with %u keys: %lu ms, %s\n", (unsigned)store.size(), (unsigned long)(millis() - start), ok ? "ok" : "failed");
+    Serial.printf("Key %d = %ld\n", STORE_KEYS/2, (long)store.getInt(STORE_KEYS/2));
+    Serial.printf("-------- DWIN2 store benchmark finished --------\n");
+}
+
+
+void loop() {
+    delay(portMAX_DELAY);
+}
@@ -0,0 +1,34 @@
+// Generated by tools/dwin_map_gen.py from DWIN_SET, do not edit
+
+#ifndef DwinMap_h
+#define DwinMap_h
+
+#include <Dwin2.h>
+
+namespace DwinMap
+{
+    // Page 0, DOUBLE, VP 0x1010
+    typedef DwinVar<DOUBLE, 0x1010, 0x9010, 0, 0> Dbl_1010;
+    // Page 0, INT, VP 0x1000
+    typedef DwinVar<INT, 0x1000, 0x9000, 0, 0> Int_1000;
+    // Page 0, ASCII, VP 0x1020
+    typedef DwinVar<ASCII, 0x1020, 0x9020, 40, 0> Ascii_1020;
+    // Page 0, UTF, VP 0x1030
+    typedef DwinVar<UTF, 0x1030, 0x9030, 40, 0> Utf_1030;
+
+    // All elements, to set up DWIN2 objects in a loop
+    constexpr dwinelem_t ELEMENTS[] = {
+        Dbl_1010::elem(),
+        Int_1000::elem(),
+        Ascii_1020::elem(),
+        Utf_1030::elem(),
+    };
+    constexpr size_t ELEMENTS_QTY = 4;
+}
+
+// Address checks
+static_assert(DwinMap::Int_1000::vp + 1 <= DwinMap::Dbl_1010::vp, "VP of Int_1000 overlaps Dbl_1010");
+static_assert(DwinMap::Dbl_1010::vp + 4 <= DwinMap::Ascii_1020::vp, "VP of Dbl_1010 overlaps Ascii_1020");
+// Warning: Ascii_1020 text of 40 bytes overlaps Utf_1030
+
+#endif
@@ -0,0 +1,58 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinElement.h>
+// Generated from the DGUS project:
+// python3 tools/dwin_map_gen.py DWIN_Display_Interface/DWIN_SET -o Examples/4_TypedMap/DwinMap.h
+#include "DwinMap.h"
+
+//*****************************************************************//
+// Addresses and types of the UI elements come from DwinMap.h    **//
+// Wrong type of the data is a compile error                     **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+// One object per UI element of the DGUS project
+DWIN2 *dwc[DwinMap::ELEMENTS_QTY];
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN typed map demo --------\n");
+
+    // Addresses and ui types are taken from the descriptors
+    for (size_t i = 0; i < DwinMap::ELEMENTS_QTY; i++)
+    {
+        dwc[i] = new DWIN2;
+        dwc[i]->begin(DwinMap::ELEMENTS[i], RX_PIN, TX_PIN);
+        dwc[i]->setId(i);
+    }
+
+    // Any object can send data to any element of the map
+    dwc[0]->sendData<DwinMap::Int_1000>(55);
+    dwc[0]->sendData<DwinMap::Dbl_1010>(25.8);
+    dwc[0]->sendData<DwinMap::Ascii_1020>("ASCII");
+    dwc[0]->sendData<DwinMap::Utf_1030>("UTF Текст");
+    // Does not compile: Int_1000 is not a text element
+    // dwc[0]->sendData<DwinMap::Int_1000>("Text");
+
+    // Typed elements share one DWIN2 object and take 8 bytes each
+    DwinElement<Int16> speed(*dwc[0], DwinMap::Int_1000());
+    DwinElement<Double> temp(*dwc[0], DwinMap::Dbl_1010());
+    DwinElement<Utf<20>> title(*dwc[0], DwinMap::Utf_1030());
+    speed.set(120);
+    temp.set(36.6);
+    title.set("Скорость");
+    Serial.printf("Speed on display: %d\n", speed.get());
+    // Does not compile: Int_1000 is not a double element
+    // DwinElement<Double> wrong(*dwc[0], DwinMap::Int_1000());
+
+    Serial.printf("-------- DWIN typed map demo finished --------\n");
+}
+
+
+void loop() {
+    delay(portMAX_DELAY);
+}
@@ -0,0 +1,61 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+
+//*****************************************************************//
+// Two displays on two UART ports: each port has its own task    **//
+// Mirror mode sends the same frames to the front and rear panel **//
+//*****************************************************************//
+
+// Front panel on Serial2
+#define FRONT_SERIAL 2
+#define FRONT_RX_PIN 16
+#define FRONT_TX_PIN 17
+// Rear panel on Serial1
+#define REAR_SERIAL 1
+#define REAR_RX_PIN 4
+#define REAR_TX_PIN 5
+
+DWIN2 front;
+DWIN2 rear;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN multi display demo --------\n");
+
+    // Port tasks on different cores, before begin()
+    DWIN2::setBusTask(FRONT_SERIAL, 0, 1);
+    DWIN2::setBusTask(REAR_SERIAL, 1, 1);
+
+    // Independent displays
+    front.begin(0x5000, 0x1000, FRONT_RX_PIN, FRONT_TX_PIN, FRONT_SERIAL);
+    front.setUiType(INT);
+    rear.begin(0x5000, 0x1000, REAR_RX_PIN, REAR_TX_PIN, REAR_SERIAL);
+    rear.setUiType(INT);
+
+    front.setPage(1);
+    rear.setPage(2);
+    front.sendData(10);
+    rear.sendData(20);
+    front.flush();
+    rear.flush();
+    Serial.printf("Front page %d, rear page %d\n", front.getPage(), rear.getPage());
+    delay(2000);
+
+    // Mirror mode: frames of the front panel are encoded once and sent to both ports
+    front.addMirror(REAR_SERIAL, REAR_RX_PIN, REAR_TX_PIN);
+    front.setPage(1);
+    for (int i = 0; i <= 100; i += 10)
+    {
+        front.sendData(i);
+        delay(200);
+    }
+    Serial.printf("Mirror flush %s\n", front.flush() ? "ok" : "failed");
+
+    Serial.printf("-------- DWIN multi display demo finished --------\n");
+}
+
+
+void loop() {
+    delay(portMAX_DELAY);
+}
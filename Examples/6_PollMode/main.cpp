@@ -0,0 +1,50 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+
+//*****************************************************************//
+// Superloop without the library task and semaphores             **//
+// Build with -DDWIN_NO_RTOS (e.g. build_flags in platformio.ini) **//
+// The bus is advanced by poll() calls                           **//
+//*****************************************************************//
+
+#ifndef DWIN_NO_RTOS
+#error "Build the example with -DDWIN_NO_RTOS"
+#endif
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+DWIN2 dwc;
+uint32_t lastSendMs = 0;
+int counter = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN poll mode demo --------\n");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    dwc.setUiType(INT);
+    dwc.setPage(1);
+    // Blinking is advanced by poll() as well
+    dwc.setBlinkPeriod(500);
+    dwc.blink(true);
+}
+
+
+void loop() {
+    // Other work of the superloop
+    if (millis() - lastSendMs >= 100)
+    {
+        lastSendMs = millis();
+        dwc.sendData(counter++);
+    }
+
+    // Send the queued frames, receive the answers, blink
+    dwc.poll();
+
+    // Sleep until the bus has work to do, but not longer than the superloop period
+    const uint32_t deadline = dwc.nextDeadline();
+    if (deadline > 0) delay(std::min<uint32_t>(deadline, 10));
+}
@@ -0,0 +1,80 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <new>
+
+//*****************************************************************//
+// Heap-free sending and reading: allocations are counted        **//
+// after begin(), the expected count is 0                        **//
+// Build with -DDWIN_NO_HEAP to drop the heap containers         **//
+// from the API as well                                          **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+// Count the allocations made by new in the measured part
+static volatile bool counting = false;
+static volatile uint32_t allocCount = 0;
+
+void *operator new(size_t size)
+{
+    if (counting) allocCount++;
+    return malloc(size);
+}
+void *operator new[](size_t size)
+{
+    if (counting) allocCount++;
+    return malloc(size);
+}
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+// The list is not copied by setStrListVal()
+static const char *const modes[] = {"Off", "Low", "Mid", "High"};
+
+DWIN2 dwc;
+DWIN2 title;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN heap-free demo --------\n");
+
+    // Allocations of begin() are not counted: task, semaphores, UART driver
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    dwc.setUiType(INT);
+    title.begin(0x5100, 0x1100, RX_PIN, TX_PIN);
+    title.setUiType(UTF);
+    dwc.setPage(1);
+    dwc.flush();
+
+    counting = true;
+    for (int i = 0; i < 100; i++)
+    {
+        dwc.sendData(i);
+        dwc.setColor(i % 2 ? RED : GREEN);
+        title.sendData("UTF Текст");
+    }
+    uint16_t words[32];
+    const size_t received = dwc.readBlock(0x5000, words, 32);
+    const bool flushed = dwc.flush();
+
+    title.setUiType(ASCII);
+    title.setStrListVal(modes, 4);
+    title.setLimits();
+    title.setStartVal(2);
+    title.flush();
+    counting = false;
+
+    Serial.printf("Read %u words, flush %s\n", (unsigned)received, flushed ? "ok" : "failed");
+    Serial.printf("Heap allocations after begin(): %lu\n", (unsigned long)allocCount);
+    Serial.printf("-------- DWIN heap-free demo finished --------\n");
+}
+
+
+void loop() {
+    delay(portMAX_DELAY);
+}
@@ -0,0 +1,58 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinEncoder.h>
+
+//*****************************************************************//
+// Rotary encoder on GPIO interrupts                             **//
+// The interrupt only counts ticks, the value is sent once per   **//
+// refresh period with the acceleration of fast spins            **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+// Encoder A and B pins, swap them to reverse the direction
+#define ENC_A_PIN 32
+#define ENC_B_PIN 33
+
+DWIN2 dwc;
+DwinEncoder encoder(dwc);
+
+void IRAM_ATTR encoderIsr()
+{
+    encoder.readPins(digitalRead(ENC_A_PIN), digitalRead(ENC_B_PIN));
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN encoder demo --------\n");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    dwc.setUiType(INT);
+    dwc.setLimits(0, 1000);
+    dwc.setStartVal(0);
+    dwc.setPage(1);
+
+    // x1 up to 20 detents/s, x10 from 200 detents/s
+    encoder.setAcceleration(20, 200, 10.0f);
+    // One frame every 20 ms at most
+    encoder.begin(20);
+
+    pinMode(ENC_A_PIN, INPUT_PULLUP);
+    pinMode(ENC_B_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(ENC_A_PIN), encoderIsr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(ENC_B_PIN), encoderIsr, CHANGE);
+}
+
+
+void loop() {
+#ifdef DWIN_NO_RTOS
+    // Without RTOS the encoder and the bus are serviced by the superloop
+    encoder.service();
+    dwc.poll();
+#else
+    delay(500);
+    Serial.printf("Value %d, speed %.0f detents/s\n", (int)dwc.getCurrentVal(), encoder.getRate());
+#endif
+}
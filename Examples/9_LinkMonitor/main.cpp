@@ -0,0 +1,56 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinLink.h>
+
+//*****************************************************************//
+// Link health monitor: restart the display or switch its power  **//
+// off and on, the page and the values come back by themselves   **//
+//*****************************************************************//
+
+// Rx Tx ESP gpio connected to DWin Display
+#define RX_PIN 16
+#define TX_PIN 17
+
+DWIN2 dwc;
+DwinLink link(dwc);
+uint32_t lastSendMs = 0;
+uint32_t lastRestartMs = 0;
+int counter = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (Serial.available()) {}
+    Serial.printf("-------- Start DWIN link monitor demo --------\n");
+
+    dwc.begin(0x5000, 0x1000, RX_PIN, TX_PIN);
+    dwc.setUiType(INT);
+    // Shadow state and heartbeat every 250 ms, before the values to keep
+    link.begin(250);
+    link.setResyncHandler([](DwinLink &l) {
+        Serial.printf("Resync #%lu\n", (unsigned long)l.getResyncCount());
+    });
+    dwc.setPage(1);
+    dwc.sendData(counter);
+    lastRestartMs = millis();
+}
+
+
+void loop() {
+    // Values change rarely, after a reset the display would stay blank until the next change
+    if (millis() - lastSendMs >= 5000)
+    {
+        lastSendMs = millis();
+        dwc.sendData(++counter);
+    }
+    // Restart the display every 20 s as a test of the recovery
+    if (millis() - lastRestartMs >= 20000)
+    {
+        lastRestartMs = millis();
+        const uint32_t start = millis();
+        dwc.restartHMI();
+        Serial.printf("restartHMI() took %lu ms\n", millis() - start);
+    }
+
+    link.service();
+    if (link.getState() == LINK_OK) delay(10);
+}
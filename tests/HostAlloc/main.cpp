@@ -0,0 +1,166 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinLinuxSerial.h>
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+#include <new>
+
+//*****************************************************************//
+// Host test: no heap allocations after begin(). operator new is **//
+// replaced, after begin() and a warm-up round every allocation  **//
+// is a failure. DWIN2 talks to a simulated panel over a         **//
+// pseudo-terminal pair, as in Examples/12_LinuxGateway.         **//
+//                                                               **//
+// Built and run by tests/Makefile with the host Arduino layer   **//
+// of tests/host, with and without -DDWIN_NO_HEAP:               **//
+//   make -C tests test                                          **//
+// Exit code 0 - passed, 1 - allocations or bus errors.          **//
+//*****************************************************************//
+
+#define ROUNDS 200
+#define BLOCK_WORDS 300
+
+static std::atomic<bool> allocCheck(false);
+static std::atomic<size_t> allocCount(0);
+static std::atomic<bool> panelRun(true);
+static uint16_t panelMem[0x10000];
+
+void *operator new(size_t size)
+{
+    if (allocCheck)
+    {
+        allocCount++;
+        // Only the first ones are printed, printf itself does not allocate through new
+        if (allocCount <= 10) fprintf(stderr, "allocation of %u bytes after begin()\n", (unsigned)size);
+    }
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// Simulated display: acks the writes and answers the reads from VP memory
+static void panelTask(int fd)
+{
+    uint8_t buf[4096];
+    size_t len = 0;
+    while (panelRun)
+    {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        const ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+        if (n <= 0) continue;
+        len += n;
+
+        uint8_t answer[4096];
+        size_t answerLen = 0;
+        size_t pos = 0;
+        while (pos + 3 <= len)
+        {
+            if ((buf[pos] != 0x5A) || (buf[pos+1] != 0xA5)) { pos++; continue; }
+            const size_t frameLen = buf[pos+2] + 3;
+            if (pos + frameLen > len) break;
+            const uint8_t *frame = &buf[pos];
+            const uint16_t vp = (frame[4] << 8) | frame[5];
+            if (frame[3] == 0x82)
+            {
+                for (size_t i = 6; i + 1 < frameLen; i += 2) panelMem[vp + (i - 6)/2] = (frame[i] << 8) | frame[i+1];
+                const uint8_t ack[] = {0x5A, 0xA5, 0x03, 0x82, 0x4F, 0x4B};
+                memcpy(&answer[answerLen], ack, sizeof(ack));
+                answerLen += sizeof(ack);
+            }
+            else if (frame[3] == 0x83)
+            {
+                const uint8_t words = frame[6];
+                const uint8_t header[] = {0x5A, 0xA5, uint8_t(4 + words*2), 0x83, frame[4], frame[5], words};
+                memcpy(&answer[answerLen], header, sizeof(header));
+                answerLen += sizeof(header);
+                for (uint8_t i = 0; i < words; i++)
+                {
+                    answer[answerLen++] = highByte(panelMem[vp + i]);
+                    answer[answerLen++] = lowByte(panelMem[vp + i]);
+                }
+            }
+            pos += frameLen;
+        }
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+        if (answerLen > 0) write(fd, answer, answerLen);
+    }
+}
+
+// The calls documented as heap-free, returns the number of bus errors
+static size_t busRound(DWIN2 &dwc, const int &round)
+{
+    static uint16_t block[BLOCK_WORDS];
+    static uint16_t readBack[BLOCK_WORDS];
+    size_t errors = 0;
+    dwc.sendData(round);
+    dwc.sendData(round * 0.5);
+    dwc.setColor(round & 0xFFFF);
+    for (size_t i = 0; i < BLOCK_WORDS; i++) block[i] = round + i;
+    dwc.writeBlock(0x2000, block, BLOCK_WORDS);
+    if (!dwc.flush()) errors++;
+    if (dwc.readBlock(0x2000, readBack, BLOCK_WORDS) != BLOCK_WORDS) errors++;
+    else if (memcmp(block, readBack, sizeof(block)) != 0) errors++;
+    return errors;
+}
+
+int main()
+{
+    int master = -1;
+    int slave = -1;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+    {
+        Serial.printf("openpty failed\n");
+        return 1;
+    }
+    std::thread panel(panelTask, master);
+
+    DwinLinuxSerial serial(slave);
+    DWIN2::setTransport(HW_SERIAL_NUM, &serial);
+    DWIN2 dwc;
+    dwc.begin(0x5000, 0x1000);
+    dwc.setUiType(INT);
+    dwc.setEcho(false);
+    // Warm-up: first use of the bus buffers
+    size_t errors = busRound(dwc, 0);
+
+    allocCheck = true;
+    for (int r = 1; r <= ROUNDS; r++) errors += busRound(dwc, r);
+    allocCheck = false;
+
+    Serial.printf("%d rounds: %u allocations after begin(), %u bus errors\n",
+                  ROUNDS, (unsigned)allocCount, (unsigned)errors);
+    panelRun = false;
+    panel.join();
+    close(master);
+    return ((allocCount == 0) && (errors == 0)) ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+#include <Arduino.h>
+#include <Dwin2.h>
+#include <DwinTrace.h>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+//*****************************************************************//
+// Parity test of tools/dwin_trace.py: DWIN2 runs a script of    **//
+// pipelined writes and reads against a simulated panel that     **//
+// drops some answers and sends touch auto-uploads, some split  **//
+// across the end of a group. The trace is written to trace.bin  **//
+// and the frames counted by the bus to expect.txt. parity.py replays    **//
+// the trace with the Python port of sendGroup()/countAnswers()  **//
+// and fails if its counts differ from the bus.                  **//
+//                                                               **//
+// Built and run with parity.py by tests/Makefile, with the      **//
+// host Arduino layer of tests/host:                             **//
+//   make -C tests test                                          **//
+//*****************************************************************//
+
+#define ROUNDS 300
+// Every DROP_EVERY-th frame is not answered
+#define DROP_EVERY 37
+// Answer time of the panel: first frame and each next frame of a group
+#define ANSWER_US 400
+#define FRAME_US 100
+// Every UPLOAD_EVERY-th frame is followed by a touch upload, every second one split
+#define UPLOAD_EVERY 29
+#define UPLOAD_VP 0x0010
+#define UPLOAD_SPLIT_US 3000
+
+// Panel on the other side of the transport: VP memory, acks and read answers
+// after a delay, no answer to every DROP_EVERY-th frame, touch uploads
+class ScriptPanel : public DwinTransport
+{
+private:
+    typedef struct {
+        uint32_t atUs;
+        std::vector<uint8_t> data;
+    } answer_t;
+    std::deque<answer_t> _pending;
+    std::vector<uint8_t> _rx;
+    uint16_t _mem[0x10000];
+    uint32_t _frameNum;
+    uint32_t _uploadNum;
+
+    // The panel sends one frame after the other: not before the bytes queued
+    void push(uint32_t atUs, const std::vector<uint8_t> &data)
+    {
+        if (!_pending.empty() && (int32_t(atUs - _pending.back().atUs) < 0)) atUs = _pending.back().atUs;
+        _pending.push_back(answer_t{atUs, data});
+    }
+
+    // Touch upload after the answer, the rest of a split frame later
+    void upload(const uint32_t &atUs)
+    {
+        const uint8_t key = uint8_t(++_uploadNum);
+        const std::vector<uint8_t> frame = {0x5A, 0xA5, 0x06, 0x83, highByte(UPLOAD_VP), lowByte(UPLOAD_VP), 0x01, 0x00, key};
+        if (_uploadNum % 2 == 0)
+        {
+            push(atUs, std::vector<uint8_t>(frame.begin(), frame.begin() + 4));
+            push(atUs + UPLOAD_SPLIT_US, std::vector<uint8_t>(frame.begin() + 4, frame.end()));
+        }
+        else
+        {
+            push(atUs, frame);
+        }
+    }
+
+    // Move the answers due by now to the received bytes
+    void receive()
+    {
+        const uint32_t nowUs = micros();
+        while (!_pending.empty() && (int32_t(nowUs - _pending.front().atUs) >= 0))
+        {
+            _rx.insert(_rx.end(), _pending.front().data.begin(), _pending.front().data.end());
+            _pending.pop_front();
+        }
+    }
+
+public:
+    ScriptPanel() : _frameNum(0), _uploadNum(0)
+    {
+        memset(_mem, 0, sizeof(_mem));
+    }
+
+    bool begin(const uint8_t &, const uint8_t &) override
+    {
+        return true;
+    }
+
+    size_t write(const uint8_t *data, const size_t &len) override
+    {
+        uint32_t atUs = micros() + ANSWER_US;
+        size_t pos = 0;
+        while ((pos + 7 <= len) && (pos + data[pos+2] + 3 <= len))
+        {
+            const uint8_t *frame = &data[pos];
+            const size_t frameLen = frame[2] + 3;
+            const uint16_t vp = (frame[4] << 8) | frame[5];
+            pos += frameLen;
+            atUs += FRAME_US;
+            ++_frameNum;
+            if (_frameNum % DROP_EVERY == 0)
+            {
+                if (_frameNum % UPLOAD_EVERY == 0) upload(atUs);
+                continue;
+            }
+            answer_t answer = {atUs, {}};
+            if (frame[3] == 0x82)
+            {
+                for (size_t i = 6; i + 1 < frameLen; i += 2) _mem[uint16_t(vp + (i - 6)/2)] = (frame[i] << 8) | frame[i+1];
+                answer.data = {0x5A, 0xA5, 0x03, 0x82, 0x4F, 0x4B};
+            }
+            else if (frame[3] == 0x83)
+            {
+                const uint8_t words = frame[6];
+                answer.data = {0x5A, 0xA5, uint8_t(4 + words*2), 0x83, frame[4], frame[5], words};
+                for (uint8_t i = 0; i < words; i++)
+                {
+                    answer.data.push_back(highByte(_mem[uint16_t(vp + i)]));
+                    answer.data.push_back(lowByte(_mem[uint16_t(vp + i)]));
+                }
+            }
+            push(answer.atUs, answer.data);
+            if (_frameNum % UPLOAD_EVERY == 0) upload(atUs);
+        }
+        return len;
+    }
+
+    size_t available() override
+    {
+        receive();
+        return _rx.size();
+    }
+
+    size_t read(uint8_t *data, const size_t &len) override
+    {
+        receive();
+        const size_t count = std::min(len, _rx.size());
+        memcpy(data, _rx.data(), count);
+        _rx.erase(_rx.begin(), _rx.begin() + count);
+        return count;
+    }
+
+    void flushInput() override
+    {
+        receive();
+        _rx.clear();
+    }
+
+    bool waitRx(const uint32_t &timeoutMs) override
+    {
+        const uint32_t startMs = millis();
+        while (available() == 0)
+        {
+            if (millis() - startMs >= timeoutMs) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        return true;
+    }
+};
+
+// Trace file for drain()
+class FilePrint : public Print
+{
+private:
+    FILE *_file;
+
+public:
+    explicit FilePrint(FILE *file) : _file(file) {}
+
+    size_t write(uint8_t c) override
+    {
+        return fwrite(&c, 1, 1, _file);
+    }
+
+    size_t write(const uint8_t *data, size_t len) override
+    {
+        return fwrite(data, 1, len, _file);
+    }
+};
+
+static ScriptPanel panel;
+static DwinTrace trace;
+static unsigned long uploads = 0;
+
+static void touchUpload(DWIN2 &, const uint16_t *, const uint8_t &)
+{
+    uploads++;
+}
+
+int main()
+{
+    FILE *traceFile = fopen("trace.bin", "wb");
+    if (traceFile == nullptr)
+    {
+        Serial.printf("trace.bin: cannot open\n");
+        return 1;
+    }
+    FilePrint traceOut(traceFile);
+
+    DWIN2::setTransport(HW_SERIAL_NUM, &panel);
+    DWIN2 dwc;
+    dwc.begin(0x5000, 0x1000);
+    dwc.setUiType(INT);
+    dwc.setTrace(&trace);
+    // Object of the touch VP: its handler counts the uploads
+    DWIN2 touch;
+    touch.begin(0x5000, UPLOAD_VP);
+    touch.setUploadHandler(touchUpload);
+
+    uint16_t block[40];
+    uint16_t readBack[40];
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        // Pipelined writes of different sizes, a system VP write and a read end the groups
+        for (int i = 0; i < 40; i++) block[i] = r + i;
+        for (int i = 0; i < 1 + r % 6; i++) dwc.writeBlock(0x1000 + i*40, block, 1 + (r + i) % 40);
+        if (r % 5 == 0) dwc.setPage(r % 3);
+        dwc.sendData(r);
+        if (r % 3 == 0) dwc.readBlock(0x1000, readBack, 1 + r % 40);
+        dwc.flush();
+        dwc.serviceUploads();
+        trace.drain(traceOut);
+    }
+    dwc.flush();
+    // The last split uploads
+    delay(2*UPLOAD_SPLIT_US/1000);
+    dwc.serviceUploads();
+    while (trace.available() > 0) trace.drain(traceOut);
+    fclose(traceFile);
+
+    const dwinstat_t stat = dwc.getStat();
+    FILE *expect = fopen("expect.txt", "w");
+    if (expect == nullptr) return 1;
+    fprintf(expect, "port %d\nsent %lu\nlost %lu\nuploads %lu\n", HW_SERIAL_NUM, (unsigned long)stat.doneFrames,
+            (unsigned long)stat.lostFrames, uploads);
+    fclose(expect);
+    Serial.printf("%d rounds: %lu frames, %lu lost, %lu uploads, trace %lu bytes, %lu bytes not recorded\n", ROUNDS,
+                  (unsigned long)stat.doneFrames, (unsigned long)stat.lostFrames, uploads,
+                  (unsigned long)trace.getRecordedBytes(), (unsigned long)trace.getLostBytes());
+    return trace.getLostBytes() == 0 ? 0 : 1;
+}
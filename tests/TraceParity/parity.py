@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+#***************************************************
+#* Trace replay parity test for DWIN2 library      *
+#* Copyright (C) 2024 Pavel Pervushkin.            *
+#* Released under the MIT license.                 *
+#***************************************************
+"""Replay the trace written by main.cpp and compare the counts with the bus.
+
+Usage:
+    python3 parity.py trace.bin expect.txt
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "tools"))
+import dwin_trace  # noqa: E402
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    expect = {}
+    with open(sys.argv[2]) as f:
+        for line in f:
+            key, value = line.split()
+            expect[key] = int(value)
+
+    rp = dwin_trace.Replay(expect["port"], None, dwin_trace.RX_TIMEOUT_MS, 0)
+    for rec in dwin_trace.read_trace(sys.argv[1]):
+        if rec.port != expect["port"]:
+            continue
+        if rec.kind == "tx":
+            rp.tx(rec)
+        elif rec.kind == "rx":
+            rp.rx(rec)
+        else:
+            rp.gap(rec)
+    rp.finish()
+
+    replayed = {"sent": rp.frames_sent, "lost": rp.lost_frames, "uploads": rp.uploads}
+    failed = False
+    for key in sorted(replayed):
+        ok = replayed[key] == expect[key]
+        failed = failed or not ok
+        print("%-6s bus %6d  replay %6d  %s" % (key, expect[key], replayed[key], "ok" if ok else "DIFF"))
+    if rp.gaps:
+        print("trace has %d gaps" % rp.gaps)
+        failed = True
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
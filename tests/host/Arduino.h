@@ -0,0 +1,117 @@
+//***************************************************
+//* Host Arduino layer for the DWIN2 library tests  *
+//* Copyright (C) 2024 Pavel Pervushkin.            *
+//* Released under the MIT license.                 *
+//***************************************************
+
+// The part of the Arduino API used by the library in the -DDWIN_LINUX build
+// (String, Print, Stream, Serial, millis(), micros(), delay(), highByte(),
+// lowByte()), on the C++ standard library. Serial prints to stdout.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+#define IRAM_ATTR
+
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+
+//***********************************************************************************************************************
+//************* String class ********************************************************************************************
+//***********************************************************************************************************************
+class String
+{
+private:
+    std::string _s;
+
+public:
+    String() {}
+    String(const char *s) : _s(s != nullptr ? s : "") {}
+    String(const int &value) : _s(std::to_string(value)) {}
+    String(const unsigned &value) : _s(std::to_string(value)) {}
+    String(const double &value, const int &decimals = 2)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        _s = buf;
+    }
+
+    const char *c_str() const { return _s.c_str(); }
+    size_t length() const { return _s.size(); }
+    void reserve(const size_t &size) { _s.reserve(size); }
+    bool concat(const char &c) { _s += c; return true; }
+    bool concat(const String &s) { _s += s._s; return true; }
+    String substring(const unsigned &from, const unsigned &to) const { String r; r._s = _s.substr(from, to - from); return r; }
+    String substring(const unsigned &from) const { String r; r._s = _s.substr(from); return r; }
+    long toInt() const { return atol(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+    void trim() {}
+
+    char operator[](const unsigned &i) const { return _s[i]; }
+    String &operator+=(const String &s) { _s += s._s; return *this; }
+    String &operator+=(const char *s) { _s += s; return *this; }
+    String &operator+=(const char &c) { _s += c; return *this; }
+    bool operator==(const String &s) const { return _s == s._s; }
+    bool operator!=(const String &s) const { return _s != s._s; }
+    friend String operator+(const String &a, const String &b) { String r(a); r._s += b._s; return r; }
+    friend String operator+(const String &a, const char *b) { String r(a); r._s += b; return r; }
+    friend String operator+(const char *a, const String &b) { String r(a); r._s += b._s; return r; }
+};
+
+
+//***********************************************************************************************************************
+//************* Print and Stream classes ********************************************************************************
+//***********************************************************************************************************************
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+    virtual size_t write(const uint8_t *data, size_t len) { return fwrite(data, 1, len, stdout); }
+
+    // Formatted into a buffer on the stack, longer output is cut
+    __attribute__((format(printf, 2, 3))) size_t printf(const char *format, ...)
+    {
+        char buf[512];
+        va_list args;
+        va_start(args, format);
+        const int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len <= 0) return 0;
+        return write(reinterpret_cast<const uint8_t *>(buf), std::min<size_t>(len, sizeof(buf) - 1));
+    }
+    size_t print(const char *s) { return write(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t println(const char *s) { return print(s) + print("\n"); }
+    size_t println(const String &s) { return println(s.c_str()); }
+    size_t println() { return print("\n"); }
+};
+
+// Serial of the host: output to stdout, no input
+class Stream : public Print
+{
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern Stream Serial;
+
+#endif
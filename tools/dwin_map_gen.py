@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+#***************************************************
+#* Typed VP/SP map generator for DWIN2 library     *
+#* Copyright (C) 2024 Pavel Pervushkin.            *
+#* Released under the MIT license.                 *
+#***************************************************
+"""Generate a C++ header with the element descriptors of a DGUS project.
+
+Reads the display configuration (14ShowFile.bin) of the DWIN_SET folder and
+emits DwinVar<> types and a dwinelem_t array with VP, SP, type, text length
+and page of every display variable supported by DWIN2.
+
+Usage:
+    python3 tools/dwin_map_gen.py DWIN_Display_Interface/DWIN_SET -o DwinMap.h
+    python3 tools/dwin_map_gen.py DWIN_SET --names names.txt -o DwinMap.h
+
+names.txt gives readable names, one "0x1000 Speed" per line.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SHOW_FILE = "14ShowFile.bin"
+PAGE_TABLE = 0x10
+PAGE_TABLE_END = 0x4000
+RECORD_SIZE = 0x20
+
+# Display variable codes
+VAR_ICON = 0x00
+VAR_DATA = 0x10
+VAR_TEXT = 0x11
+
+# Data variable type -> DWIN2 uitype_t
+DATA_TYPES = {
+    0x00: "INT",        # int16
+    0x01: "LONG",       # int32
+    0x02: "INT",        # VP high byte
+    0x03: "INT",        # VP low byte
+    0x05: "INT",        # uint16
+    0x06: "LONG",       # uint32
+    0x08: "DOUBLE",     # 8 byte float
+}
+
+# Text encoding 0x05 is UNICODE
+TEXT_UNICODE = 0x05
+
+
+def be16(data, pos):
+    return struct.unpack_from(">H", data, pos)[0]
+
+
+def parse_show_file(path):
+    """Return element dicts: vp, sp, type, textLen, page, or skip reason."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data[1:7] == b"DGUS_2":
+        sys.exit("%s: not a DGUS II show file" % path)
+
+    elements = []
+    skipped = []
+    page = 0
+    for pos in range(PAGE_TABLE, min(PAGE_TABLE_END, len(data)), 4):
+        count = data[pos]
+        offset = be16(data, pos + 2)
+        for i in range(count):
+            rec = offset + i * RECORD_SIZE
+            if rec + RECORD_SIZE > len(data) or data[rec] != 0x5A:
+                break
+            code = data[rec + 1]
+            sp = be16(data, rec + 2)
+            vp = be16(data, rec + 6)
+            elem = {"vp": vp, "sp": sp, "page": page, "textLen": 0}
+            if code == VAR_ICON:
+                elem["type"] = "ICON"
+            elif code == VAR_DATA:
+                var_type = data[rec + 0x13]
+                if var_type not in DATA_TYPES:
+                    skipped.append((vp, page, "data variable type 0x%02X" % var_type))
+                    continue
+                elem["type"] = DATA_TYPES[var_type]
+            elif code == VAR_TEXT:
+                encoding = data[rec + 0x1C] & 0x7F
+                elem["type"] = "UTF" if encoding == TEXT_UNICODE else "ASCII"
+                elem["textLen"] = be16(data, rec + 0x16)
+            else:
+                skipped.append((vp, page, "display variable 0x%02X" % code))
+                continue
+            elements.append(elem)
+        page += 1
+    return elements, skipped
+
+
+def read_names(path):
+    names = {}
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 2 and not line.startswith("#"):
+                names[int(parts[0], 0)] = parts[1]
+    return names
+
+
+def element_name(elem, names, shared=()):
+    """Type name of the element, VPs shown on several pages get the page suffix."""
+    if elem["vp"] in names:
+        name = names[elem["vp"]]
+    else:
+        prefix = {"INT": "Int", "LONG": "Long", "DOUBLE": "Dbl", "UTF": "Utf", "ASCII": "Ascii", "ICON": "Icon"}[elem["type"]]
+        name = "%s_%04X" % (prefix, elem["vp"])
+    if elem["vp"] in shared:
+        name += "_P%d" % elem["page"]
+    return name
+
+
+def vp_words(elem):
+    """Number of VP words used by the element."""
+    if elem["type"] == "DOUBLE":
+        return 4
+    if elem["type"] == "LONG":
+        return 2
+    if elem["type"] in ("UTF", "ASCII"):
+        return max(1, (elem["textLen"] + 1) // 2)
+    return 1
+
+
+def generate(elements, skipped, names, source):
+    # The same VP on several pages (status bar, clock...) gives one element per page,
+    # a VP shown twice on one page is kept once
+    seen = set()
+    unique = []
+    for elem in elements:
+        if (elem["vp"], elem["page"]) not in seen:
+            seen.add((elem["vp"], elem["page"]))
+            unique.append(elem)
+    elements = unique
+    by_vp = {}
+    for elem in elements:
+        by_vp.setdefault(elem["vp"], []).append(elem)
+    shared = set(vp for vp, elems in by_vp.items() if len(elems) > 1)
+
+    out = []
+    out.append("// Generated by tools/dwin_map_gen.py from %s, do not edit" % source)
+    out.append("")
+    out.append("#ifndef DwinMap_h")
+    out.append("#define DwinMap_h")
+    out.append("")
+    out.append("#include <Dwin2.h>")
+    out.append("")
+    out.append("namespace DwinMap")
+    out.append("{")
+    for elem in elements:
+        out.append("    // Page %d, %s, VP 0x%04X" % (elem["page"], elem["type"], elem["vp"]))
+        out.append("    typedef DwinVar<%s, 0x%04X, 0x%04X, %d, %d> %s;" % (
+            elem["type"], elem["vp"], elem["sp"], elem["textLen"], elem["page"], element_name(elem, names, shared)))
+    for vp, page, reason in skipped:
+        out.append("    // Page %d, VP 0x%04X skipped: %s is not supported" % (page, vp, reason))
+    out.append("")
+    out.append("    // All elements, to set up DWIN2 objects in a loop")
+    out.append("    constexpr dwinelem_t ELEMENTS[] = {")
+    for elem in elements:
+        out.append("        %s::elem()," % element_name(elem, names, shared))
+    out.append("    };")
+    out.append("    constexpr size_t ELEMENTS_QTY = %d;" % len(elements))
+    out.append("}")
+    out.append("")
+
+    # Overlapping VP ranges fail at compile time. Text fields are often longer
+    # than the space up to the next VP while the texts are short, so for them
+    # only a warning is written. Elements of one VP are checked once, by the
+    # widest of them
+    out.append("// Address checks")
+    widest = []
+    for vp in sorted(by_vp):
+        elems = by_vp[vp]
+        if len(set(e["type"] for e in elems)) > 1:
+            warning = "VP 0x%04X has different types on pages %s" % (
+                vp, ", ".join("%d %s" % (e["page"], e["type"]) for e in elems))
+            print("warning: " + warning)
+            out.append("// Warning: " + warning)
+        widest.append(max(elems, key=vp_words))
+    for a, b in zip(widest, widest[1:]):
+        if a["type"] in ("UTF", "ASCII") and a["vp"] < b["vp"] < a["vp"] + vp_words(a):
+            warning = "%s text of %d bytes overlaps %s" % (
+                element_name(a, names, shared), a["textLen"], element_name(b, names, shared))
+            print("warning: " + warning)
+            out.append("// Warning: " + warning)
+            continue
+        out.append("static_assert(DwinMap::%s::vp + %d <= DwinMap::%s::vp, \"VP of %s overlaps %s\");" % (
+            element_name(a, names, shared), vp_words(a), element_name(b, names, shared),
+            element_name(a, names, shared), element_name(b, names, shared)))
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dwin_set", help="DWIN_SET folder of the DGUS project")
+    parser.add_argument("-o", "--output", default="DwinMap.h", help="header to write")
+    parser.add_argument("--names", help="file with '0xVP Name' lines")
+    args = parser.parse_args()
+
+    elements, skipped = parse_show_file(os.path.join(args.dwin_set, SHOW_FILE))
+    names = read_names(args.names) if args.names else {}
+    header = generate(elements, skipped, names, os.path.basename(os.path.normpath(args.dwin_set)))
+    with open(args.output, "w") as f:
+        f.write(header)
+    print("%s: %d elements, %d skipped" % (args.output, len(elements), len(skipped)))
+
+
+if __name__ == "__main__":
+    main()
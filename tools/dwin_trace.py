@@ -0,0 +1,465 @@
+#!/usr/bin/env python3
+#***************************************************
+#* UART trace replay for DWIN2 library             *
+#* Copyright (C) 2024 Pavel Pervushkin.            *
+#* Released under the MIT license.                 *
+#***************************************************
+"""Replay a UART trace recorded by DwinTrace on the PC.
+
+The trace is replayed as fast as it can be read: the groups of frames sent
+by the bus and the display answers are split and counted the same way as
+DWIN2::sendGroup() and DWIN2::countAnswers() do, so each group gets its
+answer latency, the auto-upload frames (touch) are told from the answers,
+and the groups the bus gave up on (--timeout-ms plus the time of the
+group and its answers on the wire at --baud; the bus adapts its timeouts
+to the round-trip time, see DWIN2::getStat()) are counted as lost frames.
+With --panel the frames are also sent to a simulated display (VP memory,
+page, restart), and its answers are compared with the recorded ones: a
+frozen or reset display shows up as the first diffs.
+
+Usage:
+    python3 tools/dwin_trace.py info trace.bin
+    python3 tools/dwin_trace.py dump trace.bin --from 10800 --count 50
+    python3 tools/dwin_trace.py replay trace.bin --panel --max-diffs 20
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+MAGIC = b"DWTR"
+VERSION = 1
+TAG_RX = 0x80
+TAG_GAP = 0x40
+TAG_PORT = 0x07
+
+# Dwin2.h
+RX_TIMEOUT_MS = 30
+PAGE_VP = 0x0084
+PAGE_READ_VP = 0x0014
+RESTART_VP = 0x0004
+CMD_WRITE = 0x82
+CMD_READ = 0x83
+ACK = bytes([0x5A, 0xA5, 0x03, CMD_WRITE, 0x4F, 0x4B])
+# DwinTransport.h
+BAUDRATE = 115200
+
+
+class Record(object):
+    __slots__ = ("us", "port", "kind", "data", "lost")
+
+    def __init__(self, us, port, kind, data=b"", lost=0):
+        self.us = us
+        self.port = port
+        self.kind = kind
+        self.data = data
+        self.lost = lost
+
+
+def read_varint(buf, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(buf):
+            raise ValueError("truncated varint")
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def read_trace(path):
+    """Return the records with absolute time in us, a truncated last record is dropped."""
+    with open(path, "rb") as f:
+        buf = f.read()
+    if buf[0:4] != MAGIC:
+        sys.exit("%s: not a DwinTrace file" % path)
+    if buf[4] != VERSION:
+        sys.exit("%s: trace version %d is not supported" % (path, buf[4]))
+    records = []
+    pos = 8
+    us = 0
+    while pos < len(buf):
+        try:
+            tag = buf[pos]
+            dt, pos2 = read_varint(buf, pos + 1)
+            length, pos2 = read_varint(buf, pos2)
+        except ValueError:
+            break
+        us += dt
+        port = tag & TAG_PORT
+        if tag & TAG_GAP:
+            records.append(Record(us, port, "gap", lost=length))
+            pos = pos2
+            continue
+        if pos2 + length > len(buf):
+            break
+        kind = "rx" if tag & TAG_RX else "tx"
+        records.append(Record(us, port, kind, bytes(buf[pos2:pos2 + length])))
+        pos = pos2 + length
+    return records
+
+
+def split_frames(data):
+    """Complete 5A A5 frames of the byte stream and the number of bytes skipped, as countAnswers()."""
+    frames = []
+    pos = 0
+    skipped = 0
+    while pos + 3 <= len(data):
+        if data[pos] != 0x5A or data[pos + 1] != 0xA5:
+            pos += 1
+            skipped += 1
+            continue
+        end = pos + data[pos + 2] + 3
+        if end > len(data):
+            break
+        frames.append(bytes(data[pos:end]))
+        pos = end
+    return frames, skipped, data[pos:]
+
+
+def fmt_time(us):
+    s, us = divmod(us, 1000000)
+    h, s = divmod(s, 3600)
+    m, s = divmod(s, 60)
+    return "%d:%02d:%02d.%03d" % (h, m, s, us // 1000)
+
+
+def hex_bytes(data, limit=48):
+    text = " ".join("%02X" % b for b in data[:limit])
+    return text + (" ..." if len(data) > limit else "")
+
+
+def is_upload(frame, frames):
+    """Read frame not answering a read of the group (same VP and size): auto-upload, as DWIN2::isUpload()."""
+    if len(frame) < 7 or frame[3] != CMD_READ:
+        return False
+    return not any(len(f) >= 7 and f[3] == CMD_READ and f[4:7] == frame[4:7] for f in frames)
+
+
+def wire_us(nbytes, baud):
+    """Time of the bytes on the wire: start, 8 data bits and stop, as DWIN2::wireUs()."""
+    return nbytes * 10 * 1000000 // baud if baud else 0
+
+
+def answer_bytes(frames):
+    """Bytes of the answers expected to the frames: acks, or the VP data of the reads."""
+    return sum(7 + 2 * f[6] if f[3] == CMD_READ and len(f) >= 7 else len(ACK) for f in frames)
+
+
+def group_class(frames):
+    """write - all frames are VP writes, read - the group ends with a read, other."""
+    cmds = [f[3] for f in frames if len(f) > 3]
+    if cmds and all(c == CMD_WRITE for c in cmds):
+        return "write"
+    if cmds and cmds[-1] == CMD_READ:
+        return "read"
+    return "other"
+
+
+class SimPanel(object):
+    """VP memory of the display with the page and restart system variables."""
+
+    def __init__(self, boot_ms):
+        self.boot_us = boot_ms * 1000
+        self.mem = [0] * 0x10000
+        self.ready_us = 0
+        self.resets = 0
+
+    def answer(self, frame, us):
+        """Answer frame to the command, None if the display does not answer."""
+        if us < self.ready_us or len(frame) < 6:
+            return None
+        cmd = frame[3]
+        vp = struct.unpack_from(">H", frame, 4)[0]
+        if cmd == CMD_WRITE:
+            words = [struct.unpack_from(">H", frame, i)[0] for i in range(6, len(frame) - 1, 2)]
+            if vp == RESTART_VP and words[:2] == [0x55AA, 0x5AA5]:
+                # VP memory is cleared, no answer until booted
+                self.mem = [0] * 0x10000
+                self.ready_us = us + self.boot_us
+                self.resets += 1
+                return None
+            for i, w in enumerate(words):
+                self.mem[(vp + i) & 0xFFFF] = w
+            if vp == PAGE_VP and len(words) >= 2 and words[0] == 0x5A01:
+                self.mem[PAGE_READ_VP] = words[1]
+            return ACK
+        if cmd == CMD_READ and len(frame) >= 7:
+            count = frame[6]
+            data = b"".join(struct.pack(">H", self.mem[(vp + i) & 0xFFFF]) for i in range(count))
+            return bytes([0x5A, 0xA5, 4 + len(data), CMD_READ]) + frame[4:7] + data
+        return None
+
+    def adopt(self, frame):
+        """Take the values of a recorded read answer: the user changed them on the touch screen."""
+        if len(frame) >= 7 and frame[3] == CMD_READ:
+            vp = struct.unpack_from(">H", frame, 4)[0]
+            for i in range(min(frame[6], (len(frame) - 7) // 2)):
+                self.mem[(vp + i) & 0xFFFF] = struct.unpack_from(">H", frame, 7 + 2 * i)[0]
+
+
+class Replay(object):
+    """Groups of one port: each TX record is one group passed to the UART by sendGroup()."""
+
+    def __init__(self, port, panel, timeout_ms, max_diffs, baud=BAUDRATE):
+        self.port = port
+        self.panel = panel
+        self.timeout_us = timeout_ms * 1000
+        self.baud = baud
+        self.max_diffs = max_diffs
+        self.group = None
+        self.groups = 0
+        self.frames_sent = 0
+        self.frames_answered = 0
+        self.lost_frames = 0
+        self.timeouts = 0
+        self.latency = {"write": [], "read": [], "other": []}
+        self.tx_bytes = 0
+        self.rx_bytes = 0
+        self.skipped_bytes = 0
+        self.unexpected = 0
+        self.uploads = 0
+        # Bytes after the last answer of a group: the start of an auto-upload, carried to the next reads
+        self.idle_rx = b""
+        self.gaps = 0
+        self.gap_bytes = 0
+        self.diffs = []
+        self.diff_count = {}
+
+    def diff(self, us, kind, text):
+        self.diff_count[kind] = self.diff_count.get(kind, 0) + 1
+        if len(self.diffs) < self.max_diffs:
+            self.diffs.append((us, kind, text))
+
+    def tx(self, rec):
+        self.finish()
+        frames, skipped, _ = split_frames(rec.data)
+        self.tx_bytes += len(rec.data)
+        self.frames_sent += len(frames)
+        expected = None
+        if self.panel:
+            expected = [a for a in (self.panel.answer(f, rec.us) for f in frames) if a is not None]
+        # The bus adds the time on the wire in whole ms to the timeout
+        wire_ms = (wire_us(len(rec.data) + answer_bytes(frames), self.baud) + 999) // 1000
+        self.group = {"us": rec.us, "frames": frames, "rx": self.idle_rx, "answers": [], "done_us": None,
+                      "last_us": rec.us, "expected": expected, "timeout_us": self.timeout_us + wire_ms * 1000}
+        self.idle_rx = b""
+
+    def idle(self, data):
+        """Bytes while no group waits: auto-uploads, or answers after the group was finished."""
+        frames, skipped, self.idle_rx = split_frames(self.idle_rx + data)
+        self.skipped_bytes += skipped
+        for f in frames:
+            if len(f) >= 7 and f[3] == CMD_READ:
+                self.uploads += 1
+            else:
+                # Late or not asked for
+                self.unexpected += len(f)
+
+    def rx(self, rec):
+        self.rx_bytes += len(rec.data)
+        g = self.group
+        if g is None or g["done_us"] is not None:
+            self.idle(rec.data)
+            return
+        if rec.us - g["last_us"] > g["timeout_us"]:
+            # The bus gave up on the group before these bytes
+            self.finish()
+            self.idle(rec.data)
+            return
+        g["rx"] += rec.data
+        g["last_us"] = rec.us
+        frames, skipped, rest = split_frames(g["rx"])
+        if frames or skipped:
+            self.skipped_bytes += skipped
+            g["rx"] = rest
+        for f in frames:
+            if is_upload(f, g["frames"]):
+                self.uploads += 1
+            elif len(g["answers"]) < len(g["frames"]):
+                g["answers"].append(f)
+            else:
+                # Frames after the last answer are read by the bus as idle bytes
+                self.idle(f)
+        if len(g["answers"]) >= len(g["frames"]) and g["done_us"] is None:
+            g["done_us"] = rec.us
+            # The bus keeps the rest of the read for the next frames
+            self.idle_rx = g["rx"]
+            g["rx"] = b""
+
+    def gap(self, rec):
+        self.gaps += 1
+        self.gap_bytes += rec.lost
+        self.diff(rec.us, "gap", "%d bytes not recorded, ring full" % rec.lost)
+
+    def finish(self):
+        g = self.group
+        if g is None:
+            return
+        self.group = None
+        self.groups += 1
+        answered = min(len(g["answers"]), len(g["frames"]))
+        self.frames_answered += answered
+        cls = group_class(g["frames"])
+        if g["done_us"] is not None:
+            self.latency[cls].append(g["done_us"] - g["us"])
+        else:
+            self.timeouts += 1
+            self.lost_frames += len(g["frames"]) - answered
+        if g["expected"] is not None:
+            self.compare(g)
+
+    def compare(self, g):
+        expected = g["expected"]
+        recorded = g["answers"]
+        for i in range(max(len(expected), len(recorded))):
+            exp = expected[i] if i < len(expected) else None
+            rec = recorded[i] if i < len(recorded) else None
+            if exp == rec:
+                continue
+            if rec is None:
+                self.diff(g["us"], "no answer", "TX %s expected %s" % (hex_bytes(g["frames"][-1]), hex_bytes(exp)))
+            elif exp is None:
+                self.diff(g["us"], "extra answer", "RX %s" % hex_bytes(rec))
+            elif exp[:7] == rec[:7] and rec[3] == CMD_READ:
+                # Same read, other values: changed on the display side
+                self.diff(g["us"], "value", "read %s recorded %s" % (hex_bytes(exp[7:]), hex_bytes(rec[7:])))
+                self.panel.adopt(rec)
+            else:
+                self.diff(g["us"], "answer", "expected %s recorded %s" % (hex_bytes(exp), hex_bytes(rec)))
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def port_records(records, port):
+    return [r for r in records if port is None or r.port == port]
+
+
+def cmd_info(args):
+    records = read_trace(args.trace)
+    if not records:
+        print("%s: no records" % args.trace)
+        return
+    duration = records[-1].us - records[0].us
+    print("%s: %d records, %s" % (args.trace, len(records), fmt_time(duration)))
+    for port in sorted(set(r.port for r in records)):
+        recs = port_records(records, port)
+        tx = sum(len(r.data) for r in recs if r.kind == "tx")
+        rx = sum(len(r.data) for r in recs if r.kind == "rx")
+        lost = sum(r.lost for r in recs if r.kind == "gap")
+        print("  port %d: TX %d bytes in %d groups, RX %d bytes, %d bytes not recorded" % (
+            port, tx, sum(1 for r in recs if r.kind == "tx"), rx, lost))
+
+
+def cmd_dump(args):
+    records = port_records(read_trace(args.trace), args.port)
+    start = records[0].us if records else 0
+    shown = 0
+    for r in records:
+        if (r.us - start) < args.start * 1000000:
+            continue
+        if shown >= args.count:
+            break
+        shown += 1
+        if r.kind == "gap":
+            print("%s  %d  GAP %d bytes" % (fmt_time(r.us - start), r.port, r.lost))
+        else:
+            print("%s  %d  %s %s" % (fmt_time(r.us - start), r.port, r.kind.upper(), hex_bytes(r.data, 64)))
+
+
+def cmd_replay(args):
+    records = read_trace(args.trace)
+    if not records:
+        sys.exit("%s: no records" % args.trace)
+    wall = time.time()
+    ports = {}
+    start = records[0].us
+    for r in records:
+        if args.port is not None and r.port != args.port:
+            continue
+        rp = ports.get(r.port)
+        if rp is None:
+            panel = SimPanel(args.boot_ms) if args.panel else None
+            rp = ports[r.port] = Replay(r.port, panel, args.timeout_ms, args.max_diffs, args.baud)
+        if r.kind == "tx":
+            rp.tx(r)
+        elif r.kind == "rx":
+            rp.rx(r)
+        else:
+            rp.gap(r)
+    for rp in ports.values():
+        rp.finish()
+    wall = time.time() - wall
+    duration = max(1, records[-1].us - start)
+
+    for port in sorted(ports):
+        rp = ports[port]
+        secs = duration / 1e6
+        print("Port %d" % port)
+        print("  throughput  TX %.0f B/s, RX %.0f B/s, %.1f frames/s, %d groups" % (
+            rp.tx_bytes / secs, rp.rx_bytes / secs, rp.frames_sent / secs, rp.groups))
+        print("  frames      %d sent, %d answered, %d lost in %d timed out groups" % (
+            rp.frames_sent, rp.frames_answered, rp.lost_frames, rp.timeouts))
+        if rp.uploads:
+            print("  uploads     %d auto-upload frames" % rp.uploads)
+        if rp.unexpected or rp.skipped_bytes:
+            print("  rx          %d bytes after the group timeout, %d bytes out of frames" % (
+                rp.unexpected, rp.skipped_bytes))
+        if rp.gaps:
+            print("  trace       %d gaps, %d bytes not recorded" % (rp.gaps, rp.gap_bytes))
+        for cls in ("write", "read", "other"):
+            lat = rp.latency[cls]
+            if lat:
+                print("  latency %-5s n=%d  p50 %.2f ms  p99 %.2f ms  max %.2f ms" % (
+                    cls, len(lat), percentile(lat, 50) / 1000.0, percentile(lat, 99) / 1000.0, max(lat) / 1000.0))
+        if rp.panel:
+            total = sum(rp.diff_count.values())
+            summary = ", ".join("%d %s" % (n, k) for k, n in sorted(rp.diff_count.items()))
+            print("  panel       %d diffs%s, %d restarts" % (total, " (%s)" % summary if summary else "", rp.panel.resets))
+        for us, kind, text in rp.diffs:
+            print("    %s  %-12s %s" % (fmt_time(us - start), kind, text))
+    print("Replayed %s of trace in %.2f s (x%.0f real time)" % (
+        fmt_time(duration), wall, duration / 1e6 / max(wall, 1e-6)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    p = sub.add_parser("info", help="records, duration and bytes per port")
+    p.add_argument("trace")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("dump", help="print the records")
+    p.add_argument("trace")
+    p.add_argument("--port", type=int, help="serial port, all by default")
+    p.add_argument("--from", dest="start", type=float, default=0, help="start time, s from the first record")
+    p.add_argument("--count", type=int, default=100, help="number of records")
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser("replay", help="throughput, latency and diffs")
+    p.add_argument("trace")
+    p.add_argument("--port", type=int, help="serial port, all by default")
+    p.add_argument("--panel", action="store_true", help="compare the answers with a simulated display")
+    p.add_argument("--boot-ms", type=int, default=1000, help="simulated display boot time after restart")
+    p.add_argument("--timeout-ms", type=int, default=RX_TIMEOUT_MS, help="answer timeout of the bus")
+    p.add_argument("--baud", type=int, default=BAUDRATE, help="line speed, for the time on the wire")
+    p.add_argument("--max-diffs", type=int, default=20, help="diffs to print")
+    p.set_defaults(func=cmd_replay)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()